@@ -0,0 +1,128 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+/*
+Microbenchmark of `b2::core::concurrent_hash` lookups from multiple threads. It
+compares the sharded table to a table behind a single lock, i.e. the previous
+implementation, with the mostly hit lookups of the file info cache.
+
+Build from the root directory with `b2 bench-concurrent-hash`, or from the
+engine directory with:
+
+	g++ -std=c++11 -O2 -pthread -I. -o bench_concurrent_hash \
+		bench/concurrent_hash.cpp constants.cpp debug.cpp hash.cpp output.cpp \
+		timestamp.cpp value.cpp
+
+And run with:
+
+	bench_concurrent_hash [keys] [lookups per thread] [max threads]
+*/
+
+#include "jam.h"
+#include "hash.h"
+
+#include "filesys.h"
+#include "object.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Engine globals and functions the used sources need.
+global_config globs;
+int file_time(OBJECT * const, timestamp * const) { return -1; }
+
+namespace {
+
+struct item
+{
+	OBJECT * name;
+	int value;
+	item(OBJECT * n)
+		: name(n)
+		, value(0)
+	{}
+};
+
+// A hash table behind a single lock.
+struct single_lock_hash
+{
+	single_lock_hash(const char * name) { table = hashinit(sizeof(item), name); }
+	~single_lock_hash() { hash_free(table); }
+
+	std::pair<item *, bool> get(OBJECT * key, item v)
+	{
+		int found = 0;
+		std::lock_guard<std::mutex> guard(mutex);
+		item * val = reinterpret_cast<item *>(hash_insert(table, key, &found));
+		if (found == 0) b2::jam::ctor_ptr<item>(val, v);
+		return std::make_pair(val, found != 0);
+	}
+
+	std::mutex mutex;
+	hash * table = nullptr;
+};
+
+template <typename Table>
+double run(const std::vector<OBJECT *> & keys, std::size_t lookups,
+	unsigned threads)
+{
+	Table table("bench");
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t]() {
+			// Each thread goes through the keys in a different order.
+			std::size_t k = t * 7919;
+			for (std::size_t i = 0; i < lookups; ++i)
+			{
+				k = (k + 104729) % keys.size();
+				table.get(keys[k], item(keys[k])).first->value += 1;
+			}
+		});
+	}
+	for (auto & w : workers) w.join();
+	std::chrono::duration<double> elapsed
+		= std::chrono::steady_clock::now() - start;
+	return double(lookups) * threads / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+	std::size_t key_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+	std::size_t lookups
+		= argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+	unsigned max_threads = argc > 3
+		? unsigned(std::strtoul(argv[3], nullptr, 10))
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<OBJECT *> keys;
+	for (std::size_t i = 0; i < key_count; ++i)
+		keys.push_back(object_new(
+			("/src/dir" + std::to_string(i % 97) + "/file" + std::to_string(i)
+				+ ".cpp")
+				.c_str()));
+
+	std::printf("%8s %16s %16s %8s\n", "threads", "single lock/s",
+		"sharded/s", "speedup");
+	for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+	{
+		double single = run<single_lock_hash>(keys, lookups, threads);
+		double sharded
+			= run<b2::core::concurrent_hash<item>>(keys, lookups, threads);
+		std::printf("%8u %16.0f %16.0f %8.2f\n", threads, single, sharded,
+			sharded / single);
+	}
+	return 0;
+}
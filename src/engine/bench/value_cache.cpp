@@ -0,0 +1,172 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+/*
+Microbenchmark of interning strings with `object_new` from multiple threads. It
+compares the sharded value cache, with its word at a time hash, to a cache
+behind a single lock with the byte at a time FNV-1a hash, i.e. the previous
+implementation. Most of the strings are already interned, as when creating the
+same names over and over.
+
+Build from the root directory with `b2 bench-value-cache`, or from the engine
+directory with:
+
+	g++ -std=c++11 -O2 -pthread -I. -o bench_value_cache \
+		bench/value_cache.cpp constants.cpp debug.cpp hash.cpp output.cpp \
+		timestamp.cpp value.cpp
+
+And run with:
+
+	bench_value_cache [strings] [interns per thread] [max threads]
+*/
+
+#include "jam.h"
+
+#include "filesys.h"
+#include "object.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Engine globals and functions the used sources need.
+global_config globs;
+int file_time(OBJECT * const, timestamp * const) { return -1; }
+
+namespace {
+
+// An interned string, as the previous value cache kept them.
+struct fnv_string
+{
+	const char * str;
+	std::size_t size;
+	std::uint64_t hash64;
+
+	fnv_string(const char * s, std::size_t n)
+		: str(s)
+		, size(n)
+	{
+		hash64 = 0xcbf29ce484222325;
+		for (std::size_t i = 0; i < n; ++i)
+			hash64 = (hash64 * 0x100000001B3) ^ std::uint8_t(s[i]);
+	}
+};
+
+struct fnv_hash_f
+{
+	std::size_t operator()(const fnv_string * s) const
+	{
+		return std::size_t(s->hash64);
+	}
+};
+
+struct fnv_eq_f
+{
+	bool operator()(const fnv_string * a, const fnv_string * b) const
+	{
+		return a->hash64 == b->hash64 && a->size == b->size
+			&& std::memcmp(a->str, b->str, a->size) == 0;
+	}
+};
+
+// A string cache behind a single lock.
+struct single_lock_cache
+{
+	~single_lock_cache()
+	{
+		for (fnv_string * s : cache)
+		{
+			delete[] s->str;
+			delete s;
+		}
+	}
+
+	const void * intern(const char * str)
+	{
+		fnv_string test_val(str, std::strlen(str));
+		std::lock_guard<std::mutex> guard(mutex);
+		auto existing = cache.find(&test_val);
+		if (existing != cache.end()) return *existing;
+		char * s = new char[test_val.size + 1];
+		std::memcpy(s, str, test_val.size + 1);
+		fnv_string * result = new fnv_string(s, test_val.size);
+		cache.insert(result);
+		return result;
+	}
+
+	std::mutex mutex;
+	std::unordered_set<fnv_string *, fnv_hash_f, fnv_eq_f> cache;
+};
+
+// The engine value cache.
+struct value_cache
+{
+	~value_cache() { b2::value::done(); }
+
+	const void * intern(const char * str) { return object_new(str); }
+};
+
+template <typename Cache>
+double run(const std::vector<std::string> & strings, std::size_t interns,
+	unsigned threads)
+{
+	Cache cache;
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&, t]() {
+			// Each thread goes through the strings in a different order.
+			std::size_t k = t * 7919;
+			for (std::size_t i = 0; i < interns; ++i)
+			{
+				k = (k + 104729) % strings.size();
+				if (cache.intern(strings[k].c_str()) == nullptr) std::abort();
+			}
+		});
+	}
+	for (auto & w : workers) w.join();
+	std::chrono::duration<double> elapsed
+		= std::chrono::steady_clock::now() - start;
+	return double(interns) * threads / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+	std::size_t string_count
+		= argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+	std::size_t interns
+		= argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+	unsigned max_threads = argc > 3
+		? unsigned(std::strtoul(argv[3], nullptr, 10))
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<std::string> strings;
+	for (std::size_t i = 0; i < string_count; ++i)
+		strings.push_back("<include>/src/dir" + std::to_string(i % 97)
+			+ "/file" + std::to_string(i) + ".cpp");
+
+	std::printf("%8s %16s %16s %8s\n", "threads", "single lock/s",
+		"sharded/s", "speedup");
+	for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+	{
+		double single = run<single_lock_cache>(strings, interns, threads);
+		double sharded = run<value_cache>(strings, interns, threads);
+		std::printf("%8u %16.0f %16.0f %8.2f\n", threads, single, sharded,
+			sharded / single);
+	}
+	return 0;
+}
@@ -23,9 +23,14 @@ Distributed under the Boost Software License, Version 1.0.
 #include "value.h"
 #include "variable.h"
 
+#include "mod_action_cache.h"
 #include "mod_args.h"
 #include "mod_command_db.h"
 #include "mod_db.h"
+#include "mod_feature.h"
+#include "mod_generators.h"
+#include "mod_graph_snapshot.h"
+#include "mod_toolset.h"
 #include "mod_jam_builtin.h"
 #include "mod_jam_class.h"
 #include "mod_jam_errors.h"
@@ -33,9 +38,11 @@ Distributed under the Boost Software License, Version 1.0.
 #include "mod_path.h"
 #include "mod_regex.h"
 #include "mod_set.h"
+#include "mod_shell_cache.h"
 #include "mod_stdinfo.h"
 #include "mod_string.h"
 #include "mod_sysinfo.h"
+#include "mod_timing_db.h"
 #include "mod_version.h"
 
 #include <cstddef>
@@ -654,6 +661,7 @@ void jam_native_bind(const string_t & module_name,
 	rule->module = module;
 	rule->actions = 0;
 	rule->exported = 0;
+	rules_changed();
 	// Register the function as a native jam rule.
 	declare_native_rule(mod_cstr(module_name), rule_name.c_str(), arg_spec.spec,
 		native_rule, 0);
@@ -845,7 +853,14 @@ void bind_jam(FRAME * f)
 		.bind(sysinfo_module())
 		.bind(version_module())
 		.bind(db_module())
+		.bind(feature_module())
+		.bind(generators_module())
+		.bind(toolset_module())
 		.bind(command_db_module())
+		.bind(action_cache_module())
+		.bind(timing_db_module())
+		.bind(shell_cache_module())
+		.bind(graph_snapshot_module())
 		.bind(b2::args::args_module())
 		.bind(b2::std_info_module());
 }
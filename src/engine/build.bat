@@ -178,9 +178,13 @@ set B2_SOURCES=%B2_SOURCES% native.cpp outerr.cpp output.cpp parse.cpp pathnt.cp
 set B2_SOURCES=%B2_SOURCES% pathsys.cpp pathunix.cpp regexp.cpp rules.cpp scan.cpp search.cpp jam_strings.cpp
 set B2_SOURCES=%B2_SOURCES% startup.cpp tasks.cpp
 set B2_SOURCES=%B2_SOURCES% timestamp.cpp value.cpp variable.cpp w32_getreg.cpp
+set B2_SOURCES=%B2_SOURCES% mod_action_cache.cpp
 set B2_SOURCES=%B2_SOURCES% mod_args.cpp
 set B2_SOURCES=%B2_SOURCES% mod_command_db.cpp
 set B2_SOURCES=%B2_SOURCES% mod_db.cpp
+set B2_SOURCES=%B2_SOURCES% mod_feature.cpp
+set B2_SOURCES=%B2_SOURCES% mod_generators.cpp
+set B2_SOURCES=%B2_SOURCES% mod_graph_snapshot.cpp
 set B2_SOURCES=%B2_SOURCES% mod_jam_builtin.cpp
 set B2_SOURCES=%B2_SOURCES% mod_jam_class.cpp
 set B2_SOURCES=%B2_SOURCES% mod_jam_errors.cpp
@@ -191,10 +195,13 @@ set B2_SOURCES=%B2_SOURCES% mod_property_set.cpp
 set B2_SOURCES=%B2_SOURCES% mod_regex.cpp
 set B2_SOURCES=%B2_SOURCES% mod_sequence.cpp
 set B2_SOURCES=%B2_SOURCES% mod_set.cpp
+set B2_SOURCES=%B2_SOURCES% mod_shell_cache.cpp
 set B2_SOURCES=%B2_SOURCES% mod_stdinfo.cpp
 set B2_SOURCES=%B2_SOURCES% mod_string.cpp
 set B2_SOURCES=%B2_SOURCES% mod_summary.cpp
 set B2_SOURCES=%B2_SOURCES% mod_sysinfo.cpp
+set B2_SOURCES=%B2_SOURCES% mod_timing_db.cpp
+set B2_SOURCES=%B2_SOURCES% mod_toolset.cpp
 set B2_SOURCES=%B2_SOURCES% mod_version.cpp
 
 set B2_CXXFLAGS=%B2_CXXFLAGS% -DNDEBUG
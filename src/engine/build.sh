@@ -477,9 +477,13 @@ timestamp.cpp \
 value.cpp \
 variable.cpp \
 w32_getreg.cpp \
+mod_action_cache.cpp \
 mod_args.cpp \
 mod_command_db.cpp \
 mod_db.cpp \
+mod_feature.cpp \
+mod_generators.cpp \
+mod_graph_snapshot.cpp \
 mod_jam_builtin.cpp \
 mod_jam_class.cpp \
 mod_jam_errors.cpp \
@@ -490,10 +494,13 @@ mod_property_set.cpp \
 mod_regex.cpp \
 mod_sequence.cpp \
 mod_set.cpp \
+mod_shell_cache.cpp \
 mod_stdinfo.cpp \
 mod_string.cpp \
 mod_summary.cpp \
 mod_sysinfo.cpp \
+mod_timing_db.cpp \
+mod_toolset.cpp \
 mod_version.cpp \
  "
 
@@ -17,6 +17,8 @@
 #include "lists.h"
 #include "make.h"
 #include "md5.h"
+#include "mod_graph_snapshot.h"
+#include "mod_shell_cache.h"
 #include "native.h"
 #include "outerr.h"
 #include "parse.h"
@@ -1202,28 +1204,14 @@ LIST * builtin_rulenames( FRAME * frame, int flags )
  * supplied, returns the list of variable names in the global module.
  */
 
-/* helper function for builtin_varnames(), below. Used with hashenumerate, will
- * prepend the key of each element to the list
- */
-static void add_hash_key( void * np, void * result_ )
-{
-    LIST * * result = (LIST * *)result_;
-    *result = list_push_back( *result, object_copy( *(OBJECT * *)np ) );
-}
-
-
 LIST * builtin_varnames( FRAME * frame, int flags )
 {
     LIST * arg0 = lol_get( frame->args, 0 );
-    LIST * result = L0;
     module_t * source_module = bindmodule( list_empty( arg0 )
         ? 0
         : list_front( arg0 ) );
 
-    struct hash * const vars = source_module->variables;
-    if ( vars )
-        hashenumerate( vars, add_hash_key, &result );
-    return result;
+    return var_names( source_module );
 }
 
 
@@ -1304,6 +1292,7 @@ LIST * builtin_import( FRAME * frame, int flags )
          */
         imported->exported = 0;
     }
+    rules_changed();
 
     if ( source_iter != source_end || target_iter != target_end )
     {
@@ -1357,6 +1346,7 @@ LIST * builtin_export( FRAME * frame, int flags )
         }
         r->exported = 1;
     }
+    rules_changed();
     return L0;
 }
 
@@ -1745,6 +1735,7 @@ LIST * builtin_file_open( FRAME * frame, int flags )
 
     if ( strcmp(mode, "t") == 0 )
     {
+        b2::graph_snapshot::input( list_front( lol_get( frame->args, 0 ) ) );
         FILE* f = fopen( name, "r" );
         if ( !f ) return L0;
         char buf[ 1025 ];
@@ -1765,7 +1756,10 @@ LIST * builtin_file_open( FRAME * frame, int flags )
     }
 
     if ( strcmp(mode, "w") == 0 )
+    {
+        b2::graph_snapshot::output( list_front( lol_get( frame->args, 0 ) ) );
         fd = open( name, O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+    }
     else
         fd = open( name, O_RDONLY );
 
@@ -1839,6 +1833,7 @@ LIST * builtin_makedir( FRAME * frame, int flags )
 LIST *builtin_readlink( FRAME * frame, int flags )
 {
     const char * path = object_str( list_front( lol_get( frame->args, 0 ) ) );
+    b2::graph_snapshot::input( list_front( lol_get( frame->args, 0 ) ) );
 #ifdef OS_NT
 
     /* This struct is declared in ntifs.h which is
@@ -2050,6 +2045,9 @@ LIST * builtin_shell( FRAME * frame, int flags )
     int      exit_status_opt = 0;
     int      no_output_opt = 0;
     int      strip_eol_opt = 0;
+    int      cache_opt = 0;
+    std::string cache_key;
+    std::string cached_output;
 
     /* Process the variable args options. */
     {
@@ -2063,39 +2061,63 @@ LIST * builtin_shell( FRAME * frame, int flags )
                 no_output_opt = 1;
             else if ( !strcmp("strip-eol", object_str( list_front( arg ) ) ) )
                 strip_eol_opt = 1;
+            else if ( !strcmp( "cache", object_str( list_front( arg ) ) ) )
+                cache_opt = 1;
         }
     }
 
-    /* The following fflush() call seems to be indicated as a workaround for a
-     * popen() bug on POSIX implementations related to synhronizing input
-     * stream positions for the called and the calling process.
-     */
-    fflush( NULL );
-
-    p = popen( object_str( list_front( command ) ), "r" );
-    if ( p == NULL )
-        return L0;
-
-    string_new( &s );
+    if ( cache_opt && b2::shell_cache::enabled() )
+        cache_key = b2::shell_cache::key( object_str( list_front( command ) ) );
 
-    while ( ( ret = int32_t(fread( buffer, sizeof( char ), sizeof( buffer ) - 1, p )) ) >
-        0 )
+    if ( !cache_key.empty()
+        && b2::shell_cache::find( cache_key, cached_output ) )
     {
-        buffer[ ret ] = 0;
+        /* Only successful runs are cached. */
+        string_new( &s );
         if ( !no_output_opt )
+            string_append( &s, cached_output.c_str() );
+        exit_status = 0;
+    }
+    else
+    {
+        /* The following fflush() call seems to be indicated as a workaround
+         * for a popen() bug on POSIX implementations related to synhronizing
+         * input stream positions for the called and the calling process.
+         */
+        fflush( NULL );
+
+        p = popen( object_str( list_front( command ) ), "r" );
+        if ( p == NULL )
+            return L0;
+
+        string_new( &s );
+
+        while ( ( ret = int32_t(fread( buffer, sizeof( char ), sizeof( buffer ) - 1, p )) ) >
+            0 )
         {
-            string_append( &s, buffer );
+            buffer[ ret ] = 0;
+            /* The output is cached even when not returned. */
+            if ( !no_output_opt || !cache_key.empty() )
+            {
+                string_append( &s, buffer );
+            }
+
+            /* Explicit EOF check for systems with broken fread */
+            if ( feof( p ) ) break;
         }
 
-        /* Explicit EOF check for systems with broken fread */
-        if ( feof( p ) ) break;
+        exit_status = pclose( p );
+
+        if ( !cache_key.empty() && WIFEXITED( exit_status )
+            && WEXITSTATUS( exit_status ) == 0 )
+            b2::shell_cache::store( cache_key, s.value );
+        if ( no_output_opt )
+            string_truncate( &s, 0 );
     }
 
     if ( strip_eol_opt )
         string_rtrim( &s );
 
-    exit_status = pclose( p );
-
     /* The command output is returned first. */
     result = list_new( object_new( s.value ) );
     string_free( &s );
@@ -2115,6 +2137,8 @@ LIST * builtin_shell( FRAME * frame, int flags )
         result = list_push_back( result, b2::value::as_string(exit_status) );
     }
 
+    b2::graph_snapshot::shell( frame->args, result );
+
     return result;
 }
 
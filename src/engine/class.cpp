@@ -89,6 +89,7 @@ static void import_base_rule( void * r_, void * d_ )
 
     /* Copy 'exported' flag. */
     ir1->exported = ir2->exported = r->exported;
+    rules_changed();
 
     /* If we are importing a class method, localize it. */
     if ( ( r->module == d->base_module ) || ( r->module->class_module &&
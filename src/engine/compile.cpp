@@ -213,7 +213,8 @@ LIST * call_rule( OBJECT * rulename, FRAME * caller_frame, LIST * arg, ... )
 
 
 LIST * call_member_rule(
-    OBJECT * rulename, FRAME * caller_frame, b2::list_ref && self_, b2::lists && args_)
+    OBJECT * rulename, FRAME * caller_frame, b2::list_ref && self_, b2::lists && args_,
+    rule_cache * cache)
 {
     b2::list_ref self(std::move(self_));
     b2::lists args(std::move(args_));
@@ -235,7 +236,8 @@ LIST * call_member_rule(
 
     if (module->class_module)
     {
-        rule = bindrule(rulename, module);
+        rule = cache ? bindrule(rulename, module, *cache)
+            : bindrule(rulename, module);
         if (rule->procedure)
         {
             real_rulename = b2::value_ref(function_rulename(rule->procedure));
@@ -248,7 +250,8 @@ LIST * call_member_rule(
     else
     {
         real_rulename = std::string(self[0]->str())+"."+rulename->str();
-        rule = bindrule(real_rulename, caller_frame->module);
+        rule = cache ? bindrule(real_rulename, caller_frame->module, *cache)
+            : bindrule(real_rulename, caller_frame->module);
     }
 
     FRAME inner[ 1 ];
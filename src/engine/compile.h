@@ -32,7 +32,8 @@ LIST * call_rule(OBJECT * rulename, FRAME * caller_frame, LOL * args);
 LIST * call_member_rule(OBJECT * rulename,
 	FRAME * caller_frame,
 	b2::list_ref && self,
-	b2::lists && args);
+	b2::lists && args,
+	rule_cache * cache = nullptr);
 
 /* Flags for compile_set(), etc */
 
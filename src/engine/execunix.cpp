@@ -17,6 +17,7 @@
 #include "jam_strings.h"
 #include "startup.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include <signal.h>
 #include <stdio.h>
@@ -27,16 +28,31 @@
 #include <sys/wait.h>
 #include <poll.h>
 
+#if defined(__linux__)
+    #define USE_EPOLL
+    #include <sys/epoll.h>
+#endif
+
 #if defined(sun) || defined(__sun)
     #include <wait.h>
 #endif
 
 #include <sys/times.h>
 
+#include <string>
+#include <vector>
+
 #if defined(__APPLE__) || defined(__FILC__)
     #define NO_VFORK
 #endif
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__)
+    #define USE_POSIX_SPAWN
+    #include <spawn.h>
+    extern char ** environ;
+#endif
+
 #ifdef NO_VFORK
     #define vfork() fork()
 #endif
@@ -56,10 +72,19 @@
  *
  * Do not just set JAMSHELL to /bin/sh - it will not work!
  *
+ * Commands are started with posix_spawn() where available, and with vfork()
+ * otherwise or when a time limit needs to be set up in the child. Commands for
+ * the default shell that are a single simple command line, i.e. that use no
+ * shell syntax, are run directly instead of through /bin/sh.
+ *
  * External routines:
  *  exec_check() - preprocess and validate the command.
  *  exec_cmd() - launch an async command execution.
  *  exec_wait() - wait for any of the async command processes to terminate.
+ *
+ * Where available (Linux) the output pipes of the commands are watched with
+ * epoll. Such that each wakeup only visits the commands that have output, or
+ * finished, instead of all the running commands. Elsewhere poll() is used.
  */
 
 /* find a free slot in the running commands table */
@@ -79,11 +104,11 @@ static struct cmdtab_t
 {
     int          pid;            /* on win32, a real process handle */
     int          fd[ 2 ];        /* file descriptors for stdout and stderr */
-    FILE      *  stream[ 2 ];    /* child's stdout and stderr file streams */
     clock_t      start_time;     /* start time of child process */
     int          exit_reason;    /* termination status */
     char      *  buffer[ 2 ];    /* buffers to hold stdout and stderr, if any */
     int          buf_size[ 2 ];  /* buffer sizes in bytes */
+    int          buf_capacity[ 2 ];  /* allocated buffer sizes in bytes */
     timestamp    start_dt;       /* start of command timestamp */
 
     int flags;
@@ -104,6 +129,15 @@ struct pollfd * wait_fds = NULL;
 #define WAIT_FDS_SIZE ( globs.jobs * ( globs.pipe_action ? 2 : 1 ) )
 #define GET_WAIT_FD( job_idx ) ( wait_fds + ( ( job_idx * ( globs.pipe_action ? 2 : 1 ) ) ) )
 
+#ifdef USE_EPOLL
+/* The epoll instance watching all the open wait_fds. The events identify the
+ * descriptor as EPOLL_DATA( job_idx, stream ).
+ */
+static int epoll_fd = -1;
+static struct epoll_event * epoll_events = NULL;
+#define EPOLL_DATA( job_idx, s ) ( uint32_t( job_idx ) * 2 + uint32_t( s ) )
+#endif
+
 /*
  * exec_init() - global initialization
  */
@@ -126,13 +160,54 @@ void exec_init( void )
             }
         }
         cmdtab_size = globs.jobs;
+#ifdef USE_EPOLL
+        epoll_events = (epoll_event*)BJAM_REALLOC( epoll_events,
+            WAIT_FDS_SIZE * sizeof( *epoll_events ) );
+#endif
     }
+#ifdef USE_EPOLL
+    if ( epoll_fd == -1 && ( epoll_fd = epoll_create1( EPOLL_CLOEXEC ) ) == -1 )
+    {
+        errno_puts( "epoll_create1" );
+        b2::clean_exit( EXITBAD );
+    }
+#endif
 }
 
 void exec_done( void )
 {
     BJAM_FREE( cmdtab );
     BJAM_FREE( wait_fds );
+#ifdef USE_EPOLL
+    BJAM_FREE( epoll_events );
+    if ( epoll_fd != -1 )
+        close( epoll_fd );
+    epoll_fd = -1;
+#endif
+}
+
+
+/*
+ * watch_descriptor() - start waiting for output from a command pipe.
+ */
+
+static void watch_descriptor( int const i, int const s, int const fd )
+{
+    cmdtab[ i ].fd[ s ] = fd;
+    GET_WAIT_FD( i )[ s ].fd = fd;
+#ifdef USE_EPOLL
+    {
+        struct epoll_event event;
+        memset( &event, 0, sizeof( event ) );
+        event.events = EPOLLIN;
+        event.data.u32 = EPOLL_DATA( i, s );
+        if ( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, fd, &event ) == -1 )
+        {
+            errno_puts( "epoll_ctl" );
+            b2::clean_exit( EXITBAD );
+        }
+    }
+#endif
 }
 
 /*
@@ -162,6 +237,139 @@ int exec_check
 }
 
 
+/*
+ * argv_from_simple_command() - split a command line that does not need a shell
+ * to run into the arguments to run it directly. Returns false, and leaves argv
+ * empty, if the command needs the shell. The arguments point into the given
+ * words buffer.
+ *
+ * Simple commands are a single line of words made up of plain characters, and
+ * of quoted strings without expansions, escapes, or line breaks.
+ */
+
+static bool argv_from_simple_command( std::vector<char const *> & argv,
+    std::string & words, char const * command )
+{
+    /* Shell reserved words and builtins that need to run in the shell, or that
+     * may behave differently than the same named programs.
+     */
+    static char const * const builtins[] = {
+        ".", ":", "[", "alias", "bg", "break", "case", "cd", "command",
+        "continue", "do", "done", "echo", "elif", "else", "esac", "eval",
+        "exec", "exit", "export", "false", "fc", "fg", "fi", "for", "function",
+        "getopts", "hash", "if", "jobs", "kill", "local", "printf", "pwd",
+        "read", "readonly", "return", "select", "set", "shift", "source",
+        "test", "then", "time", "times", "trap", "true", "type", "typeset",
+        "ulimit", "umask", "unalias", "unset", "until", "wait", "while" };
+
+    std::vector<std::string::size_type> starts;
+    bool in_word = false;
+    bool line_ended = false;
+    char const * c;
+
+    words.clear();
+    for ( c = command; *c; ++c )
+    {
+        if ( *c == ' ' || *c == '\t' || *c == '\n' )
+        {
+            if ( in_word )
+                words.push_back( 0 );
+            in_word = false;
+            line_ended = line_ended || ( *c == '\n' && !starts.empty() );
+            continue;
+        }
+        if ( line_ended )
+            return false;
+        if ( !in_word )
+            starts.push_back( words.size() );
+        in_word = true;
+        if ( *c == '"' || *c == '\'' )
+        {
+            char const * const special = *c == '"' ? "\"$`\\\n" : "'\n";
+            char const quote = *c;
+            for ( ++c; *c && !strchr( special, *c ); ++c )
+                words.push_back( *c );
+            if ( *c != quote )
+                return false;
+        }
+        else if ( isalnum( (unsigned char)*c ) || strchr( "-_./+,:@%=", *c ) )
+            words.push_back( *c );
+        else
+            return false;
+    }
+    if ( in_word )
+        words.push_back( 0 );
+    if ( starts.empty() )
+        return false;
+
+    /* Variable assignments and builtins are for the shell. */
+    if ( strchr( words.c_str(), '=' ) )
+        return false;
+    for ( char const * builtin : builtins )
+        if ( !strcmp( words.c_str(), builtin ) )
+            return false;
+
+    for ( auto start : starts )
+        argv.push_back( words.c_str() + start );
+    argv.push_back( NULL );
+    return true;
+}
+
+
+#ifdef USE_POSIX_SPAWN
+
+/*
+ * spawn_command() - start the command with posix_spawn(), setting up the child
+ * as exec_cmd() does after vfork(). Returns 0, or the error number.
+ */
+
+static int spawn_command( pid_t * pid, char const * const * argv,
+    int const out[ 2 ], int const err[ 2 ], sigset_t const * sigmask,
+    struct sigaction const * saveintr, struct sigaction const * savequit )
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t sigdefault;
+    int result;
+
+    /* Redirect stdout and stderr to the pipes, and only keep those. */
+    posix_spawn_file_actions_init( &actions );
+    posix_spawn_file_actions_addclose( &actions, out[ 0 ] );
+    if ( globs.pipe_action )
+        posix_spawn_file_actions_addclose( &actions, err[ 0 ] );
+    posix_spawn_file_actions_adddup2( &actions, globs.pipe_action ? err[ 1 ] :
+        out[ 1 ], STDERR_FILENO );
+    posix_spawn_file_actions_adddup2( &actions, out[ 1 ], STDOUT_FILENO );
+    posix_spawn_file_actions_addclose( &actions, out[ 1 ] );
+    if ( globs.pipe_action )
+        posix_spawn_file_actions_addclose( &actions, err[ 1 ] );
+
+    /* Make the child a process group leader, with the signal mask and
+     * interrupt handling we had before starting it.
+     */
+    sigemptyset( &sigdefault );
+    if ( saveintr->sa_handler != SIG_IGN )
+        sigaddset( &sigdefault, SIGINT );
+    if ( savequit->sa_handler != SIG_IGN )
+        sigaddset( &sigdefault, SIGQUIT );
+    posix_spawnattr_init( &attr );
+    posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETPGROUP |
+        POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF );
+    posix_spawnattr_setpgroup( &attr, 0 );
+    posix_spawnattr_setsigmask( &attr, sigmask );
+    posix_spawnattr_setsigdefault( &attr, &sigdefault );
+
+    result = posix_spawnp( pid, argv[ 0 ], &actions, &attr,
+        (char * const *)argv, environ );
+
+    posix_spawnattr_destroy( &attr );
+    posix_spawn_file_actions_destroy( &actions );
+    return result;
+}
+
+#endif
+
+
 /*
  * exec_cmd() - launch an async command execution.
  */
@@ -188,6 +396,8 @@ void exec_cmd
     int out[ 2 ];
     int err[ 2 ];
     char const * argv[ MAXARGC + 1 ];  /* +1 for NULL */
+    std::vector<char const *> direct_argv;
+    std::string direct_words;
 
     /* Initialize default shell. */
     static LIST * default_shell;
@@ -196,8 +406,12 @@ void exec_cmd
             object_new( "/bin/sh" ) ),
             object_new( "-c" ) );
 
+    /* Simple commands for the default shell run without it. */
     if ( list_empty( shell ) )
+    {
+        argv_from_simple_command( direct_argv, direct_words, command->value );
         shell = default_shell;
+    }
 
     /* Forumulate argv. If shell was defined, be prepared for % and ! subs.
      * Otherwise, use stock /bin/sh.
@@ -207,11 +421,20 @@ void exec_cmd
     if ( is_debug_execcmd() )
     {
         int i;
-        out_printf( "Using shell: " );
-        list_print( shell );
-        out_printf( "\n" );
-        for ( i = 0; argv[ i ]; ++i )
-            out_printf( "    argv[%d] = '%s'\n", i, argv[ i ] );
+        if ( direct_argv.empty() )
+        {
+            out_printf( "Using shell: " );
+            list_print( shell );
+            out_printf( "\n" );
+            for ( i = 0; argv[ i ]; ++i )
+                out_printf( "    argv[%d] = '%s'\n", i, argv[ i ] );
+        }
+        else
+        {
+            out_printf( "Using no shell:\n" );
+            for ( i = 0; direct_argv[ i ]; ++i )
+                out_printf( "    argv[%d] = '%s'\n", i, direct_argv[ i ] );
+        }
     }
 
     /* Create pipes for collecting child output. */
@@ -261,6 +484,31 @@ void exec_cmd
     if (sigprocmask(SIG_BLOCK, &chldmask, &savemask) < 0)
         return;
 
+#ifdef USE_POSIX_SPAWN
+    /* Setting the CPU time limit needs to happen in the child, hence vfork. */
+    if ( globs.timeout <= 0 )
+    {
+        pid_t pid = 0;
+        int result = -1;
+        /* When the command can not be run directly we go through the shell,
+         * which reports the problem.
+         */
+        if ( !direct_argv.empty() )
+            result = spawn_command( &pid, direct_argv.data(), out, err,
+                &savemask, &saveintr, &savequit );
+        if ( result != 0 )
+            result = spawn_command( &pid, argv, out, err, &savemask, &saveintr,
+                &savequit );
+        if ( result != 0 )
+        {
+            errno = result;
+            errno_puts( "posix_spawn" );
+            b2::clean_exit( EXITBAD );
+        }
+        cmdtab[ slot ].pid = pid;
+    }
+    else
+#endif
     if ( ( cmdtab[ slot ].pid = vfork() ) == -1 )
     {
         errno_puts( "vfork" );
@@ -317,6 +565,8 @@ void exec_cmd
             setrlimit( RLIMIT_CPU, &r_limit );
         }
 
+        if ( !direct_argv.empty() )
+            execvp( direct_argv[ 0 ], (char * *)direct_argv.data() );
         execvp( argv[ 0 ], (char * *)argv );
         errno_puts( "execvp" );
         _exit( 127 );
@@ -332,29 +582,11 @@ void exec_cmd
         close( err[ EXECCMD_PIPE_WRITE ] );
 
     /* Parent reads from out[ EXECCMD_PIPE_READ ]. */
-    cmdtab[ slot ].fd[ OUT ] = out[ EXECCMD_PIPE_READ ];
-    cmdtab[ slot ].stream[ OUT ] = fdopen( cmdtab[ slot ].fd[ OUT ], "rb" );
-    if ( !cmdtab[ slot ].stream[ OUT ] )
-    {
-        errno_puts( "fdopen" );
-        b2::clean_exit( EXITBAD );
-    }
+    watch_descriptor( slot, OUT, out[ EXECCMD_PIPE_READ ] );
 
     /* Parent reads from err[ EXECCMD_PIPE_READ ]. */
     if ( globs.pipe_action )
-    {
-        cmdtab[ slot ].fd[ ERR ] = err[ EXECCMD_PIPE_READ ];
-        cmdtab[ slot ].stream[ ERR ] = fdopen( cmdtab[ slot ].fd[ ERR ], "rb" );
-        if ( !cmdtab[ slot ].stream[ ERR ] )
-        {
-            errno_puts( "fdopen" );
-            b2::clean_exit( EXITBAD );
-        }
-    }
-
-    GET_WAIT_FD( slot )[ OUT ].fd = out[ EXECCMD_PIPE_READ ];
-    if ( globs.pipe_action )
-        GET_WAIT_FD( slot )[ ERR ].fd = err[ EXECCMD_PIPE_READ ];
+        watch_descriptor( slot, ERR, err[ EXECCMD_PIPE_READ ] );
 
     cmdtab[ slot ].flags = flags;
 
@@ -372,23 +604,64 @@ void exec_cmd
 #undef EXECCMD_PIPE_WRITE
 
 
+/*
+ * append_output() - add output read from a command to its buffer. The buffer
+ * grows geometrically, so collecting the output takes linear time overall.
+ *
+ * The first read is cut to the globs.max_buf limit. Later reads are added
+ * whole while the buffer is below the limit.
+ */
+
+static void append_output( int const i, int const s, char const * data,
+    int len )
+{
+    int used;
+
+    if ( !cmdtab[ i ].buffer[ s ] )
+    {
+        /* Never been allocated. */
+        if ( globs.max_buf && len > globs.max_buf )
+            len = globs.max_buf;
+        used = 0;
+    }
+    else if ( cmdtab[ i ].buf_size[ s ] < globs.max_buf || !globs.max_buf )
+        /* Previously allocated, without the terminating null. */
+        used = cmdtab[ i ].buf_size[ s ] - 1;
+    else
+        return;
+
+    if ( used + len + 1 > cmdtab[ i ].buf_capacity[ s ] )
+    {
+        int capacity = cmdtab[ i ].buf_capacity[ s ]
+            ? cmdtab[ i ].buf_capacity[ s ] * 2
+            : BUFSIZ;
+        while ( capacity < used + len + 1 )
+            capacity *= 2;
+        cmdtab[ i ].buffer[ s ] = (char*)BJAM_REALLOC( cmdtab[ i ].buffer[ s ],
+            capacity );
+        cmdtab[ i ].buf_capacity[ s ] = capacity;
+    }
+    memcpy( cmdtab[ i ].buffer[ s ] + used, data, len );
+    cmdtab[ i ].buffer[ s ][ used + len ] = 0;
+    cmdtab[ i ].buf_size[ s ] = used + len + 1;
+}
+
+
 /* Returns 1 if file descriptor is closed, or 0 if it is still alive.
  *
  * i is index into cmdtab
  *
  * s (stream) indexes:
- *  - cmdtab[ i ].stream[ s ]
  *  - cmdtab[ i ].buffer[ s ]
  *  - cmdtab[ i ].fd    [ s ]
  */
 
 static int read_descriptor( int i, int s )
 {
-    int ret;
+    ssize_t ret;
     char buffer[ BUFSIZ ];
 
-    while ( 0 < ( ret = fread( buffer, sizeof( char ), BUFSIZ - 1,
-        cmdtab[ i ].stream[ s ] ) ) )
+    while ( 0 < ( ret = read( cmdtab[ i ].fd[ s ], buffer, BUFSIZ - 1 ) ) )
     {
         buffer[ ret ] = 0;
 
@@ -401,33 +674,7 @@ static int read_descriptor( int i, int s )
                 err_data( buffer );
         }
 
-        if ( !cmdtab[ i ].buffer[ s ] )
-        {
-            /* Never been allocated. */
-            if ( globs.max_buf && ret > globs.max_buf )
-            {
-                ret = globs.max_buf;
-                buffer[ ret ] = 0;
-            }
-            cmdtab[ i ].buf_size[ s ] = ret + 1;
-            cmdtab[ i ].buffer[ s ] = (char*)BJAM_MALLOC_ATOMIC( ret + 1 );
-            memcpy( cmdtab[ i ].buffer[ s ], buffer, ret + 1 );
-        }
-        else
-        {
-            /* Previously allocated. */
-            if ( cmdtab[ i ].buf_size[ s ] < globs.max_buf || !globs.max_buf )
-            {
-                char * tmp = cmdtab[ i ].buffer[ s ];
-                int const old_len = cmdtab[ i ].buf_size[ s ] - 1;
-                int const new_len = old_len + ret + 1;
-                cmdtab[ i ].buf_size[ s ] = new_len;
-                cmdtab[ i ].buffer[ s ] = (char*)BJAM_MALLOC_ATOMIC( new_len );
-                memcpy( cmdtab[ i ].buffer[ s ], tmp, old_len );
-                memcpy( cmdtab[ i ].buffer[ s ] + old_len, buffer, ret + 1 );
-                BJAM_FREE( tmp );
-            }
-        }
+        append_output( i, s, buffer, int( ret ) );
     }
 
     /* If buffer full, ensure last buffer char is newline so that jam log
@@ -437,19 +684,24 @@ static int read_descriptor( int i, int s )
     if ( globs.max_buf && globs.max_buf <= cmdtab[ i ].buf_size[ s ] )
         cmdtab[ i ].buffer[ s ][ cmdtab[ i ].buf_size[ s ] - 2 ] = '\n';
 
-    return feof( cmdtab[ i ].stream[ s ] );
+    /* End of file, or an error other than having to wait for more. */
+    return ret == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK &&
+        errno != EINTR );
 }
 
 
 /*
- * close_streams() - Close the stream and pipe descriptor.
+ * close_streams() - Close the pipe descriptor.
  */
 
 static void close_streams( int const i, int const s )
 {
-    fclose( cmdtab[ i ].stream[ s ] );
-    cmdtab[ i ].stream[ s ] = 0;
-
+#ifdef USE_EPOLL
+    /* Other children may hold copies of the descriptor, hence closing it does
+     * not remove it from the epoll set.
+     */
+    epoll_ctl( epoll_fd, EPOLL_CTL_DEL, cmdtab[ i ].fd[ s ], NULL );
+#endif
     close( cmdtab[ i ].fd[ s ] );
     cmdtab[ i ].fd[ s ] = 0;
 
@@ -457,6 +709,85 @@ static void close_streams( int const i, int const s )
 }
 
 
+/*
+ * exec_finish() - reap a command that closed its output and call its
+ * completion callback.
+ */
+
+static void exec_finish( int const i )
+{
+    int pid;
+    int status;
+    int rstat;
+    timing_info time_info;
+    struct rusage cmd_usage;
+
+    /* Close the pipe descriptors. */
+    close_streams( i, OUT );
+    if ( globs.pipe_action )
+        close_streams( i, ERR );
+
+    /* Reap the child and release resources. */
+#ifdef __HAIKU__
+    while ((pid = waitpid(cmdtab[i].pid, &status, 0)) == -1)
+        if (errno != EINTR)
+            break;
+    getrusage(RUSAGE_CHILDREN, &cmd_usage);
+#else
+    while ( ( pid = wait4( cmdtab[ i ].pid, &status, 0, &cmd_usage ) ) == -1 )
+        if ( errno != EINTR )
+            break;
+#endif
+    if ( pid != cmdtab[ i ].pid )
+    {
+        err_printf( "unknown pid %d with errno = %d\n", pid, errno );
+        b2::clean_exit( EXITBAD );
+    }
+
+    /* Set reason for exit if not timed out. */
+    if ( WIFEXITED( status ) )
+        cmdtab[ i ].exit_reason = WEXITSTATUS( status )
+            ? EXIT_FAIL
+            : EXIT_OK;
+
+    {
+        time_info.system = ((double)(cmd_usage.ru_stime.tv_sec)*1000000.0+(double)(cmd_usage.ru_stime.tv_usec))/1000000.0;
+        time_info.user   = ((double)(cmd_usage.ru_utime.tv_sec)*1000000.0+(double)(cmd_usage.ru_utime.tv_usec))/1000000.0;
+        timestamp_copy( &time_info.start, &cmdtab[ i ].start_dt );
+        timestamp_current( &time_info.end );
+    }
+
+    /* Drive the completion. */
+    if ( interrupted() )
+        rstat = EXEC_CMD_INTR;
+    else if ( status )
+        rstat = EXEC_CMD_FAIL;
+    else
+        rstat = EXEC_CMD_OK;
+
+    /* Call the callback, may call back to jam rule land. */
+    (*cmdtab[ i ].func)( cmdtab[ i ].closure, rstat, &time_info,
+        cmdtab[ i ].buffer[ OUT ], cmdtab[ i ].buffer[ ERR ],
+        cmdtab[ i ].exit_reason );
+
+    /* Clean up the command's running commands table slot. */
+    BJAM_FREE( cmdtab[ i ].buffer[ OUT ] );
+    cmdtab[ i ].buffer[ OUT ] = 0;
+    cmdtab[ i ].buf_size[ OUT ] = 0;
+    cmdtab[ i ].buf_capacity[ OUT ] = 0;
+
+    BJAM_FREE( cmdtab[ i ].buffer[ ERR ] );
+    cmdtab[ i ].buffer[ ERR ] = 0;
+    cmdtab[ i ].buf_size[ ERR ] = 0;
+    cmdtab[ i ].buf_capacity[ ERR ] = 0;
+
+    cmdtab[ i ].pid = 0;
+    cmdtab[ i ].func = 0;
+    cmdtab[ i ].closure = 0;
+    cmdtab[ i ].start_time = 0;
+}
+
+
 /*
  * exec_wait() - wait for any of the async command processes to terminate.
  *
@@ -472,6 +803,10 @@ void exec_wait()
     while ( !finished )
     {
         int i;
+#ifdef USE_EPOLL
+        int e;
+        int ready = 0;
+#endif
         long select_timeout = globs.timeout;
 
         /* Check for timeouts:
@@ -511,15 +846,46 @@ void exec_wait()
              * wait indefinitely) to poll, to prevent busy-looping.
              */
             timeout = select_timeout? select_timeout * 1000 : -1;
+#ifdef USE_EPOLL
+            while ( ( ret = epoll_wait( epoll_fd, epoll_events, WAIT_FDS_SIZE,
+                timeout ) ) == -1 )
+#else
             while ( ( ret = poll( wait_fds, WAIT_FDS_SIZE, timeout ) ) == -1 )
+#endif
                 if ( errno != EINTR )
                     break;
             /* restore original signal mask by unblocking sigchld */
             sigprocmask(SIG_UNBLOCK, &sigmask, NULL);
             if ( ret <= 0 )
                 continue;
+#ifdef USE_EPOLL
+            ready = ret;
+#endif
         }
 
+#ifdef USE_EPOLL
+        for ( e = 0; e < ready; ++e )
+        {
+            i = int( epoll_events[ e ].data.u32 / 2 );
+            int const s = int( epoll_events[ e ].data.u32 % 2 );
+            /* Skip events of commands that finished with an earlier event. */
+            if ( GET_WAIT_FD( i )[ s ].fd == -1 )
+                continue;
+            /* If feof on either descriptor, we are done. */
+            if ( read_descriptor( i, s ) )
+            {
+                /* Collect what is left of the other output, as its event may
+                 * come later.
+                 */
+                if ( globs.pipe_action )
+                    read_descriptor( i, 1 - s );
+
+                /* We found a terminated child process - our search is done. */
+                finished = 1;
+                exec_finish( i );
+            }
+        }
+#else
         for ( i = 0; i < globs.jobs; ++i )
         {
             int out_done = 0;
@@ -533,78 +899,12 @@ void exec_wait()
             /* If feof on either descriptor, we are done. */
             if ( out_done || err_done )
             {
-                int pid;
-                int status;
-                int rstat;
-                timing_info time_info;
-                struct rusage cmd_usage;
-
                 /* We found a terminated child process - our search is done. */
                 finished = 1;
-
-                /* Close the stream and pipe descriptors. */
-                close_streams( i, OUT );
-                if ( globs.pipe_action )
-                    close_streams( i, ERR );
-
-                /* Reap the child and release resources. */
-            #ifdef __HAIKU__
-                while ((pid = waitpid(cmdtab[i].pid, &status, 0)) == -1)
-                    if (errno != EINTR)
-                        break;
-                getrusage(RUSAGE_CHILDREN, &cmd_usage);
-            #else
-                while ( ( pid = wait4( cmdtab[ i ].pid, &status, 0, &cmd_usage ) ) == -1 )
-                    if ( errno != EINTR )
-                        break;
-            #endif
-                if ( pid != cmdtab[ i ].pid )
-                {
-                    err_printf( "unknown pid %d with errno = %d\n", pid, errno );
-                    b2::clean_exit( EXITBAD );
-                }
-
-                /* Set reason for exit if not timed out. */
-                if ( WIFEXITED( status ) )
-                    cmdtab[ i ].exit_reason = WEXITSTATUS( status )
-                        ? EXIT_FAIL
-                        : EXIT_OK;
-
-                {
-                    time_info.system = ((double)(cmd_usage.ru_stime.tv_sec)*1000000.0+(double)(cmd_usage.ru_stime.tv_usec))/1000000.0;
-                    time_info.user   = ((double)(cmd_usage.ru_utime.tv_sec)*1000000.0+(double)(cmd_usage.ru_utime.tv_usec))/1000000.0;
-                    timestamp_copy( &time_info.start, &cmdtab[ i ].start_dt );
-                    timestamp_current( &time_info.end );
-                }
-
-                /* Drive the completion. */
-                if ( interrupted() )
-                    rstat = EXEC_CMD_INTR;
-                else if ( status )
-                    rstat = EXEC_CMD_FAIL;
-                else
-                    rstat = EXEC_CMD_OK;
-
-                /* Call the callback, may call back to jam rule land. */
-                (*cmdtab[ i ].func)( cmdtab[ i ].closure, rstat, &time_info,
-                    cmdtab[ i ].buffer[ OUT ], cmdtab[ i ].buffer[ ERR ],
-                    cmdtab[ i ].exit_reason );
-
-                /* Clean up the command's running commands table slot. */
-                BJAM_FREE( cmdtab[ i ].buffer[ OUT ] );
-                cmdtab[ i ].buffer[ OUT ] = 0;
-                cmdtab[ i ].buf_size[ OUT ] = 0;
-
-                BJAM_FREE( cmdtab[ i ].buffer[ ERR ] );
-                cmdtab[ i ].buffer[ ERR ] = 0;
-                cmdtab[ i ].buf_size[ ERR ] = 0;
-
-                cmdtab[ i ].pid = 0;
-                cmdtab[ i ].func = 0;
-                cmdtab[ i ].closure = 0;
-                cmdtab[ i ].start_time = 0;
+                exec_finish( i );
             }
         }
+#endif
     }
 }
 
@@ -16,10 +16,12 @@
  *  file_is_file()       - return whether a path identifies an existing file
  *  file_query()         - get cached information about a path, query the OS if
  *                         needed
+ *  file_query_prefetch() - query the OS about many paths in parallel
  *  file_remove_atexit() - schedule a path to be removed on program exit
  *  file_time()          - get a file timestamp
  *
  * External routines - utilities for OS specific module implementations:
+ *  file_query_listed_() - file_query() for the paths found listing a directory
  *  file_query_posix_()  - query information about a path using POSIX stat()
  *
  * Internal routines:
@@ -35,12 +37,15 @@
 #include "pathsys.h"
 #include "jam_strings.h"
 #include "output.h"
+#include "tasks.h"
 
 #include <assert.h>
 #include <sys/stat.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstdint>
 #include <mutex>
+#include <vector>
 
 #ifdef OS_NT
 #define WIN32_LEAN_AND_MEAN
@@ -49,7 +54,7 @@
 
 #if !defined(OS_NT)
 #include <sys/mman.h>
-#define USE_MMAP 0
+#define USE_MMAP 1
 #else
 #define USE_MMAP 0
 #endif
@@ -245,13 +250,29 @@ int file_time( OBJECT * const path, timestamp * const time )
 
 
 /*
- * file_query() - get cached information about a path, query the OS if needed
- *
- * Returns 0 in case querying the OS about the given path fails, e.g. because
- * the path does not reference an existing file system object.
+ * file_query_new_() - query the OS about a path just added to the cache
  */
 
-file_info_t * file_query( OBJECT * const path )
+static void file_query_new_( file_info_t * const ff )
+{
+    file_query_( ff );
+    if ( ff->exists )
+    {
+        /* Set the path's timestamp to 1 in case it is 0 or undetected to avoid
+         * confusion with non-existing paths.
+         */
+        if ( timestamp_empty( &ff->time ) )
+            timestamp_init( &ff->time, 1, 0 );
+    }
+}
+
+
+/*
+ * file_query_info_() - get cached information about a path, query the OS if
+ * needed, including for paths that do not exist
+ */
+
+static file_info_t * file_query_info_( OBJECT * const path )
 {
     /* FIXME: Add tracking for disappearing files (i.e. those that can not be
      * detected by stat() even though they had been detected successfully
@@ -263,22 +284,87 @@ file_info_t * file_query( OBJECT * const path )
     int found;
     file_info_t * const ff = file_info( path, &found );
     if ( !found )
+        file_query_new_( ff );
+    return ff;
+}
+
+
+/*
+ * file_query() - get cached information about a path, query the OS if needed
+ *
+ * Returns 0 in case querying the OS about the given path fails, e.g. because
+ * the path does not reference an existing file system object.
+ */
+
+file_info_t * file_query( OBJECT * const path )
+{
+    file_info_t * const ff = file_query_info_( path );
+    ff->queried = 1;
+    return ff->exists ? ff : 0;
+}
+
+
+/*
+ * file_query_listed_() - file_query() for the paths found when listing a
+ * directory, that does not mark them as queried. What matters to the build
+ * about those is the listing, until it asks about a path itself.
+ */
+
+file_info_t * file_query_listed_( OBJECT * const path )
+{
+    file_info_t * const ff = file_query_info_( path );
+    return ff->exists ? ff : 0;
+}
+
+
+/*
+ * file_query_prefetch() - query the OS about the paths not cached yet, all
+ * together in parallel. Such that the file_query() calls for them that follow
+ * don't wait on the OS one at a time. The queries are added to the cache here,
+ * and only filled in by the tasks. Which is safe as nothing else looks at the
+ * cache until they are done. Returns the paths that don't exist, in the given
+ * order.
+ *
+ * Not done on Windows. Where querying a path lists its parent directory into
+ * the cache instead.
+ */
+
+LIST * file_query_prefetch( LIST * paths )
+{
+    LIST * missing = L0;
+#ifndef OS_NT
+    std::vector<file_info_t *> infos;
+    std::vector<file_info_t *> queries;
+    for ( auto path : b2::list_cref( paths ) )
     {
-        file_query_( ff );
-        if ( ff->exists )
-        {
-            /* Set the path's timestamp to 1 in case it is 0 or undetected to avoid
-             * confusion with non-existing paths.
-             */
-            if ( timestamp_empty( &ff->time ) )
-                timestamp_init( &ff->time, 1, 0 );
-        }
+        int found;
+        file_info_t * const ff = file_info( path, &found );
+        infos.push_back( ff );
+        if ( !found )
+            queries.push_back( ff );
     }
-    if ( !ff->exists )
+
+    if ( !queries.empty() )
     {
-        return 0;
+        std::size_t const batch = 64;
+        auto tasks = b2::task::executor::get().make();
+        for ( std::size_t i = 0; i < queries.size(); i += batch )
+        {
+            std::size_t const end = std::min( i + batch, queries.size() );
+            tasks->queue( [&queries, i, end]() {
+                for ( std::size_t j = i; j < end; ++j )
+                    file_query_new_( queries[ j ] );
+            } );
+        }
+        tasks->wait();
     }
-    return ff;
+
+    std::size_t i = 0;
+    for ( auto path : b2::list_cref( paths ) )
+        if ( !infos[ i++ ]->exists )
+            missing = list_push_back( missing, object_copy( path ) );
+#endif
+    return missing;
 }
 
 #ifndef OS_NT
@@ -446,7 +532,7 @@ static void file_dirscan_impl( OBJECT * dir, scanback func, void * closure )
         for ( ; iter != end; iter = list_next( iter ) )
         {
             OBJECT * const path = list_item( iter );
-            file_info_t const * const ffq = file_query( path );
+            file_info_t const * const ffq = file_query_listed_( path );
             /* Using a file name read from a file_info_t structure allows OS
              * specific implementations to store some kind of a normalized file
              * name there. Using such a normalized file name then allows us to
@@ -709,18 +795,19 @@ std::size_t file_query_data_size_(const std::string & filepath)
 }
 }
 
-file_buffer::file_buffer(const std::string & filepath)
+file_buffer::file_buffer(const std::string & filepath, bool memory_map)
 {
     data_size = file_query_data_size_(filepath);
-    file = std::fopen(filepath.c_str(), "r");
+    // Memory mapping is requested for binary data, read it as such.
+    file = std::fopen(filepath.c_str(), memory_map ? "rb" : "r");
     #if USE_MMAP
-    if (file)
+    if (file && memory_map && data_size > 0)
     {
-        is_memory_mapped = true;
         auto p = mmap(
             nullptr, data_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
         if (p != MAP_FAILED)
         {
+            is_memory_mapped = true;
             data_c.reset(static_cast<char*>(p));
             // madvise(data_c.get(), data_size, MADV_SEQUENTIAL);
         }
@@ -750,4 +837,62 @@ file_buffer::~file_buffer()
     #endif
 }
 
+void for_each_info(const std::function<void(const file_info_t &)> & f)
+{
+    filecache().for_each(f);
+}
+
+bool replace_file(const std::string & path,
+    const std::function<bool(FILE *)> & write, bool binary)
+{
+    std::string const tmp = path + ".b2-tmp";
+    FILE * f = std::fopen(tmp.c_str(), binary ? "wb" : "w");
+    if (!f) return false;
+    bool ok = write(f);
+    ok = std::fclose(f) == 0 && ok;
+    // Windows rename does not replace existing files.
+    if (ok) std::remove(path.c_str());
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) std::remove(tmp.c_str());
+    return ok;
+}
+
+std::string escape_field(const std::string & s)
+{
+    std::string result;
+    for (char c : s)
+    {
+        switch (c)
+        {
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default: result += c;
+        }
+    }
+    return result;
+}
+
+std::string unescape_field(const std::string & s)
+{
+    std::string result;
+    for (std::string::size_type i = 0; i < s.size(); ++i)
+    {
+        if (s[i] != '\\' || i + 1 == s.size())
+        {
+            result += s[i];
+            continue;
+        }
+        switch (s[++i])
+        {
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            default: result += s[i];
+        }
+    }
+    return result;
+}
+
 }}
@@ -24,6 +24,8 @@
 #include "object.h"
 #include "timestamp.h"
 
+#include <cstdio>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -33,6 +35,8 @@ struct file_info_t
 	char is_file = 0;
 	char is_dir = 0;
 	char exists = 0;
+	/* Asked about directly, not only found when listing a directory. */
+	char queried = 0;
 	timestamp time;
 	LIST * files = L0;
 	file_info_t() = default;
@@ -92,6 +96,7 @@ file_info_t * file_info(OBJECT * const path, int * found);
 int file_is_file(OBJECT * const path);
 int file_mkdir(char const * const path);
 file_info_t * file_query(OBJECT * const path);
+LIST * file_query_prefetch(LIST * paths);
 void file_remove_atexit(OBJECT * const path);
 void file_supported_fmt_resolution(timestamp * const);
 int file_time(OBJECT * const path, timestamp * const);
@@ -106,6 +111,21 @@ inline bool is_file(const std::string & path)
 	return result;
 }
 
+// Calls `f` with the cached information of each path queried so far.
+void for_each_info(const std::function<void(const file_info_t &)> & f);
+
+// Replaces the file with what `write` writes to the given stream. Written to a
+// temporary file first, and renamed to the file when complete, such that other
+// builds never see a partial file. Returns false, and leaves the file as it
+// was, when `write`, or any of the file operations, fails.
+bool replace_file(const std::string & path,
+	const std::function<bool(FILE *)> & write, bool binary = false);
+
+// Escapes, and unescapes, the backslashes, tabs, and line ends of a field of
+// the records written one per line, with tab separated fields.
+std::string escape_field(const std::string & s);
+std::string unescape_field(const std::string & s);
+
 }} // namespace b2::filesys
 
 /*  Archive/library file support */
@@ -135,6 +155,7 @@ inline file_archive_info_t::~file_archive_info_t()
 }
 
 /* Internal utility worker functions. */
+file_info_t * file_query_listed_(OBJECT * const path);
 void file_query_posix_(file_info_t * const);
 
 void file_done();
@@ -145,7 +166,8 @@ class file_buffer
 	public:
 	bool is_memory_mapped = false;
 
-	file_buffer(const std::string & filepath);
+	// Reads the entire file, or memory maps it if requested and supported.
+	file_buffer(const std::string & filepath, bool memory_map = false);
 	~file_buffer();
 
 	inline std::size_t size() const { return data_size; }
@@ -153,7 +153,7 @@ int file_collect_dir_content_( file_info_t * const d )
         path_build( &f, path );
         name = object_new( path->value );
         /* Immediately stat the file to preserve invariants. */
-        if ( file_query( name ) )
+        if ( file_query_listed_( name ) )
             files = list_push_back( files, name );
         else
             object_free( name );
@@ -53,18 +53,42 @@
 #endif
 
 /*
-#define FUNCTION_DEBUG_PROFILE
-*/
+ * The profiling in function_run() is only compiled into the variant of it that
+ * runs when profiling, i.e. where Profile is true.
+ */
 
-#ifndef FUNCTION_DEBUG_PROFILE
 #undef PROFILE_ENTER_LOCAL
-#define PROFILE_ENTER_LOCAL(x) while (false)
+#define PROFILE_ENTER_LOCAL(scope) \
+    static OBJECT * constant_LOCAL_##scope = 0; \
+    profile_frame PROF_LOCAL_##scope; \
+    if ( Profile ) \
+    { \
+        if ( !constant_LOCAL_##scope ) \
+            constant_LOCAL_##scope = profile_make_local( #scope ); \
+        profile_enter( constant_LOCAL_##scope, &PROF_LOCAL_##scope ); \
+    } \
+    else (void)0
 #undef PROFILE_EXIT_LOCAL
-#define PROFILE_EXIT_LOCAL(x)
+#define PROFILE_EXIT_LOCAL(scope) \
+    do { if ( Profile ) profile_exit( &PROF_LOCAL_##scope ); } while ( false )
+
+/*
+ * With GCC and Clang function_run() jumps directly from one instruction to the
+ * code of the next, through a table of the label addresses of the instructions.
+ * Otherwise each instruction goes back to the switch.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FUNCTION_RUN_THREADED 1
+#else
+#define FUNCTION_RUN_THREADED 0
 #endif
 
 int32_t glob( char const * s, char const * c );
 
+/* Changing the instructions needs a new function_format_version, as they are
+ * written to the compiled Jamfile cache.
+ */
 #define INSTR_PUSH_EMPTY                   0
 #define INSTR_PUSH_CONSTANT                1
 #define INSTR_PUSH_ARG                     2
@@ -149,6 +173,154 @@ int32_t glob( char const * s, char const * c );
 #define INSTR_DEBUG_LINE                   67
 #define INSTR_FOR_POP                      70
 
+/* Superinstructions, only emitted by compile_optimize(). */
+
+#define INSTR_PUSH_CONSTANTS               68
+#define INSTR_CLEAR_RESULT                 69
+#define INSTR_PUSH_VAR_GRIST               71
+#define INSTR_SET_RESULT_RETURN            72
+
+#define INSTR_MAX                          72
+
+static char const * instruction_name( uint32_t op_code )
+{
+    switch ( op_code )
+    {
+    case INSTR_PUSH_EMPTY: return "PUSH_EMPTY";
+    case INSTR_PUSH_CONSTANT: return "PUSH_CONSTANT";
+    case INSTR_PUSH_ARG: return "PUSH_ARG";
+    case INSTR_PUSH_VAR: return "PUSH_VAR";
+    case INSTR_PUSH_GROUP: return "PUSH_GROUP";
+    case INSTR_PUSH_RESULT: return "PUSH_RESULT";
+    case INSTR_PUSH_APPEND: return "PUSH_APPEND";
+    case INSTR_SWAP: return "SWAP";
+    case INSTR_JUMP_EMPTY: return "JUMP_EMPTY";
+    case INSTR_JUMP_NOT_EMPTY: return "JUMP_NOT_EMPTY";
+    case INSTR_JUMP: return "JUMP";
+    case INSTR_JUMP_LT: return "JUMP_LT";
+    case INSTR_JUMP_LE: return "JUMP_LE";
+    case INSTR_JUMP_GT: return "JUMP_GT";
+    case INSTR_JUMP_GE: return "JUMP_GE";
+    case INSTR_JUMP_EQ: return "JUMP_EQ";
+    case INSTR_JUMP_NE: return "JUMP_NE";
+    case INSTR_JUMP_IN: return "JUMP_IN";
+    case INSTR_JUMP_NOT_IN: return "JUMP_NOT_IN";
+    case INSTR_JUMP_NOT_GLOB: return "JUMP_NOT_GLOB";
+    case INSTR_FOR_LOOP: return "FOR_LOOP";
+    case INSTR_SET_RESULT: return "SET_RESULT";
+    case INSTR_RETURN: return "RETURN";
+    case INSTR_POP: return "POP";
+    case INSTR_PUSH_LOCAL: return "PUSH_LOCAL";
+    case INSTR_POP_LOCAL: return "POP_LOCAL";
+    case INSTR_SET: return "SET";
+    case INSTR_APPEND: return "APPEND";
+    case INSTR_DEFAULT: return "DEFAULT";
+    case INSTR_PUSH_LOCAL_GROUP: return "PUSH_LOCAL_GROUP";
+    case INSTR_POP_LOCAL_GROUP: return "POP_LOCAL_GROUP";
+    case INSTR_SET_GROUP: return "SET_GROUP";
+    case INSTR_APPEND_GROUP: return "APPEND_GROUP";
+    case INSTR_DEFAULT_GROUP: return "DEFAULT_GROUP";
+    case INSTR_PUSH_ON: return "PUSH_ON";
+    case INSTR_POP_ON: return "POP_ON";
+    case INSTR_SET_ON: return "SET_ON";
+    case INSTR_APPEND_ON: return "APPEND_ON";
+    case INSTR_DEFAULT_ON: return "DEFAULT_ON";
+    case INSTR_CALL_RULE: return "CALL_RULE";
+    case INSTR_APPLY_MODIFIERS: return "APPLY_MODIFIERS";
+    case INSTR_APPLY_INDEX: return "APPLY_INDEX";
+    case INSTR_APPLY_INDEX_MODIFIERS: return "APPLY_INDEX_MODIFIERS";
+    case INSTR_APPLY_MODIFIERS_GROUP: return "APPLY_MODIFIERS_GROUP";
+    case INSTR_APPLY_INDEX_GROUP: return "APPLY_INDEX_GROUP";
+    case INSTR_APPLY_INDEX_MODIFIERS_GROUP: return "APPLY_INDEX_MODIFIERS_GROUP";
+    case INSTR_COMBINE_STRINGS: return "COMBINE_STRINGS";
+    case INSTR_INCLUDE: return "INCLUDE";
+    case INSTR_RULE: return "RULE";
+    case INSTR_ACTIONS: return "ACTIONS";
+    case INSTR_PUSH_MODULE: return "PUSH_MODULE";
+    case INSTR_POP_MODULE: return "POP_MODULE";
+    case INSTR_CLASS: return "CLASS";
+    case INSTR_APPEND_STRINGS: return "APPEND_STRINGS";
+    case INSTR_WRITE_FILE: return "WRITE_FILE";
+    case INSTR_OUTPUT_STRINGS: return "OUTPUT_STRINGS";
+    case INSTR_FOR_INIT: return "FOR_INIT";
+    case INSTR_PUSH_VAR_FIXED: return "PUSH_VAR_FIXED";
+    case INSTR_PUSH_LOCAL_FIXED: return "PUSH_LOCAL_FIXED";
+    case INSTR_POP_LOCAL_FIXED: return "POP_LOCAL_FIXED";
+    case INSTR_SET_FIXED: return "SET_FIXED";
+    case INSTR_APPEND_FIXED: return "APPEND_FIXED";
+    case INSTR_DEFAULT_FIXED: return "DEFAULT_FIXED";
+    case INSTR_BIND_MODULE_VARIABLES: return "BIND_MODULE_VARIABLES";
+    case INSTR_GET_GRIST: return "GET_GRIST";
+    case INSTR_GET_ON: return "GET_ON";
+    case INSTR_CALL_MEMBER_RULE: return "CALL_MEMBER_RULE";
+    case INSTR_DEBUG_LINE: return "DEBUG_LINE";
+    case INSTR_FOR_POP: return "FOR_POP";
+    case INSTR_PUSH_CONSTANTS: return "PUSH_CONSTANTS";
+    case INSTR_CLEAR_RESULT: return "CLEAR_RESULT";
+    case INSTR_PUSH_VAR_GRIST: return "PUSH_VAR_GRIST";
+    case INSTR_SET_RESULT_RETURN: return "SET_RESULT_RETURN";
+    }
+    return "?";
+}
+
+static bool instruction_is_branch( uint32_t op_code )
+{
+    switch ( op_code )
+    {
+    case INSTR_JUMP:
+    case INSTR_JUMP_EMPTY:
+    case INSTR_JUMP_NOT_EMPTY:
+    case INSTR_JUMP_LT:
+    case INSTR_JUMP_LE:
+    case INSTR_JUMP_GT:
+    case INSTR_JUMP_GE:
+    case INSTR_JUMP_EQ:
+    case INSTR_JUMP_NE:
+    case INSTR_JUMP_IN:
+    case INSTR_JUMP_NOT_IN:
+    case INSTR_JUMP_NOT_GLOB:
+    case INSTR_FOR_LOOP:
+    case INSTR_PUSH_ON:
+        return true;
+    }
+    return false;
+}
+
+/* Instructions whose argument is the index of a constant. */
+static bool instruction_has_constant( uint32_t op_code )
+{
+    switch ( op_code )
+    {
+    case INSTR_PUSH_CONSTANT:
+    case INSTR_PUSH_VAR:
+    case INSTR_PUSH_VAR_GRIST:
+    case INSTR_PUSH_LOCAL:
+    case INSTR_POP_LOCAL:
+    case INSTR_SET:
+    case INSTR_APPEND:
+    case INSTR_DEFAULT:
+    case INSTR_GET_ON:
+        return true;
+    }
+    return false;
+}
+
+/* The number of code words of the instruction. The instructions that take two
+ * arguments keep the second in the next word, with a constant index in its
+ * op_code.
+ */
+static int32_t instruction_size( uint32_t op_code )
+{
+    switch ( op_code )
+    {
+    case INSTR_CALL_RULE:
+    case INSTR_CALL_MEMBER_RULE:
+    case INSTR_PUSH_CONSTANTS:
+        return 2;
+    }
+    return 1;
+}
+
 typedef struct instruction
 {
     uint32_t op_code;
@@ -221,6 +393,7 @@ typedef struct _jam_function
     FUNCTION * generic;
     OBJECT * file;
     int32_t line;
+    rule_cache * rule_caches; /* by the index of the calling instruction */
 } JAM_FUNCTION;
 
 
@@ -723,8 +896,19 @@ static void function_default_named_variable( JAM_FUNCTION * function,
 #define QUOTE_EXPANDED(x) STRINGIFY(x)
 #define STRINGIFY(x) #x
 
+/* The rule cache of the rule call at code. */
+static rule_cache & function_rule_cache( JAM_FUNCTION * function,
+    instruction const * code )
+{
+    if ( !function->rule_caches )
+        function->rule_caches = (rule_cache *)BJAM_CALLOC( function->code_size,
+            sizeof( rule_cache ) );
+    return function->rule_caches[ code - function->code ];
+}
+
 static LIST * function_call_rule( JAM_FUNCTION * function, FRAME * frame,
-    STACK * s, int32_t n_args, char const * unexpanded, OBJECT * file, int32_t line )
+    STACK * s, int32_t n_args, char const * unexpanded, OBJECT * file, int32_t line,
+    rule_cache & cache )
 {
     FRAME inner;
     int32_t i;
@@ -779,12 +963,13 @@ static LIST * function_call_rule( JAM_FUNCTION * function, FRAME * frame,
         }
     }
 
-    result = evaluate_rule( bindrule( rulename, inner.module ), rulename, &inner );
+    result = evaluate_rule( bindrule( rulename, inner.module, cache ), rulename,
+        &inner );
     object_free( rulename );
     return result;
 }
 
-static LIST * function_call_member_rule( JAM_FUNCTION * function, FRAME * frame, STACK * s, int32_t n_args, OBJECT * rulename, OBJECT * file, int32_t line )
+static LIST * function_call_member_rule( JAM_FUNCTION * function, FRAME * frame, STACK * s, int32_t n_args, OBJECT * rulename, OBJECT * file, int32_t line, rule_cache & cache )
 {
     if ( n_args > LOL_MAX )
     {
@@ -802,7 +987,8 @@ static LIST * function_call_member_rule( JAM_FUNCTION * function, FRAME * frame,
     for (b2::lists::size_type i = 0; i < n_args; ++i)
         s->pop<LIST *>();
 
-    return call_member_rule( rulename, frame, std::move(first), std::move(args) );
+    return call_member_rule( rulename, frame, std::move(first), std::move(args),
+        &cache );
 }
 
 #undef QUOTE_EXPANDED
@@ -1827,6 +2013,279 @@ static int32_t compile_emit_actions( compiler * c, PARSE * parse )
     return (int32_t)( c->actions->size - 1 );
 }
 
+/*
+ * compile_dump() - print the code being compiled, for -d+14
+ */
+
+static void compile_dump( compiler * c, char const * title, OBJECT * file,
+    int32_t line )
+{
+    out_printf( "%s: %s:%d\n", title, object_str( file ), line );
+    for ( int32_t i = 0; i < c->code->size; ++i )
+    {
+        instruction const instr = dynamic_array_at( instruction, c->code, i );
+        out_printf( "%6d %-24s %d", i, instruction_name( instr.op_code ),
+            instr.arg );
+        if ( instruction_is_branch( instr.op_code ) )
+            out_printf( " -> %d", i + 1 + instr.arg );
+        else if ( instruction_has_constant( instr.op_code ) )
+            out_printf( " \"%s\"", object_str( dynamic_array_at( OBJECT *,
+                c->constants, instr.arg ) ) );
+        out_printf( "\n" );
+        if ( instr.op_code == INSTR_CALL_RULE
+            || instr.op_code == INSTR_CALL_MEMBER_RULE )
+        {
+            instruction const rule = dynamic_array_at( instruction, c->code,
+                ++i );
+            out_printf( "%6d %-24s %d \"%s\"\n", i, "", rule.arg,
+                object_str( dynamic_array_at( OBJECT *, c->constants,
+                    rule.op_code ) ) );
+        }
+        else if ( instr.op_code == INSTR_PUSH_CONSTANTS )
+        {
+            instruction const first = dynamic_array_at( instruction, c->code,
+                ++i );
+            out_printf( "%6d %-24s", i, "" );
+            for ( int32_t n = 0; n < instr.arg; ++n )
+                out_printf( " \"%s\"", object_str( dynamic_array_at( OBJECT *,
+                    c->constants, first.op_code + n ) ) );
+            out_printf( "\n" );
+        }
+    }
+}
+
+/*
+ * compile_optimize() - rewrite the compiled code into fewer instructions
+ */
+
+namespace
+{
+
+/* The code being optimized, with the branch targets as absolute positions. */
+struct optimizer
+{
+    compiler * c;
+    std::vector<instruction> code;
+    std::vector<bool> is_target;
+
+    optimizer( compiler * c_ ) : c( c_ )
+    {
+        code.assign( &dynamic_array_at( instruction, c->code, 0 ),
+            &dynamic_array_at( instruction, c->code, 0 ) + c->code->size );
+        for ( int32_t i = 0; i < int32_t( code.size() );
+            i += instruction_size( code[ i ].op_code ) )
+        {
+            if ( instruction_is_branch( code[ i ].op_code ) )
+                code[ i ].arg += i + 1;
+        }
+    }
+
+    ~optimizer()
+    {
+        c->code->size = 0;
+        for ( int32_t i = 0; i < int32_t( code.size() ); ++i )
+        {
+            instruction instr = code[ i ];
+            if ( instruction_is_branch( instr.op_code ) )
+                instr.arg -= i + 1;
+            compile_emit_instruction( c, instr );
+            int32_t const size = instruction_size( instr.op_code );
+            for ( int32_t j = 1; j < size; ++j )
+                compile_emit_instruction( c, code[ ++i ] );
+        }
+    }
+
+    OBJECT * constant( int32_t i )
+    {
+        return dynamic_array_at( OBJECT *, c->constants, i );
+    }
+
+    bool is( int32_t i, uint32_t op_code )
+    {
+        return i < int32_t( code.size() ) && code[ i ].op_code == op_code;
+    }
+
+    /* Where a jump to i ends up, going through any jumps at i. */
+    int32_t jump_destination( int32_t i )
+    {
+        for ( std::size_t n = 0; is( i, INSTR_JUMP ) && n < code.size(); ++n )
+            i = code[ i ].arg;
+        return i;
+    }
+
+    /* Jump to where the jumps at the target jump to. And instead of jumping to
+     * a return, return.
+     */
+    void thread_jumps()
+    {
+        for ( int32_t i = 0; i < int32_t( code.size() );
+            i += instruction_size( code[ i ].op_code ) )
+        {
+            if ( !instruction_is_branch( code[ i ].op_code ) )
+                continue;
+            code[ i ].arg = jump_destination( code[ i ].arg );
+            if ( code[ i ].op_code == INSTR_JUMP
+                && is( code[ i ].arg, INSTR_RETURN ) )
+            {
+                code[ i ].op_code = INSTR_RETURN;
+                code[ i ].arg = 0;
+            }
+        }
+    }
+
+    void find_targets()
+    {
+        is_target.assign( code.size() + 1, false );
+        for ( int32_t i = 0; i < int32_t( code.size() );
+            i += instruction_size( code[ i ].op_code ) )
+        {
+            if ( instruction_is_branch( code[ i ].op_code ) )
+                is_target[ code[ i ].arg ] = true;
+        }
+    }
+
+    /* The number of instructions from i that push single constants, and that
+     * are not jumped into.
+     */
+    int32_t constants_at( int32_t i )
+    {
+        int32_t result = 0;
+        while ( is( i + result, INSTR_PUSH_CONSTANT )
+            && ( result == 0 || !is_target[ i + result ] ) )
+            ++result;
+        return result;
+    }
+
+    /* Replace instruction sequences with fewer instructions that do the same.
+     * Only the first instruction of a sequence can be a branch target,
+     * otherwise jumps into the middle of it would be lost.
+     */
+    void fuse()
+    {
+        find_targets();
+        std::vector<instruction> result;
+        std::vector<int32_t> moved( code.size() + 1, 0 );
+        int32_t i = 0;
+        int32_t start = 0;
+        auto emit = [&]( uint32_t op_code, int32_t arg ) {
+            instruction instr;
+            instr.op_code = op_code;
+            instr.arg = arg;
+            result.push_back( instr );
+        };
+        /* The n instructions at i were replaced by the ones from start. */
+        auto consumed = [&]( int32_t n ) {
+            for ( int32_t end = i + n; i < end; ++i )
+                moved[ i ] = start;
+        };
+        while ( i < int32_t( code.size() ) )
+        {
+            start = int32_t( result.size() );
+            /* "PUSH_CONSTANT a, PUSH_CONSTANT b, PUSH_APPEND, ..." pushes the
+             * list "a b ...". */
+            int32_t count = 1;
+            int32_t end = i + 1;
+            if ( is( i, INSTR_PUSH_CONSTANT ) )
+            {
+                while ( is( end, INSTR_PUSH_CONSTANT ) && !is_target[ end ]
+                    && is( end + 1, INSTR_PUSH_APPEND )
+                    && !is_target[ end + 1 ] )
+                {
+                    count += 1;
+                    end += 2;
+                }
+            }
+            if ( count > 1 )
+            {
+                int32_t const first = c->constants->size;
+                compile_emit_constant( c, constant( code[ i ].arg ) );
+                for ( int32_t j = i + 1; j < end; j += 2 )
+                    compile_emit_constant( c, constant( code[ j ].arg ) );
+                emit( INSTR_PUSH_CONSTANTS, count );
+                emit( first, 0 );
+                consumed( end - i );
+                continue;
+            }
+
+            /* Concatenating only constants is a constant. */
+            count = constants_at( i );
+            if ( count > 1 && is( i + count, INSTR_COMBINE_STRINGS )
+                && code[ i + count ].arg == count && !is_target[ i + count ] )
+            {
+                /* The strings are pushed in reverse order. */
+                std::string s;
+                for ( int32_t j = i + count - 1; j >= i; --j )
+                    s += object_str( constant( code[ j ].arg ) );
+                OBJECT * value = object_new( s.c_str() );
+                emit( INSTR_PUSH_CONSTANT, compile_emit_constant( c, value ) );
+                object_free( value );
+                consumed( count + 1 );
+                continue;
+            }
+
+            if ( is( i, INSTR_PUSH_EMPTY ) && is( i + 1, INSTR_SET_RESULT )
+                && code[ i + 1 ].arg == 0 && !is_target[ i + 1 ] )
+            {
+                emit( INSTR_CLEAR_RESULT, 0 );
+                consumed( 2 );
+                continue;
+            }
+
+            if ( is( i, INSTR_PUSH_VAR ) && is( i + 1, INSTR_GET_GRIST )
+                && !is_target[ i + 1 ] )
+            {
+                emit( INSTR_PUSH_VAR_GRIST, code[ i ].arg );
+                consumed( 2 );
+                continue;
+            }
+
+            if ( is( i, INSTR_SET_RESULT ) && code[ i ].arg == 0
+                && is( i + 1, INSTR_RETURN ) && !is_target[ i + 1 ] )
+            {
+                emit( INSTR_SET_RESULT_RETURN, 0 );
+                consumed( 2 );
+                continue;
+            }
+
+            /* A jump to the next instruction does nothing. */
+            if ( is( i, INSTR_JUMP ) && code[ i ].arg == i + 1 )
+            {
+                consumed( 1 );
+                continue;
+            }
+
+            int32_t const size = instruction_size( code[ i ].op_code );
+            for ( int32_t j = 0; j < size; ++j )
+                result.push_back( code[ i + j ] );
+            consumed( size );
+        }
+        moved[ code.size() ] = int32_t( result.size() );
+
+        for ( int32_t j = 0; j < int32_t( result.size() );
+            j += instruction_size( result[ j ].op_code ) )
+        {
+            if ( instruction_is_branch( result[ j ].op_code ) )
+                result[ j ].arg = moved[ result[ j ].arg ];
+        }
+        code.swap( result );
+    }
+};
+
+} // namespace
+
+static void compile_optimize( compiler * c, OBJECT * file, int32_t line )
+{
+    if ( is_debug_bytecode() )
+        compile_dump( c, "compiled", file, line );
+    {
+        optimizer o( c );
+        o.thread_jumps();
+        o.fuse();
+    }
+    if ( is_debug_bytecode() )
+        compile_dump( c, "optimized", file, line );
+}
+
 static JAM_FUNCTION * compile_to_function( compiler * c )
 {
     JAM_FUNCTION * const result = (JAM_FUNCTION*)BJAM_MALLOC( sizeof( JAM_FUNCTION ) );
@@ -1872,6 +2331,8 @@ static JAM_FUNCTION * compile_to_function( compiler * c )
     result->file = 0;
     result->line = -1;
 
+    result->rule_caches = 0;
+
     return result;
 }
 
@@ -3342,6 +3803,7 @@ FUNCTION * function_compile( PARSE * parse )
     compiler_init( c );
     compile_parse( parse, c, RESULT_RETURN );
     compile_emit( c, INSTR_RETURN, 1 );
+    compile_optimize( c, parse->file, parse->line );
     result = compile_to_function( c );
     compiler_free( c );
     result->file = object_copy( parse->file );
@@ -3362,6 +3824,7 @@ FUNCTION * function_compile_actions( char const * actions, OBJECT * file,
     var_parse_actions_compile( parse, c );
     var_parse_actions_free( parse );
     compile_emit( c, INSTR_RETURN, 1 );
+    compile_optimize( c, file, line );
     result = compile_to_function( c );
     compiler_free( c );
     result->file = object_copy( file );
@@ -3369,6 +3832,263 @@ FUNCTION * function_compile_actions( char const * actions, OBJECT * file,
     return (FUNCTION *)result;
 }
 
+
+/*
+ * Serialization of compiled functions, for the compiled Jamfile cache. The
+ * format is only read by the same engine build that wrote it. Hence it is in
+ * the native layout and does not need to be portable. Any change to the
+ * instructions, or to this layout, needs a new function_format_version.
+ */
+
+namespace
+{
+
+struct function_writer
+{
+    std::string & out;
+
+    void i32( int32_t v )
+    {
+        out.append( reinterpret_cast<char const *>( &v ), sizeof( v ) );
+    }
+
+    void obj( OBJECT * o )
+    {
+        if ( !o )
+        {
+            i32( -1 );
+            return;
+        }
+        int32_t const size = int32_t( strlen( object_str( o ) ) );
+        i32( size );
+        out.append( object_str( o ), size );
+    }
+
+    void args( struct arg_list * formal, int32_t formal_count )
+    {
+        if ( !formal )
+        {
+            i32( -1 );
+            return;
+        }
+        i32( formal_count );
+        for ( int32_t i = 0; i < formal_count; ++i )
+        {
+            i32( formal[ i ].size );
+            for ( int32_t j = 0; j < formal[ i ].size; ++j )
+            {
+                i32( formal[ i ].args[ j ].flags );
+                obj( formal[ i ].args[ j ].type_name );
+                obj( formal[ i ].args[ j ].arg_name );
+                i32( formal[ i ].args[ j ].index );
+            }
+        }
+    }
+
+    void function( JAM_FUNCTION * f )
+    {
+        obj( f->file );
+        i32( f->line );
+        args( f->base.formal_arguments, f->base.num_formal_arguments );
+        i32( f->code_size );
+        for ( int32_t i = 0; i < f->code_size; ++i )
+        {
+            i32( int32_t( f->code[ i ].op_code ) );
+            i32( f->code[ i ].arg );
+        }
+        i32( f->num_constants );
+        for ( int32_t i = 0; i < f->num_constants; ++i )
+            obj( f->constants[ i ] );
+        i32( f->num_subfunctions );
+        for ( int32_t i = 0; i < f->num_subfunctions; ++i )
+        {
+            obj( f->functions[ i ].name );
+            i32( f->functions[ i ].local );
+            function( (JAM_FUNCTION *)f->functions[ i ].code );
+        }
+        i32( f->num_subactions );
+        for ( int32_t i = 0; i < f->num_subactions; ++i )
+        {
+            obj( f->actions[ i ].name );
+            i32( f->actions[ i ].flags );
+            function( (JAM_FUNCTION *)f->actions[ i ].command );
+        }
+    }
+};
+
+/* Reads what function_writer writes. Any truncated, or otherwise malformed,
+ * data makes the read fail. What was read up to that point is freed.
+ */
+struct function_reader
+{
+    char const * at;
+    char const * end;
+
+    bool i32( int32_t & v )
+    {
+        if ( end - at < int32_t( sizeof( v ) ) ) return false;
+        memcpy( &v, at, sizeof( v ) );
+        at += sizeof( v );
+        return true;
+    }
+
+    bool count( int32_t & v )
+    {
+        /* Every item takes at least one int32, hence a count that does not fit
+         * in the rest of the data is malformed.
+         */
+        return i32( v ) && v >= 0
+            && v <= ( end - at ) / int32_t( sizeof( int32_t ) );
+    }
+
+    bool obj( OBJECT * & o, bool optional = false )
+    {
+        int32_t size = 0;
+        o = nullptr;
+        if ( !i32( size ) ) return false;
+        if ( size == -1 ) return optional;
+        if ( size < 0 || end - at < size ) return false;
+        o = object_new_range( at, size );
+        at += size;
+        return true;
+    }
+
+    bool args( struct arg_list * & formal, int32_t & formal_count )
+    {
+        int32_t n = 0;
+        formal = nullptr;
+        formal_count = 0;
+        if ( !i32( n ) ) return false;
+        if ( n == -1 ) return true;
+        if ( n < 0 || n > ( end - at ) / int32_t( sizeof( int32_t ) ) )
+            return false;
+        formal = (struct arg_list *)BJAM_MALLOC( n * sizeof( struct arg_list ) );
+        while ( formal_count < n )
+        {
+            struct arg_list & a = formal[ formal_count++ ];
+            a.size = 0;
+            a.args = nullptr;
+            int32_t size = 0;
+            if ( !count( size ) ) return false;
+            a.args = (struct argument *)BJAM_MALLOC( size * sizeof( struct argument ) );
+            for ( ; a.size < size; ++a.size )
+            {
+                struct argument & arg = a.args[ a.size ];
+                if ( !i32( arg.flags ) ) return false;
+                if ( !obj( arg.type_name, true ) ) return false;
+                if ( !obj( arg.arg_name ) )
+                {
+                    if ( arg.type_name ) object_free( arg.type_name );
+                    return false;
+                }
+                if ( !i32( arg.index ) )
+                {
+                    ++a.size;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    JAM_FUNCTION * function()
+    {
+        OBJECT * file = nullptr;
+        int32_t line = 0;
+        if ( !obj( file ) ) return nullptr;
+        if ( !i32( line ) )
+        {
+            object_free( file );
+            return nullptr;
+        }
+
+        JAM_FUNCTION * f = (JAM_FUNCTION *)BJAM_MALLOC( sizeof( JAM_FUNCTION ) );
+        memset( (char *)f, 0, sizeof( JAM_FUNCTION ) );
+        f->base.type = FUNCTION_JAM;
+        f->base.reference_count = 1;
+        f->file = file;
+        f->line = line;
+        if ( !function_body( f ) )
+        {
+            function_free( (FUNCTION *)f );
+            return nullptr;
+        }
+        return f;
+    }
+
+    bool function_body( JAM_FUNCTION * f )
+    {
+        if ( !args( f->base.formal_arguments, f->base.num_formal_arguments ) )
+            return false;
+
+        int32_t n = 0;
+        if ( !count( n ) ) return false;
+        f->code = (instruction *)BJAM_MALLOC( n * sizeof( instruction ) );
+        for ( ; f->code_size < n; ++f->code_size )
+        {
+            int32_t op_code = 0;
+            if ( !i32( op_code ) || !i32( f->code[ f->code_size ].arg ) )
+                return false;
+            f->code[ f->code_size ].op_code = uint32_t( op_code );
+        }
+
+        if ( !count( n ) ) return false;
+        f->constants = (OBJECT * *)BJAM_MALLOC( n * sizeof( OBJECT * ) );
+        for ( ; f->num_constants < n; ++f->num_constants )
+            if ( !obj( f->constants[ f->num_constants ] ) ) return false;
+
+        if ( !count( n ) ) return false;
+        f->functions = (SUBFUNCTION *)BJAM_MALLOC( n * sizeof( SUBFUNCTION ) );
+        for ( ; f->num_subfunctions < n; ++f->num_subfunctions )
+        {
+            SUBFUNCTION & sub = f->functions[ f->num_subfunctions ];
+            if ( !obj( sub.name ) ) return false;
+            sub.code = nullptr;
+            if ( !i32( sub.local )
+                || !( sub.code = (FUNCTION *)function() ) )
+            {
+                object_free( sub.name );
+                return false;
+            }
+        }
+
+        if ( !count( n ) ) return false;
+        f->actions = (SUBACTION *)BJAM_MALLOC( n * sizeof( SUBACTION ) );
+        for ( ; f->num_subactions < n; ++f->num_subactions )
+        {
+            SUBACTION & sub = f->actions[ f->num_subactions ];
+            if ( !obj( sub.name ) ) return false;
+            sub.command = nullptr;
+            if ( !i32( sub.flags )
+                || !( sub.command = (FUNCTION *)function() ) )
+            {
+                object_free( sub.name );
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void function_write( FUNCTION * function, std::string & out )
+{
+    assert( function->type == FUNCTION_JAM );
+    assert( !( (JAM_FUNCTION *)function )->generic );
+    function_writer w { out };
+    w.function( (JAM_FUNCTION *)function );
+}
+
+FUNCTION * function_read( char const * & data, char const * end )
+{
+    function_reader r { data, end };
+    JAM_FUNCTION * result = r.function();
+    if ( result ) data = r.at;
+    return (FUNCTION *)result;
+}
+
+
 static std::string argument_list_to_string( struct arg_list * args, int32_t num_args );
 
 
@@ -3977,8 +4697,12 @@ FUNCTION * function_bind_variables( FUNCTION * f, module_t * module,
         memcpy( new_func->code, func->code, func->code_size * sizeof(
             instruction ) );
         new_func->generic = (FUNCTION *)func;
+        new_func->rule_caches = 0;
         func = new_func;
-        for ( i = 0; ; ++i )
+        /* The superinstructions that refer to variables, like PUSH_VAR_GRIST,
+         * are left to look up the variables by name.
+         */
+        for ( i = 0; i < func->code_size; ++i )
         {
             OBJECT * key;
             int32_t op_code;
@@ -3991,11 +4715,6 @@ FUNCTION * function_bind_variables( FUNCTION * f, module_t * module,
             case INSTR_SET: op_code = INSTR_SET_FIXED; break;
             case INSTR_APPEND: op_code = INSTR_APPEND_FIXED; break;
             case INSTR_DEFAULT: op_code = INSTR_DEFAULT_FIXED; break;
-            case INSTR_RETURN:
-                if( code->arg == 1 ) return (FUNCTION *)new_func;
-                else continue;
-            case INSTR_CALL_MEMBER_RULE:
-            case INSTR_CALL_RULE: ++i; continue;
             case INSTR_PUSH_MODULE:
                 {
                     int32_t depth = 1;
@@ -4012,15 +4731,15 @@ FUNCTION * function_bind_variables( FUNCTION * f, module_t * module,
                         case INSTR_POP_MODULE:
                             --depth;
                             break;
-                        case INSTR_CALL_RULE:
-                            ++i;
-                            break;
                         }
-                        ++i;
+                        i += instruction_size( code->op_code );
                     }
                     --i;
                 }
-            default: continue;
+                continue;
+            default:
+                i += instruction_size( code->op_code ) - 1;
+                continue;
             }
             key = func->constants[ code->arg ];
             if ( !( object_equal( key, constant_TMPDIR ) ||
@@ -4033,6 +4752,7 @@ FUNCTION * function_bind_variables( FUNCTION * f, module_t * module,
                 code->arg = module_add_fixed_var( module, key, counter );
             }
         }
+        return (FUNCTION *)new_func;
     }
 }
 
@@ -4048,16 +4768,13 @@ LIST * function_get_variables( FUNCTION * f )
         assert( f->type == FUNCTION_JAM );
         if ( func->generic ) func = ( JAM_FUNCTION * )func->generic;
 
-        for ( i = 0; ; ++i )
+        for ( i = 0; i < func->code_size; ++i )
         {
             OBJECT * var;
             code = func->code + i;
             switch ( code->op_code )
             {
             case INSTR_PUSH_LOCAL: break;
-            case INSTR_RETURN: return result;
-            case INSTR_CALL_MEMBER_RULE:
-            case INSTR_CALL_RULE: ++i; continue;
             case INSTR_PUSH_MODULE:
                 {
                     int32_t depth = 1;
@@ -4074,15 +4791,15 @@ LIST * function_get_variables( FUNCTION * f )
                         case INSTR_POP_MODULE:
                             --depth;
                             break;
-                        case INSTR_CALL_RULE:
-                            ++i;
-                            break;
                         }
-                        ++i;
+                        i += instruction_size( code->op_code );
                     }
                     --i;
                 }
-            default: continue;
+                continue;
+            default:
+                i += instruction_size( code->op_code ) - 1;
+                continue;
             }
             var = func->constants[ code->arg ];
             if ( !( object_equal( var, constant_TMPDIR ) ||
@@ -4094,6 +4811,7 @@ LIST * function_get_variables( FUNCTION * f )
                 result = list_push_back( result, var );
             }
         }
+        return result;
     }
 }
 
@@ -4118,6 +4836,8 @@ void function_free( FUNCTION * function_ )
         JAM_FUNCTION * func = (JAM_FUNCTION *)function_;
 
         BJAM_FREE( func->code );
+        if ( func->rule_caches )
+            BJAM_FREE( func->rule_caches );
 
         if ( func->generic )
             function_free( func->generic );
@@ -4340,7 +5060,37 @@ LIST * function_execute_write_file(
  * especially careful about stack push/pop.
  */
 
-LIST * function_run( FUNCTION * function_, FRAME * frame )
+/* The grists of the values, as for "$(x:G)". Frees the values. */
+static LIST * list_grist( LIST * vals )
+{
+    LIST * result = L0;
+    LISTITER iter, end;
+
+    for ( iter = list_begin( vals ), end = list_end( vals ); iter != end; ++iter )
+    {
+        OBJECT * new_object;
+        const char * value = object_str( list_item( iter ) );
+        const char * p;
+        if ( value[ 0 ] == '<' && ( p = strchr( value, '>' ) ) )
+        {
+            if( p[ 1 ] )
+                new_object = object_new_range( value, int32_t(p - value + 1) );
+            else
+                new_object = object_copy( list_item( iter ) );
+        }
+        else
+        {
+            new_object = object_copy( constant_empty );
+        }
+        result = list_push_back( result, new_object );
+    }
+
+    list_free( vals );
+    return result;
+}
+
+template <bool Profile>
+static LIST * function_run_impl( FUNCTION * function_, FRAME * frame )
 {
     _stack::check check_stack(frame, stack_global());
 
@@ -4382,6 +5132,94 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
     function = (JAM_FUNCTION *)function_;
     debug_on_enter_function( frame, function->base.rulename, function->file, function->line );
     code = function->code;
+
+#if FUNCTION_RUN_THREADED
+    static void * dispatch[ INSTR_MAX + 1 ];
+    if ( !dispatch[ 0 ] )
+    {
+        for ( auto & d : dispatch ) d = &&instr_invalid;
+        dispatch[ INSTR_PUSH_EMPTY ] = &&INSTR_PUSH_EMPTY_label;
+        dispatch[ INSTR_PUSH_CONSTANT ] = &&INSTR_PUSH_CONSTANT_label;
+        dispatch[ INSTR_PUSH_ARG ] = &&INSTR_PUSH_ARG_label;
+        dispatch[ INSTR_PUSH_VAR ] = &&INSTR_PUSH_VAR_label;
+        dispatch[ INSTR_PUSH_VAR_FIXED ] = &&INSTR_PUSH_VAR_FIXED_label;
+        dispatch[ INSTR_PUSH_GROUP ] = &&INSTR_PUSH_GROUP_label;
+        dispatch[ INSTR_PUSH_APPEND ] = &&INSTR_PUSH_APPEND_label;
+        dispatch[ INSTR_SWAP ] = &&INSTR_SWAP_label;
+        dispatch[ INSTR_POP ] = &&INSTR_POP_label;
+        dispatch[ INSTR_JUMP ] = &&INSTR_JUMP_label;
+        dispatch[ INSTR_JUMP_EMPTY ] = &&INSTR_JUMP_EMPTY_label;
+        dispatch[ INSTR_JUMP_NOT_EMPTY ] = &&INSTR_JUMP_NOT_EMPTY_label;
+        dispatch[ INSTR_JUMP_LT ] = &&INSTR_JUMP_LT_label;
+        dispatch[ INSTR_JUMP_LE ] = &&INSTR_JUMP_LE_label;
+        dispatch[ INSTR_JUMP_GT ] = &&INSTR_JUMP_GT_label;
+        dispatch[ INSTR_JUMP_GE ] = &&INSTR_JUMP_GE_label;
+        dispatch[ INSTR_JUMP_EQ ] = &&INSTR_JUMP_EQ_label;
+        dispatch[ INSTR_JUMP_NE ] = &&INSTR_JUMP_NE_label;
+        dispatch[ INSTR_JUMP_IN ] = &&INSTR_JUMP_IN_label;
+        dispatch[ INSTR_JUMP_NOT_IN ] = &&INSTR_JUMP_NOT_IN_label;
+        dispatch[ INSTR_FOR_INIT ] = &&INSTR_FOR_INIT_label;
+        dispatch[ INSTR_FOR_LOOP ] = &&INSTR_FOR_LOOP_label;
+        dispatch[ INSTR_FOR_POP ] = &&INSTR_FOR_POP_label;
+        dispatch[ INSTR_PUSH_CONSTANTS ] = &&INSTR_PUSH_CONSTANTS_label;
+        dispatch[ INSTR_CLEAR_RESULT ] = &&INSTR_CLEAR_RESULT_label;
+        dispatch[ INSTR_PUSH_VAR_GRIST ] = &&INSTR_PUSH_VAR_GRIST_label;
+        dispatch[ INSTR_SET_RESULT_RETURN ] = &&INSTR_SET_RESULT_RETURN_label;
+        dispatch[ INSTR_JUMP_NOT_GLOB ] = &&INSTR_JUMP_NOT_GLOB_label;
+        dispatch[ INSTR_SET_RESULT ] = &&INSTR_SET_RESULT_label;
+        dispatch[ INSTR_PUSH_RESULT ] = &&INSTR_PUSH_RESULT_label;
+        dispatch[ INSTR_RETURN ] = &&INSTR_RETURN_label;
+        dispatch[ INSTR_PUSH_LOCAL ] = &&INSTR_PUSH_LOCAL_label;
+        dispatch[ INSTR_POP_LOCAL ] = &&INSTR_POP_LOCAL_label;
+        dispatch[ INSTR_PUSH_LOCAL_FIXED ] = &&INSTR_PUSH_LOCAL_FIXED_label;
+        dispatch[ INSTR_POP_LOCAL_FIXED ] = &&INSTR_POP_LOCAL_FIXED_label;
+        dispatch[ INSTR_PUSH_LOCAL_GROUP ] = &&INSTR_PUSH_LOCAL_GROUP_label;
+        dispatch[ INSTR_POP_LOCAL_GROUP ] = &&INSTR_POP_LOCAL_GROUP_label;
+        dispatch[ INSTR_PUSH_ON ] = &&INSTR_PUSH_ON_label;
+        dispatch[ INSTR_POP_ON ] = &&INSTR_POP_ON_label;
+        dispatch[ INSTR_SET_ON ] = &&INSTR_SET_ON_label;
+        dispatch[ INSTR_APPEND_ON ] = &&INSTR_APPEND_ON_label;
+        dispatch[ INSTR_DEFAULT_ON ] = &&INSTR_DEFAULT_ON_label;
+        dispatch[ INSTR_GET_ON ] = &&INSTR_GET_ON_label;
+        dispatch[ INSTR_SET ] = &&INSTR_SET_label;
+        dispatch[ INSTR_APPEND ] = &&INSTR_APPEND_label;
+        dispatch[ INSTR_DEFAULT ] = &&INSTR_DEFAULT_label;
+        dispatch[ INSTR_SET_FIXED ] = &&INSTR_SET_FIXED_label;
+        dispatch[ INSTR_APPEND_FIXED ] = &&INSTR_APPEND_FIXED_label;
+        dispatch[ INSTR_DEFAULT_FIXED ] = &&INSTR_DEFAULT_FIXED_label;
+        dispatch[ INSTR_SET_GROUP ] = &&INSTR_SET_GROUP_label;
+        dispatch[ INSTR_APPEND_GROUP ] = &&INSTR_APPEND_GROUP_label;
+        dispatch[ INSTR_DEFAULT_GROUP ] = &&INSTR_DEFAULT_GROUP_label;
+        dispatch[ INSTR_CALL_RULE ] = &&INSTR_CALL_RULE_label;
+        dispatch[ INSTR_CALL_MEMBER_RULE ] = &&INSTR_CALL_MEMBER_RULE_label;
+        dispatch[ INSTR_RULE ] = &&INSTR_RULE_label;
+        dispatch[ INSTR_ACTIONS ] = &&INSTR_ACTIONS_label;
+        dispatch[ INSTR_APPLY_MODIFIERS ] = &&INSTR_APPLY_MODIFIERS_label;
+        dispatch[ INSTR_APPLY_INDEX ] = &&INSTR_APPLY_INDEX_label;
+        dispatch[ INSTR_APPLY_INDEX_MODIFIERS ] = &&INSTR_APPLY_INDEX_MODIFIERS_label;
+        dispatch[ INSTR_APPLY_MODIFIERS_GROUP ] = &&INSTR_APPLY_MODIFIERS_GROUP_label;
+        dispatch[ INSTR_APPLY_INDEX_GROUP ] = &&INSTR_APPLY_INDEX_GROUP_label;
+        dispatch[ INSTR_APPLY_INDEX_MODIFIERS_GROUP ] = &&INSTR_APPLY_INDEX_MODIFIERS_GROUP_label;
+        dispatch[ INSTR_COMBINE_STRINGS ] = &&INSTR_COMBINE_STRINGS_label;
+        dispatch[ INSTR_GET_GRIST ] = &&INSTR_GET_GRIST_label;
+        dispatch[ INSTR_INCLUDE ] = &&INSTR_INCLUDE_label;
+        dispatch[ INSTR_PUSH_MODULE ] = &&INSTR_PUSH_MODULE_label;
+        dispatch[ INSTR_POP_MODULE ] = &&INSTR_POP_MODULE_label;
+        dispatch[ INSTR_CLASS ] = &&INSTR_CLASS_label;
+        dispatch[ INSTR_BIND_MODULE_VARIABLES ] = &&INSTR_BIND_MODULE_VARIABLES_label;
+        dispatch[ INSTR_APPEND_STRINGS ] = &&INSTR_APPEND_STRINGS_label;
+        dispatch[ INSTR_WRITE_FILE ] = &&INSTR_WRITE_FILE_label;
+        dispatch[ INSTR_OUTPUT_STRINGS ] = &&INSTR_OUTPUT_STRINGS_label;
+        dispatch[ INSTR_DEBUG_LINE ] = &&INSTR_DEBUG_LINE_label;
+    }
+#define INSTR_CASE( op ) case op: op##_label
+#define INSTR_NEXT ++code; goto *dispatch[ code->op_code ]
+    goto *dispatch[ code->op_code ];
+#else
+#define INSTR_CASE( op ) case op
+#define INSTR_NEXT break
+#endif
+
     for ( ; ; )
     {
         switch ( code->op_code )
@@ -4391,49 +5229,71 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
          * Basic stack manipulation
          */
 
-        case INSTR_PUSH_EMPTY:
+        INSTR_CASE( INSTR_PUSH_EMPTY ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_EMPTY);
             s->push( L0 );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_EMPTY);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_CONSTANT:
+        INSTR_CASE( INSTR_PUSH_CONSTANT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_CONSTANT);
             OBJECT * value = function_get_constant( function, code->arg );
             s->push( list_new( object_copy( value ) ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_CONSTANT);
-            break;
         }
+        INSTR_NEXT;
+
+        INSTR_CASE( INSTR_PUSH_CONSTANTS ):
+        {
+            PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_CONSTANTS);
+            LIST * value = L0;
+            for ( int32_t i = 0; i < code->arg; ++i )
+                value = list_push_back( value, object_copy(
+                    function_get_constant( function, code[ 1 ].op_code + i ) ) );
+            s->push( value );
+            ++code;
+            PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_CONSTANTS);
+        }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_ARG:
+        INSTR_CASE( INSTR_PUSH_ARG ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_ARG);
             s->push( frame_get_local( frame, code->arg ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_ARG);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_VAR:
+        INSTR_CASE( INSTR_PUSH_VAR ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_VAR);
             s->push( function_get_variable( function, frame, code->arg ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_VAR);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_VAR_FIXED:
+        INSTR_CASE( INSTR_PUSH_VAR_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_VAR_FIXED);
             s->push( list_copy( frame->module->fixed_variables[ code->arg
                 ] ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_VAR_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_GROUP:
+        INSTR_CASE( INSTR_PUSH_VAR_GRIST ):
+        {
+            PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_VAR_GRIST);
+            s->push( list_grist( function_get_variable( function, frame,
+                code->arg ) ) );
+            PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_VAR_GRIST);
+        }
+        INSTR_NEXT;
+
+        INSTR_CASE( INSTR_PUSH_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_GROUP);
             LIST * value = L0;
@@ -4447,68 +5307,68 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             s->push( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_APPEND:
+        INSTR_CASE( INSTR_PUSH_APPEND ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_APPEND);
             r = s->pop<LIST *>();
             l = s->pop<LIST *>();
             s->push( list_append( l, r ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_APPEND);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_SWAP:
+        INSTR_CASE( INSTR_SWAP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SWAP);
             s->swap<LIST*>( 0, code->arg );
             PROFILE_EXIT_LOCAL(function_run_INSTR_SWAP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP:
+        INSTR_CASE( INSTR_POP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP);
             list_free( s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Branch instructions
          */
 
-        case INSTR_JUMP:
+        INSTR_CASE( INSTR_JUMP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP);
             code += code->arg;
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_EMPTY:
+        INSTR_CASE( INSTR_JUMP_EMPTY ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_EMPTY);
             l = s->pop<LIST *>();
             if ( !list_cmp( l, L0 ) ) code += code->arg;
             list_free( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_EMPTY);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_NOT_EMPTY:
+        INSTR_CASE( INSTR_JUMP_NOT_EMPTY ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_NOT_EMPTY);
             l = s->pop<LIST *>();
             if ( list_cmp( l, L0 ) ) code += code->arg;
             list_free( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_NOT_EMPTY);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_LT:
+        INSTR_CASE( INSTR_JUMP_LT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_LT);
             r = s->pop<LIST *>();
@@ -4517,10 +5377,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_LT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_LE:
+        INSTR_CASE( INSTR_JUMP_LE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_LE);
             r = s->pop<LIST *>();
@@ -4529,10 +5389,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_LE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_GT:
+        INSTR_CASE( INSTR_JUMP_GT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_GT);
             r = s->pop<LIST *>();
@@ -4541,10 +5401,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_GT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_GE:
+        INSTR_CASE( INSTR_JUMP_GE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_GE);
             r = s->pop<LIST *>();
@@ -4553,10 +5413,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_GE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_EQ:
+        INSTR_CASE( INSTR_JUMP_EQ ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_EQ);
             r = s->pop<LIST *>();
@@ -4565,10 +5425,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_EQ);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_NE:
+        INSTR_CASE( INSTR_JUMP_NE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_NE);
             r = s->pop<LIST *>();
@@ -4577,10 +5437,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free(l);
             list_free(r);
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_NE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_IN:
+        INSTR_CASE( INSTR_JUMP_IN ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_IN);
             r = s->pop<LIST *>();
@@ -4589,10 +5449,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free(l);
             list_free(r);
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_IN);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_JUMP_NOT_IN:
+        INSTR_CASE( INSTR_JUMP_NOT_IN ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_NOT_IN);
             r = s->pop<LIST *>();
@@ -4601,23 +5461,23 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( l );
             list_free( r );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_NOT_IN);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * For
          */
 
-        case INSTR_FOR_INIT:
+        INSTR_CASE( INSTR_FOR_INIT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_FOR_INIT);
             l = s->top<LIST*>();
             s->push( list_begin( l ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_FOR_INIT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_FOR_LOOP:
+        INSTR_CASE( INSTR_FOR_LOOP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_FOR_LOOP);
             LISTITER iter = s->pop<LISTITER>();
@@ -4635,23 +5495,23 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 s->push( r );
             }
             PROFILE_EXIT_LOCAL(function_run_INSTR_FOR_LOOP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_FOR_POP:
+        INSTR_CASE( INSTR_FOR_POP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_FOR_POP);
             s->pop<LISTITER>();
             list_free( s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_FOR_POP);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Switch
          */
 
-        case INSTR_JUMP_NOT_GLOB:
+        INSTR_CASE( INSTR_JUMP_NOT_GLOB ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_JUMP_NOT_GLOB);
             char const * pattern;
@@ -4666,14 +5526,14 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );
             list_free( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_JUMP_NOT_GLOB);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Return
          */
 
-        case INSTR_SET_RESULT:
+        INSTR_CASE( INSTR_SET_RESULT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SET_RESULT);
             list_free( result );
@@ -4682,19 +5542,38 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             else
                 result = list_copy( s->top<LIST*>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_SET_RESULT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_RESULT:
+        INSTR_CASE( INSTR_PUSH_RESULT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_RESULT);
             s->push( result );
             result = L0;
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_RESULT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_RETURN:
+        INSTR_CASE( INSTR_CLEAR_RESULT ):
+        {
+            PROFILE_ENTER_LOCAL(function_run_INSTR_CLEAR_RESULT);
+            list_free( result );
+            result = L0;
+            PROFILE_EXIT_LOCAL(function_run_INSTR_CLEAR_RESULT);
+        }
+        INSTR_NEXT;
+
+        INSTR_CASE( INSTR_SET_RESULT_RETURN ):
+        {
+            PROFILE_ENTER_LOCAL(function_run_INSTR_SET_RESULT_RETURN);
+            list_free( result );
+            result = s->pop<LIST *>();
+            PROFILE_EXIT_LOCAL(function_run_INSTR_SET_RESULT_RETURN);
+        }
+        goto instr_return;
+
+        INSTR_CASE( INSTR_RETURN ):
+        instr_return:
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_RETURN);
             if ( function_->formal_arguments )
@@ -4711,25 +5590,25 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
          * Local variables
          */
 
-        case INSTR_PUSH_LOCAL:
+        INSTR_CASE( INSTR_PUSH_LOCAL ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_LOCAL);
             LIST * value = s->pop<LIST *>();
             s->push( function_swap_variable( function, frame, code->arg,
                 value ), frame );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_LOCAL);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP_LOCAL:
+        INSTR_CASE( INSTR_POP_LOCAL ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP_LOCAL);
             function_set_variable( function, frame, code->arg, s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP_LOCAL);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_LOCAL_FIXED:
+        INSTR_CASE( INSTR_PUSH_LOCAL_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_LOCAL_FIXED);
             LIST * value = s->pop<LIST *>();
@@ -4738,10 +5617,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             s->push( *ptr );
             *ptr = value;
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_LOCAL_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP_LOCAL_FIXED:
+        INSTR_CASE( INSTR_POP_LOCAL_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP_LOCAL_FIXED);
             LIST * value = s->pop<LIST *>();
@@ -4750,10 +5629,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( *ptr );
             *ptr = value;
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP_LOCAL_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_PUSH_LOCAL_GROUP:
+        INSTR_CASE( INSTR_PUSH_LOCAL_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_LOCAL_GROUP);
             LIST * const value = s->pop<LIST *>();
@@ -4767,10 +5646,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( value );
             s->push( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_LOCAL_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP_LOCAL_GROUP:
+        INSTR_CASE( INSTR_POP_LOCAL_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP_LOCAL_GROUP);
             LISTITER iter;
@@ -4784,14 +5663,14 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                     s->pop<LIST *>() );
             list_free( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP_LOCAL_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * on $(TARGET) variables
          */
 
-        case INSTR_PUSH_ON:
+        INSTR_CASE( INSTR_PUSH_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_ON);
             LIST * targets = s->top<LIST*>();
@@ -4811,10 +5690,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 code += code->arg;
             }
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_ON);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP_ON:
+        INSTR_CASE( INSTR_POP_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP_ON);
             LIST * result = s->pop<LIST *>();
@@ -4827,10 +5706,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( targets );
             s->push( result );
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP_ON);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_SET_ON:
+        INSTR_CASE( INSTR_SET_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SET_ON);
             LIST * targets = s->pop<LIST *>();
@@ -4865,10 +5744,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( targets );
             s->push( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_SET_ON);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPEND_ON:
+        INSTR_CASE( INSTR_APPEND_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPEND_ON);
             LIST * targets = s->pop<LIST *>();
@@ -4890,10 +5769,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( targets );
             s->push( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPEND_ON);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_DEFAULT_ON:
+        INSTR_CASE( INSTR_DEFAULT_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_DEFAULT_ON);
             LIST * targets = s->pop<LIST *>();
@@ -4915,11 +5794,11 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( targets );
             s->push( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_DEFAULT_ON);
-            break;
         }
+        INSTR_NEXT;
 
         /* [ on $(target) return $(variable) ] */
-        case INSTR_GET_ON:
+        INSTR_CASE( INSTR_GET_ON ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_GET_ON);
             LIST * targets = s->pop<LIST *>();
@@ -4947,41 +5826,41 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( targets );
             s->push( list_copy( result ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_GET_ON);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Variable setting
          */
 
-        case INSTR_SET:
+        INSTR_CASE( INSTR_SET ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SET);
             function_set_variable( function, frame, code->arg,
                 s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_SET);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPEND:
+        INSTR_CASE( INSTR_APPEND ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPEND);
             function_append_variable( function, frame, code->arg,
                 s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPEND);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_DEFAULT:
+        INSTR_CASE( INSTR_DEFAULT ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_DEFAULT);
             function_default_variable( function, frame, code->arg,
                 s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_DEFAULT);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_SET_FIXED:
+        INSTR_CASE( INSTR_SET_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SET_FIXED);
             LIST * * ptr = &frame->module->fixed_variables[ code->arg ];
@@ -4989,20 +5868,20 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( *ptr );
             *ptr = s->pop<LIST *>();
             PROFILE_EXIT_LOCAL(function_run_INSTR_SET_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPEND_FIXED:
+        INSTR_CASE( INSTR_APPEND_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPEND_FIXED);
             LIST * * ptr = &frame->module->fixed_variables[ code->arg ];
             assert( code->arg < frame->module->num_fixed_variables );
             *ptr = list_append( *ptr, s->pop<LIST *>() );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPEND_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_DEFAULT_FIXED:
+        INSTR_CASE( INSTR_DEFAULT_FIXED ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_DEFAULT_FIXED);
             LIST * * ptr = &frame->module->fixed_variables[ code->arg ];
@@ -5013,10 +5892,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             else
                 list_free( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_DEFAULT_FIXED);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_SET_GROUP:
+        INSTR_CASE( INSTR_SET_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_SET_GROUP);
             LIST * value = s->pop<LIST *>();
@@ -5029,10 +5908,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( vars );
             list_free( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_SET_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPEND_GROUP:
+        INSTR_CASE( INSTR_APPEND_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPEND_GROUP);
             LIST * value = s->pop<LIST *>();
@@ -5045,10 +5924,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( vars );
             list_free( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPEND_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_DEFAULT_GROUP:
+        INSTR_CASE( INSTR_DEFAULT_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_DEFAULT_GROUP);
             LIST * value = s->pop<LIST *>();
@@ -5061,58 +5940,59 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( vars );
             list_free( value );
             PROFILE_EXIT_LOCAL(function_run_INSTR_DEFAULT_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Rules
          */
 
-        case INSTR_CALL_RULE:
+        INSTR_CASE( INSTR_CALL_RULE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_CALL_RULE);
             char const * unexpanded = object_str( function_get_constant(
                 function, code[ 1 ].op_code ) );
             LIST * result = function_call_rule( function, frame, s, code->arg,
-                unexpanded, function->file, code[ 1 ].arg );
+                unexpanded, function->file, code[ 1 ].arg,
+                function_rule_cache( function, code ) );
             s->push( result );
             ++code;
             PROFILE_EXIT_LOCAL(function_run_INSTR_CALL_RULE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_CALL_MEMBER_RULE:
+        INSTR_CASE( INSTR_CALL_MEMBER_RULE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_CALL_MEMBER_RULE);
             OBJECT * rule_name = function_get_constant( function, code[1].op_code );
-            LIST * result = function_call_member_rule( function, frame, s, code->arg, rule_name, function->file, code[1].arg );
+            LIST * result = function_call_member_rule( function, frame, s, code->arg, rule_name, function->file, code[1].arg, function_rule_cache( function, code ) );
             s->push( result );
             ++code;
             PROFILE_EXIT_LOCAL(function_run_INSTR_CALL_MEMBER_RULE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_RULE:
+        INSTR_CASE( INSTR_RULE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_RULE);
             function_set_rule( function, frame, s, code->arg );
             PROFILE_EXIT_LOCAL(function_run_INSTR_RULE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_ACTIONS:
+        INSTR_CASE( INSTR_ACTIONS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_ACTIONS);
             function_set_actions( function, frame, s, code->arg );
             PROFILE_EXIT_LOCAL(function_run_INSTR_ACTIONS);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Variable expansion
          */
 
-        case INSTR_APPLY_MODIFIERS:
+        INSTR_CASE( INSTR_APPLY_MODIFIERS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_MODIFIERS);
             int32_t n;
@@ -5128,10 +6008,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );  /* pop modifiers */
             s->push( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_MODIFIERS);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPLY_INDEX:
+        INSTR_CASE( INSTR_APPLY_INDEX ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_INDEX);
             l = apply_subscript( s );
@@ -5139,10 +6019,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( s->pop<LIST *>() );
             s->push( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_INDEX);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPLY_INDEX_MODIFIERS:
+        INSTR_CASE( INSTR_APPLY_INDEX_MODIFIERS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_INDEX_MODIFIERS);
             int32_t i;
@@ -5160,10 +6040,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );  /* pop modifiers */
             s->push( l );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_INDEX_MODIFIERS);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPLY_MODIFIERS_GROUP:
+        INSTR_CASE( INSTR_APPLY_MODIFIERS_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_MODIFIERS_GROUP);
             int32_t i;
@@ -5187,10 +6067,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );  /* pop modifiers */
             s->push( result );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_MODIFIERS_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPLY_INDEX_GROUP:
+        INSTR_CASE( INSTR_APPLY_INDEX_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_INDEX_GROUP);
             LIST * vars = s->pop<LIST *>();
@@ -5208,10 +6088,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( s->pop<LIST *>() );
             s->push( result );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_INDEX_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPLY_INDEX_MODIFIERS_GROUP:
+        INSTR_CASE( INSTR_APPLY_INDEX_MODIFIERS_GROUP ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPLY_INDEX_MODIFIERS_GROUP);
             int32_t i;
@@ -5237,10 +6117,10 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );  /* pop modifiers */
             s->push( result );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPLY_INDEX_MODIFIERS_GROUP);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_COMBINE_STRINGS:
+        INSTR_CASE( INSTR_COMBINE_STRINGS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_COMBINE_STRINGS);
             LIST * * const stack_pos = s->get<LIST*>();
@@ -5255,42 +6135,18 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
                 list_free( s->pop<LIST *>() );
             s->push( result );
             PROFILE_EXIT_LOCAL(function_run_INSTR_COMBINE_STRINGS);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_GET_GRIST:
+        INSTR_CASE( INSTR_GET_GRIST ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_GET_GRIST);
-            LIST * vals = s->pop<LIST *>();
-            LIST * result = L0;
-            LISTITER iter, end;
-
-            for ( iter = list_begin( vals ), end = list_end( vals ); iter != end; ++iter )
-            {
-                OBJECT * new_object;
-                const char * value = object_str( list_item( iter ) );
-                const char * p;
-                if ( value[ 0 ] == '<' && ( p = strchr( value, '>' ) ) )
-                {
-                    if( p[ 1 ] )
-                        new_object = object_new_range( value, int32_t(p - value + 1) );
-                    else
-                        new_object = object_copy( list_item( iter ) );
-                }
-                else
-                {
-                    new_object = object_copy( constant_empty );
-                }
-                result = list_push_back( result, new_object );
-            }
-
-            list_free( vals );
-            s->push( result );
+            s->push( list_grist( s->pop<LIST *>() ) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_GET_GRIST);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_INCLUDE:
+        INSTR_CASE( INSTR_INCLUDE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_INCLUDE);
             b2::list_ref nt( s->pop<LIST *>(), true );
@@ -5303,14 +6159,14 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
 #endif
             }
             PROFILE_EXIT_LOCAL(function_run_INSTR_INCLUDE);
-            break;
         }
+        INSTR_NEXT;
 
         /*
          * Classes and modules
          */
 
-        case INSTR_PUSH_MODULE:
+        INSTR_CASE( INSTR_PUSH_MODULE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_PUSH_MODULE);
             LIST * const module_name = s->pop<LIST *>();
@@ -5321,18 +6177,18 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( module_name );
             s->push( b2::ensure_valid(outer_module) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_PUSH_MODULE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_POP_MODULE:
+        INSTR_CASE( INSTR_POP_MODULE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_POP_MODULE);
             frame->module = b2::ensure_valid(s->pop<module_t *>());
             PROFILE_EXIT_LOCAL(function_run_INSTR_POP_MODULE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_CLASS:
+        INSTR_CASE( INSTR_CLASS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_CLASS);
             LIST * bases = s->pop<LIST *>();
@@ -5348,18 +6204,18 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
 
             s->push( b2::ensure_valid(outer_module) );
             PROFILE_EXIT_LOCAL(function_run_INSTR_CLASS);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_BIND_MODULE_VARIABLES:
+        INSTR_CASE( INSTR_BIND_MODULE_VARIABLES ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_BIND_MODULE_VARIABLES);
             module_bind_variables( frame->module );
             PROFILE_EXIT_LOCAL(function_run_INSTR_BIND_MODULE_VARIABLES);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_APPEND_STRINGS:
+        INSTR_CASE( INSTR_APPEND_STRINGS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_APPEND_STRINGS);
             string buf[ 1 ];
@@ -5368,11 +6224,11 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             s->push( list_new( object_new( buf->value ) ) );
             string_free( buf );
             PROFILE_EXIT_LOCAL(function_run_INSTR_APPEND_STRINGS);
-            break;
         }
+        INSTR_NEXT;
 
         // WRITE_FILE( LIST*1 filename,  LIST*1 modifiers[N], LIST*1 contents )
-        case INSTR_WRITE_FILE:
+        INSTR_CASE( INSTR_WRITE_FILE ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_WRITE_FILE);
             // Get expanded filename.
@@ -5394,33 +6250,49 @@ LIST * function_run( FUNCTION * function_, FRAME * frame )
             list_free( filename_mod.inner );
             list_free( contents );
             PROFILE_EXIT_LOCAL(function_run_INSTR_WRITE_FILE);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_OUTPUT_STRINGS:
+        INSTR_CASE( INSTR_OUTPUT_STRINGS ):
         {
             PROFILE_ENTER_LOCAL(function_run_INSTR_OUTPUT_STRINGS);
             string * const buf = s->top<LIST*, string*>( code->arg );
             combine_strings( s, code->arg, buf );
             PROFILE_EXIT_LOCAL(function_run_INSTR_OUTPUT_STRINGS);
-            break;
         }
+        INSTR_NEXT;
 
-        case INSTR_DEBUG_LINE:
+        INSTR_CASE( INSTR_DEBUG_LINE ):
         {
             debug_on_instruction( frame, function->file, code->arg );
-            break;
         }
+        INSTR_NEXT;
 
+#if FUNCTION_RUN_THREADED
+        default:
+        instr_invalid:
+            assert( !"invalid instruction" );
+            break;
+#endif
         }
         ++code;
     }
 
+#undef INSTR_CASE
+#undef INSTR_NEXT
+
     PROFILE_EXIT_LOCAL(function_run);
 
     return L0;
 }
 
+LIST * function_run( FUNCTION * function_, FRAME * frame )
+{
+    return is_debug_profile()
+        ? function_run_impl<true>( function_, frame )
+        : function_run_impl<false>( function_, frame );
+}
+
 
 void function_done( void )
 {
@@ -36,6 +36,15 @@ FUNCTION * function_compile_actions(
 	const char * actions, OBJECT * file, int32_t line);
 void function_run_actions(FUNCTION * function, FRAME * frame, string * out);
 
+// The version of the instructions, and of the layout, that function_write
+// writes. Changed with any change to either of them.
+constexpr int function_format_version = 1;
+// Serialize a compiled, and not bound, function by appending it to out.
+void function_write(FUNCTION * function, std::string & out);
+// Read a function serialized by function_write from the data, advancing data
+// past it. Returns nullptr if the data is malformed.
+FUNCTION * function_read(const char *& data, const char * end);
+
 FUNCTION * function_bind_variables(
 	FUNCTION * f, module_t * module, int32_t * counter);
 FUNCTION * function_unbind_variables(FUNCTION * f);
@@ -7,6 +7,12 @@
 /*
  * hash.c - simple in-memory hashing routines
  *
+ * The table is open addressed, with linear probing, and keeps the hash of the
+ * key in each slot next to the pointer to the item. Hence looking up a key
+ * only looks at the items with the same hash. The items themselves are kept
+ * in separately allocated arrays so that they do not move when the table
+ * grows.
+ *
  * External routines:
  *     hashinit() - initialize a hash table, returning a handle
  *     hashitem() - find a record in the table, and optionally enter a new one
@@ -14,6 +20,7 @@
  *
  * Internal routines:
  *     hashrehash() - resize and rebuild hp->tab, the hash table
+ *     hashmore()   - allocate more items
  */
 
 #include "jam.h"
@@ -29,12 +36,13 @@
 #define HASH_DEBUG_PROFILE 1
 */
 
-/* Header attached to all hash table data items. */
+/* A slot in the table, empty when it has no data. */
 
-typedef struct item ITEM;
-struct item
+typedef struct slot SLOT;
+struct slot
 {
-    ITEM * next;
+    uint32_t keyval;
+    HASHDATA * data;
 };
 
 #define MAX_LISTS 32
@@ -42,15 +50,16 @@ struct item
 struct hash
 {
     /*
-     * the hash table, just an array of item pointers
+     * the hash table, an array of a power of two slots
      */
     struct
     {
         int32_t nel;
-        ITEM * * base;
+        int32_t count;  /* used slots */
+        int32_t shift;  /* 32 - log2( nel ) */
+        SLOT * base;
     } tab;
 
-    int32_t bloat;  /* tab.nel / items.nel */
     int32_t inel;   /* initial number of elements */
 
     /*
@@ -59,17 +68,16 @@ struct hash
      */
     struct
     {
-        int32_t more;     /* how many more ITEMs fit in lists[ list ] */
-        ITEM * free;  /* free list of items */
-        char * next;  /* where to put more ITEMs in lists[ list ] */
-        int32_t size;     /* sizeof( ITEM ) + aligned datalen */
-        int32_t nel;      /* total ITEMs held by all lists[] */
+        int32_t more;     /* how many more items fit in lists[ list ] */
+        char * next;  /* where to put more items in lists[ list ] */
+        int32_t size;     /* aligned datalen */
+        int32_t nel;      /* total items held by all lists[] */
         int32_t list;     /* index into lists[] */
 
         struct
         {
-            int32_t nel;      /* total ITEMs held by this list */
-            char * base;  /* base of ITEMs array */
+            int32_t nel;      /* total items held by this list */
+            char * base;  /* base of items array */
         } lists[ MAX_LISTS ];
     } items;
 
@@ -77,6 +85,7 @@ struct hash
 };
 
 static void hashrehash( struct hash * );
+static void hashmore( struct hash * );
 static void hashstat( struct hash * );
 
 static uint32_t hash_keyval( OBJECT * key )
@@ -84,14 +93,19 @@ static uint32_t hash_keyval( OBJECT * key )
     return object_hash( key );
 }
 
-#define hash_bucket(hp, keyval) ((hp)->tab.base + ((keyval) % (hp)->tab.nel))
+/* The first slot to look at for the key hash. The multiplication spreads the
+ * hash bits into the top bits which select the slot.
+ */
+#define hash_home(hp, keyval) \
+    ((int32_t)(((keyval) * UINT32_C(2654435769)) >> (hp)->tab.shift))
+#define hash_next(hp, i) (((i) + 1) & ((hp)->tab.nel - 1))
 
 #define hash_data_key(data) (*(OBJECT * *)(data))
-#define hash_item_data(item) ((HASHDATA *)((char *)item + sizeof(ITEM)))
-#define hash_item_key(item) (hash_data_key(hash_item_data(item)))
 
+#define ALIGNED(x) ((x + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
 
-#define ALIGNED(x) ((x + sizeof(ITEM) - 1) & ~(sizeof(ITEM) - 1))
+/* The table grows to keep it at most half full. */
+#define MAX_LOAD(nel) ((nel) / 2)
 
 /*
  * hashinit() - initialize a hash table, returning a handle
@@ -101,12 +115,12 @@ struct hash * hashinit( int32_t datalen, char const * name )
 {
     struct hash * hp = (struct hash *)BJAM_MALLOC( sizeof( *hp ) );
 
-    hp->bloat = 3;
     hp->tab.nel = 0;
+    hp->tab.count = 0;
+    hp->tab.shift = 32;
     hp->tab.base = 0;
     hp->items.more = 0;
-    hp->items.free = 0;
-    hp->items.size = sizeof( ITEM ) + ALIGNED( datalen );
+    hp->items.size = ALIGNED( datalen );
     hp->items.list = -1;
     hp->items.nel = 0;
     hp->inel = 11;  /* 47 */
@@ -117,29 +131,23 @@ struct hash * hashinit( int32_t datalen, char const * name )
 
 
 /*
- * hash_search() - Find the hash item for the given data.
+ * hash_search() - Find the slot for the given key.
  *
- * Returns a pointer to a hashed item with the given key. If given a 'previous'
- * pointer, makes it point to the item prior to the found item in the same
- * bucket or to 0 if our item is the first item in its bucket.
+ * Returns the slot with the given key, or the empty slot where to insert it.
  */
 
-static ITEM * hash_search( struct hash * hp, uint32_t keyval,
-    OBJECT * keydata, ITEM * * previous )
+static SLOT * hash_search( struct hash * hp, uint32_t keyval,
+    OBJECT * keydata )
 {
-    ITEM * i = *hash_bucket( hp, keyval );
-    ITEM * p = 0;
-    for ( ; i; i = i->next )
+    int32_t i = hash_home( hp, keyval );
+    for ( ; hp->tab.base[ i ].data; i = hash_next( hp, i ) )
     {
-        if ( object_equal( hash_item_key( i ), keydata ) )
-        {
-            if ( previous )
-                *previous = p;
-            return i;
-        }
-        p = i;
+        SLOT * const s = hp->tab.base + i;
+        if ( s->keyval == keyval && object_equal( hash_data_key( s->data ),
+            keydata ) )
+            return s;
     }
-    return 0;
+    return hp->tab.base + i;
 }
 
 
@@ -149,7 +157,7 @@ static ITEM * hash_search( struct hash * hp, uint32_t keyval,
 
 HASHDATA * hash_insert( struct hash * hp, OBJECT * key, int32_t * found )
 {
-    ITEM * i;
+    SLOT * s;
     uint32_t keyval = hash_keyval( key );
 
     #ifdef HASH_DEBUG_PROFILE
@@ -158,31 +166,21 @@ HASHDATA * hash_insert( struct hash * hp, OBJECT * key, int32_t * found )
         profile_enter( 0, prof );
     #endif
 
-    if ( !hp->items.more )
+    if ( hp->tab.count >= MAX_LOAD( hp->tab.nel ) )
         hashrehash( hp );
 
-    i = hash_search( hp, keyval, key, 0 );
-    if ( i )
+    s = hash_search( hp, keyval, key );
+    if ( s->data )
         *found = 1;
     else
     {
-        ITEM * * base = hash_bucket( hp, keyval );
-
-        /* Try to grab one from the free list. */
-        if ( hp->items.free )
-        {
-            i = hp->items.free;
-            hp->items.free = i->next;
-            assert( !hash_item_key( i ) );
-        }
-        else
-        {
-            i = (ITEM *)hp->items.next;
-            hp->items.next += hp->items.size;
-        }
+        if ( !hp->items.more )
+            hashmore( hp );
+        s->keyval = keyval;
+        s->data = (HASHDATA *)hp->items.next;
+        hp->items.next += hp->items.size;
         --hp->items.more;
-        i->next = *base;
-        *base = i;
+        ++hp->tab.count;
         *found = 0;
     }
 
@@ -191,7 +189,7 @@ HASHDATA * hash_insert( struct hash * hp, OBJECT * key, int32_t * found )
         profile_exit( prof );
     #endif
 
-    return hash_item_data( i );
+    return s->data;
 }
 
 
@@ -201,7 +199,7 @@ HASHDATA * hash_insert( struct hash * hp, OBJECT * key, int32_t * found )
 
 HASHDATA * hash_find( struct hash * hp, OBJECT * key )
 {
-    ITEM * i;
+    SLOT * s;
     uint32_t keyval = hash_keyval( key );
 
     #ifdef HASH_DEBUG_PROFILE
@@ -210,7 +208,7 @@ HASHDATA * hash_find( struct hash * hp, OBJECT * key )
         profile_enter( 0, prof );
     #endif
 
-    if ( !hp->items.nel )
+    if ( !hp->tab.count )
     {
         #ifdef HASH_DEBUG_PROFILE
         if ( is_debug_profile() )
@@ -219,14 +217,14 @@ HASHDATA * hash_find( struct hash * hp, OBJECT * key )
         return 0;
     }
 
-    i = hash_search( hp, keyval, key, 0 );
+    s = hash_search( hp, keyval, key );
 
     #ifdef HASH_DEBUG_PROFILE
     if ( is_debug_profile() )
         profile_exit( prof );
     #endif
 
-    return i ? hash_item_data( i ) : 0;
+    return s->data;
 }
 
 
@@ -236,42 +234,58 @@ HASHDATA * hash_find( struct hash * hp, OBJECT * key )
 
 static void hashrehash( struct hash * hp )
 {
-    int32_t i = ++hp->items.list;
-    hp->items.more = i ? 2 * hp->items.nel : hp->inel;
-    hp->items.next = (char *)BJAM_MALLOC( hp->items.more * hp->items.size );
-    hp->items.free = 0;
-
-    hp->items.lists[ i ].nel = hp->items.more;
-    hp->items.lists[ i ].base = hp->items.next;
-    hp->items.nel += hp->items.more;
-
-    if ( hp->tab.base )
-        BJAM_FREE( (char *)hp->tab.base );
-
-    hp->tab.nel = hp->items.nel * hp->bloat;
-    hp->tab.base = (ITEM * *)BJAM_MALLOC( hp->tab.nel * sizeof( ITEM * ) );
-
-    memset( (char *)hp->tab.base, '\0', hp->tab.nel * sizeof( ITEM * ) );
+    SLOT * const old = hp->tab.base;
+    int32_t const old_nel = hp->tab.nel;
+    int32_t i;
 
-    for ( i = 0; i < hp->items.list; ++i )
+    if ( hp->tab.nel )
     {
-        int32_t nel = hp->items.lists[ i ].nel;
-        char * next = hp->items.lists[ i ].base;
+        hp->tab.nel *= 2;
+        --hp->tab.shift;
+    }
+    else
+    {
+        /* Room for the initial items. */
+        for ( hp->tab.nel = 1; MAX_LOAD( hp->tab.nel ) <= hp->inel;
+            hp->tab.nel *= 2 )
+            --hp->tab.shift;
+    }
+    hp->tab.base = (SLOT *)BJAM_MALLOC( hp->tab.nel * sizeof( SLOT ) );
+    memset( (char *)hp->tab.base, '\0', hp->tab.nel * sizeof( SLOT ) );
 
-        for ( ; nel--; next += hp->items.size )
+    /* Move the used slots. Their hash is in the slot, hence no need to look at
+     * the items.
+     */
+    for ( i = 0; i < old_nel; ++i )
+    {
+        if ( old[ i ].data )
         {
-            ITEM * i = (ITEM *)next;
-            ITEM * * ip = hp->tab.base + object_hash( hash_item_key( i ) ) %
-                hp->tab.nel;
-            /* code currently assumes rehashing only when there are no free
-             * items
-             */
-            assert( hash_item_key( i ) );
-
-            i->next = *ip;
-            *ip = i;
+            int32_t j = hash_home( hp, old[ i ].keyval );
+            while ( hp->tab.base[ j ].data )
+                j = hash_next( hp, j );
+            hp->tab.base[ j ] = old[ i ];
         }
     }
+
+    if ( old )
+        BJAM_FREE( (char *)old );
+}
+
+
+/*
+ * hashmore() - allocate more items, doubling the number of them
+ */
+
+static void hashmore( struct hash * hp )
+{
+    int32_t i = ++hp->items.list;
+    assert( i < MAX_LISTS );
+    hp->items.more = i ? hp->items.nel : hp->inel;
+    hp->items.next = (char *)BJAM_MALLOC( hp->items.more * hp->items.size );
+
+    hp->items.lists[ i ].nel = hp->items.more;
+    hp->items.lists[ i ].base = hp->items.next;
+    hp->items.nel += hp->items.more;
 }
 
 
@@ -294,9 +308,8 @@ void hashenumerate( struct hash * hp, void (* f)( void *, void * ), void * data
 
         for ( ; nel--; next += hp->items.size )
         {
-            ITEM * const i = (ITEM *)next;
-            if ( hash_item_key( i ) != 0 )  /* Do not enumerate freed items. */
-                f( hash_item_data( i ), data );
+            if ( hash_data_key( next ) != 0 )  /* Do not enumerate freed items. */
+                f( next, data );
         }
     }
 }
@@ -334,7 +347,8 @@ void hashstats_init( struct hashstats * stats )
     stats->num_items = 0;
     stats->tab_size = 0;
     stats->item_size = 0;
-    stats->sets = 0;
+    stats->probes = 0;
+    stats->max_probes = 0;
     stats->num_hashes = 0;
 }
 
@@ -343,26 +357,24 @@ void hashstats_add( struct hashstats * stats, struct hash * hp )
 {
     if ( hp )
     {
-        ITEM * * tab = hp->tab.base;
+        SLOT * tab = hp->tab.base;
         int nel = hp->tab.nel;
-        int count = 0;
-        int sets = 0;
         int i;
 
+        /* The probes to find an item are the slots from its home slot. */
         for ( i = 0; i < nel; ++i )
         {
-            ITEM * item;
-            int here = 0;
-            for ( item = tab[ i ]; item; item = item->next )
-                ++here;
-
-            count += here;
-            if ( here > 0 )
-                ++sets;
+            if ( tab[ i ].data )
+            {
+                int const probes = ( ( i - hash_home( hp, tab[ i ].keyval ) )
+                    & ( nel - 1 ) ) + 1;
+                stats->probes += probes;
+                if ( probes > stats->max_probes )
+                    stats->max_probes = probes;
+            }
         }
 
-        stats->count += count;
-        stats->sets += sets;
+        stats->count += hp->tab.count;
         stats->num_items += hp->items.nel;
         stats->tab_size += hp->tab.nel;
         stats->item_size = hp->items.size;
@@ -373,15 +385,17 @@ void hashstats_add( struct hashstats * stats, struct hash * hp )
 
 void hashstats_print( struct hashstats * stats, char const * name )
 {
-    out_printf( "%s table: %d+%d+%d (%dK+%luK+%luK) items+table+hash, %f density\n",
+    out_printf( "%s table: %d+%d+%d (%dK+%luK+%luK) items+table+hash, %f load, %f probes, %d max probes\n",
         name,
         stats->count,
         stats->num_items,
         stats->tab_size,
         stats->num_items * stats->item_size / 1024,
-        (long unsigned)stats->tab_size * sizeof( ITEM * * ) / 1024,
+        (long unsigned)stats->tab_size * sizeof( SLOT ) / 1024,
         (long unsigned)stats->num_hashes * sizeof( struct hash ) / 1024,
-        (float)stats->count / (float)stats->sets );
+        stats->tab_size ? (float)stats->count / (float)stats->tab_size : 0.0f,
+        stats->count ? (float)stats->probes / (float)stats->count : 0.0f,
+        stats->max_probes );
 }
 
 
@@ -393,3 +407,10 @@ void hashdone( struct hash * hp )
         hashstat( hp );
     hash_free( hp );
 }
+
+
+void hashstats_done( struct hashstats * stats, char const * name )
+{
+    if ( stats->num_hashes > 0 && ( is_debug_mem() || is_debug_profile() ) )
+        hashstats_print( stats, name );
+}
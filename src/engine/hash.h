@@ -21,7 +21,9 @@
 #include "config.h"
 #include "jam_fwd.h"
 #include "mem.h"
+#include "object.h"
 
+#include <cstddef>
 #include <mutex>
 
 /*
@@ -93,66 +95,114 @@ struct hashstats
 	int num_items;
 	int tab_size;
 	int item_size;
-	int sets;
+	int probes;
+	int max_probes;
 	int num_hashes;
 };
 
 void hashstats_init(struct hashstats * stats);
 void hashstats_add(struct hashstats * stats, struct hash *);
 void hashstats_print(struct hashstats * stats, char const * name);
+// Prints the stats, when memory or profile debugging, of freed tables.
+void hashstats_done(struct hashstats * stats, char const * name);
 
 namespace b2 { namespace core {
 
-template <typename T>
+/*
+A thread safe hash table of `T` values keyed by `b2::value_ptr`. The table is
+split into shards, each a separate `hash` table with its own lock, selected by
+the key hash. Such that threads looking up different keys rarely wait on each
+other. The returned values stay at the same address for the life of the table.
+*/
+template <typename T, std::size_t Shards = 16>
 struct concurrent_hash
 {
 	using key_type = b2::value_ptr;
 	using value_type = T;
 
 	concurrent_hash(const char * debug_name)
-	{
-		table = hashinit(sizeof(value_type), debug_name);
-	}
+		: name(debug_name)
+	{}
 
 	~concurrent_hash() { reset(); }
 
 	void reset()
 	{
-		std::lock_guard<std::mutex> guard(mutex);
-		if (table != nullptr)
-		{
-			hashenumerate(table, concurrent_hash::destroy_at, nullptr);
-			hashdone(table);
-			table = nullptr;
-		}
+		guarded([this]() {
+			struct hashstats stats;
+			hashstats_init(&stats);
+			for (auto & s : shards)
+			{
+				if (s.table == nullptr) continue;
+				hashenumerate(s.table, concurrent_hash::destroy_at, nullptr);
+				hashstats_add(&stats, s.table);
+				hash_free(s.table);
+				s.table = nullptr;
+			}
+			hashstats_done(&stats, name);
+		});
 	}
 
 	template <typename... Args>
 	std::pair<value_type *, bool> get(b2::value_ptr key, Args... args)
 	{
 		int found = 0;
-		std::lock_guard<std::mutex> guard(mutex);
+		shard & s = shards[shard_index(key)];
+		std::lock_guard<std::mutex> guard(s.mutex);
+		if (s.table == nullptr) s.table = hashinit(sizeof(value_type), name);
 		value_type * val
-			= reinterpret_cast<value_type *>(hash_insert(table, key, &found));
+			= reinterpret_cast<value_type *>(hash_insert(s.table, key, &found));
 		if (found == 0) b2::jam::ctor_ptr<value_type>(val, args...);
 		return std::make_pair(val, found != 0);
 	}
 
+	// Calls `f` with all the shards locked.
 	template <typename F>
 	void guarded(F f)
 	{
-		std::lock_guard<std::mutex> guard(mutex);
+		for (auto & s : shards) s.mutex.lock();
 		f();
+		for (auto & s : shards) s.mutex.unlock();
+	}
+
+	// Calls `f` with each value, with all the shards locked.
+	template <typename F>
+	void for_each(F f)
+	{
+		guarded([this, &f]() {
+			for (auto & s : shards)
+				if (s.table != nullptr)
+					hashenumerate(s.table, concurrent_hash::call<F>, &f);
+		});
 	}
 
 	private:
-	std::mutex mutex;
-	hash * table = nullptr;
+	// Each shard in its own cache line to avoid false sharing of the locks.
+	struct alignas(64) shard
+	{
+		std::mutex mutex;
+		hash * table = nullptr;
+	};
+	const char * name;
+	shard shards[Shards];
+
+	// The table buckets use the low bits of the hash, hence the shard uses the
+	// high bits.
+	static std::size_t shard_index(b2::value_ptr key)
+	{
+		return std::size_t(key->hash64 >> 32) % Shards;
+	}
 
 	static void destroy_at(void * p, void * _)
 	{
 		b2::jam::dtor_ptr(static_cast<value_type *>(p));
 	}
+
+	template <typename F>
+	static void call(void * p, void * f)
+	{
+		(*static_cast<F *>(f))(*static_cast<value_type *>(p));
+	}
 };
 
 }} // namespace b2::core
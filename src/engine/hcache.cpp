@@ -20,9 +20,19 @@
  *    hcache_done() - write a new .jamdeps file.
  *    hcache()      - return list of headers on target. Use cache or do a scan.
  *
- * The dependency file format is an ASCII file with 1 line per target. Each line
- * has the following fields:
- * @boundname@ timestamp_sec timestamp_nsec @file@ @file@ @file@ ...
+ * The dependency file is a binary file meant to be memory mapped and queried
+ * in place. Only the entries looked up during the run get materialized into
+ * the in-memory cache, the rest are copied verbatim when writing the new cache
+ * file. The layout, in native byte order, is:
+ *
+ *   header                        - hcache_file_header
+ *   records[ record_count ]       - hcache_file_record, fixed size
+ *   buckets[ bucket_count ]       - 1 + index of the first record in a bucket
+ *   lists[ list_count ]           - string table offsets of list items
+ *   strings[ strings_size ]       - zero terminated strings
+ *
+ * Records are chained per bucket, by hash of the boundname, through their
+ * 'next' field.
  */
 
 #include "config.h"
@@ -45,9 +55,18 @@
 #include "variable.h"
 #include "output.h"
 
+#include "filesys.h"
+
 #include <errno.h>
 #include <string.h>
 
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 typedef struct hcachedata HCACHEDATA ;
 
 struct hcachedata
@@ -67,9 +86,45 @@ static HCACHEDATA * hcachelist = 0;
 static int queries = 0;
 static int hits = 0;
 
-#define CACHE_FILE_VERSION "version 5"
-#define CACHE_RECORD_HEADER "header"
-#define CACHE_RECORD_END "end"
+#define CACHE_FILE_MAGIC "b2hcache"
+#define CACHE_FILE_VERSION 6
+#define CACHE_BYTE_ORDER 0x01020304
+
+struct hcache_file_header
+{
+    char          magic[ 8 ];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t record_count;
+    std::uint32_t bucket_count;  /* power of 2 */
+    std::uint32_t list_count;
+    std::uint32_t strings_size;
+};
+
+struct hcache_file_record
+{
+    std::uint64_t time_secs;
+    std::uint32_t time_nsecs;
+    std::uint32_t age;
+    std::uint32_t boundname;     /* string offset */
+    std::uint32_t next;          /* 1 + index of next record in the bucket */
+    std::uint32_t includes;      /* list offset */
+    std::uint32_t includes_count;
+    std::uint32_t hdrscan;       /* list offset */
+    std::uint32_t hdrscan_count;
+};
+
+/* The memory mapped contents of the cache file read at startup. */
+static struct
+{
+    std::unique_ptr<b2::filesys::file_buffer> data;
+    hcache_file_header const * header;
+    hcache_file_record const * records;
+    std::uint32_t const * buckets;
+    std::uint32_t const * lists;
+    char const * strings;
+    std::vector<char> materialized;
+} hcachemap;
 
 
 /*
@@ -126,66 +181,101 @@ static int cache_maxage( void )
 
 
 /*
- * Read a netstring. The caveat is that the string can not contain ASCII 0. The
- * returned value is as returned by object_new().
+ * Hash of a boundname for the cache file buckets. This needs to be stable
+ * across runs, hence FNV-1a instead of the engine internal hash.
  */
 
-OBJECT * read_netstring( FILE * f )
+static std::uint32_t hcache_hash( char const * s )
 {
-    unsigned long len;
-    static char * buf = NULL;
-    static unsigned long buf_len = 0;
-
-    if ( fscanf( f, " %9lu", &len ) != 1 )
-        return NULL;
-    if ( fgetc( f ) != (int)'\t' )
-        return NULL;
-
-    if ( len > 1024 * 64 )
-        return NULL;  /* sanity check */
-
-    if ( len > buf_len )
+    std::uint32_t h = 2166136261u;
+    for ( ; *s; ++s )
     {
-        unsigned long new_len = buf_len * 2;
-        if ( new_len < len )
-            new_len = len;
-        buf = (char *)BJAM_REALLOC( buf, new_len + 1 );
-        if ( buf )
-            buf_len = new_len;
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
     }
+    return h;
+}
 
-    if ( !buf )
-        return NULL;
 
-    if ( fread( buf, 1, len, f ) != len )
-        return NULL;
-    if ( fgetc( f ) != (int)'\n' )
-        return NULL;
+/*
+ * Check that the record only refers to valid parts of the mapped cache.
+ */
+
+static int hcache_record_valid( hcache_file_record const * r )
+{
+    std::uint32_t const list_count = hcachemap.header->list_count;
+    std::uint32_t const strings_size = hcachemap.header->strings_size;
+    if ( r->boundname >= strings_size ) return 0;
+    if ( r->next > hcachemap.header->record_count ) return 0;
+    if ( r->includes > list_count ||
+        r->includes_count > list_count - r->includes ) return 0;
+    if ( r->hdrscan > list_count ||
+        r->hdrscan_count > list_count - r->hdrscan ) return 0;
+    return 1;
+}
 
-    buf[ len ] = 0;
-    return object_new( buf );
+
+static LIST * hcache_map_list( std::uint32_t first, std::uint32_t count )
+{
+    LIST * l = L0;
+    for ( std::uint32_t i = 0; i < count; ++i )
+    {
+        std::uint32_t const offset = hcachemap.lists[ first + i ];
+        if ( offset >= hcachemap.header->strings_size )
+            break;
+        l = list_push_back( l, object_new( hcachemap.strings + offset ) );
+    }
+    return l;
 }
 
 
 /*
- * Write a netstring.
+ * Look up the boundname in the mapped cache file and, if present, materialize
+ * the record into the in-memory cache.
  */
 
-template <typename... Args>
-void write_netstring( FILE * f, char const * format, Args... args )
+static HCACHEDATA * hcache_map_find( OBJECT * boundname )
 {
-    if ( format == nullptr ) format = "";
-    auto size = std::snprintf(nullptr, 0, format, args...);
-    std::unique_ptr<char[]> s(new char[size+1]);
-    std::snprintf(s.get(), size+1, format, args...);
-    fprintf( f, "%lu\t%s\n", (long unsigned)size, s.get() );
+    if ( !hcachemap.header || !hcachemap.header->record_count )
+        return 0;
+
+    char const * const name = object_str( boundname );
+    std::uint32_t const bucket = hcache_hash( name )
+        & ( hcachemap.header->bucket_count - 1 );
+    std::uint32_t index = hcachemap.buckets[ bucket ];
+    std::uint32_t chain = 0;
+    while ( index && index <= hcachemap.header->record_count &&
+        chain++ < hcachemap.header->record_count )
+    {
+        hcache_file_record const * const r = hcachemap.records + index - 1;
+        if ( !hcache_record_valid( r ) )
+            return 0;
+        if ( !strcmp( hcachemap.strings + r->boundname, name ) )
+        {
+            if ( hcachemap.materialized[ index - 1 ] )
+                return 0;
+            hcachemap.materialized[ index - 1 ] = 1;
+
+            int found;
+            HCACHEDATA * const c = (HCACHEDATA *)hash_insert( hcachehash,
+                boundname, &found );
+            c->boundname = object_copy( boundname );
+            c->includes = hcache_map_list( r->includes, r->includes_count );
+            c->hdrscan = hcache_map_list( r->hdrscan, r->hdrscan_count );
+            c->age = r->age + 1;
+            timestamp_init( &c->time, (time_t)r->time_secs, r->time_nsecs );
+            c->next = hcachelist;
+            hcachelist = c;
+            return c;
+        }
+        index = r->next;
+    }
+    return 0;
 }
 
 
 void hcache_init()
 {
-    FILE       * f;
-    OBJECT     * version = 0;
     const char * hcachename;
 
     if ( hcachehash )
@@ -196,165 +286,143 @@ void hcache_init()
     if ( !( hcachename = cache_name() ) )
         return;
 
-    if ( !( f = fopen( hcachename, "rb" ) ) )
+    errno = 0;
+    std::unique_ptr<b2::filesys::file_buffer> data(
+        new b2::filesys::file_buffer( hcachename, true ) );
+    if ( !data->begin() )
     {
-        if ( errno != ENOENT )
+        if ( errno && errno != ENOENT )
             err_printf( "[errno %d] failed to read hcache file '%s': %s",
                 errno, hcachename, strerror(errno) );
         return;
     }
 
-    version = read_netstring( f );
+    /* Validate the header and that all the sections fit in the file. Any
+     * mismatch, including older text formats, means we start from scratch.
+     */
+    std::size_t const size = data->size();
+    hcache_file_header const * const header =
+        (hcache_file_header const *)data->begin();
+    if ( size < sizeof( hcache_file_header ) ||
+        memcmp( header->magic, CACHE_FILE_MAGIC, sizeof( header->magic ) ) ||
+        header->version != CACHE_FILE_VERSION ||
+        header->byte_order != CACHE_BYTE_ORDER ||
+        header->bucket_count == 0 ||
+        ( header->bucket_count & ( header->bucket_count - 1 ) ) )
+    {
+        if ( is_debug_header() )
+            out_printf( "hcache file %s has an unknown format\n", hcachename );
+        return;
+    }
+    std::uint64_t const expected_size = sizeof( hcache_file_header )
+        + std::uint64_t( header->record_count ) * sizeof( hcache_file_record )
+        + std::uint64_t( header->bucket_count ) * sizeof( std::uint32_t )
+        + std::uint64_t( header->list_count ) * sizeof( std::uint32_t )
+        + header->strings_size;
+    if ( expected_size != size || header->strings_size == 0 ||
+        data->begin()[ size - 1 ] != 0 )
+    {
+        err_printf( "invalid %s\n", hcachename );
+        return;
+    }
 
-    if ( !version || strcmp( object_str( version ), CACHE_FILE_VERSION ) )
-        goto bail;
+    hcachemap.header = header;
+    hcachemap.records = (hcache_file_record const *)( header + 1 );
+    hcachemap.buckets = (std::uint32_t const *)(
+        hcachemap.records + header->record_count );
+    hcachemap.lists = hcachemap.buckets + header->bucket_count;
+    hcachemap.strings = (char const *)(
+        hcachemap.lists + header->list_count );
+    hcachemap.materialized.assign( header->record_count, 0 );
+    hcachemap.data = std::move( data );
 
-    while ( 1 )
-    {
-        HCACHEDATA   cachedata;
-        HCACHEDATA * c;
-        OBJECT * record_type = 0;
-        OBJECT * time_secs_str = 0;
-        OBJECT * time_nsecs_str = 0;
-        OBJECT * age_str = 0;
-        OBJECT * includes_count_str = 0;
-        OBJECT * hdrscan_count_str = 0;
-        int      i;
-        int      count;
-        LIST   * l;
-        int      found;
-
-        cachedata.boundname = 0;
-        cachedata.includes = 0;
-        cachedata.hdrscan = 0;
-
-        record_type = read_netstring( f );
-        if ( !record_type )
-        {
-            err_printf( "invalid %s\n", hcachename );
-            goto cleanup;
-        }
-        if ( !strcmp( object_str( record_type ), CACHE_RECORD_END ) )
-        {
-            object_free( record_type );
-            break;
-        }
-        if ( strcmp( object_str( record_type ), CACHE_RECORD_HEADER ) )
-        {
-            err_printf( "invalid %s with record separator <%s>\n",
-                hcachename, record_type ? object_str( record_type ) : "<null>" );
-            goto cleanup;
-        }
+    if ( is_debug_header() )
+        out_printf( "hcache read from file %s\n", hcachename );
+}
 
-        cachedata.boundname = read_netstring( f );
-        time_secs_str       = read_netstring( f );
-        time_nsecs_str      = read_netstring( f );
-        age_str             = read_netstring( f );
-        includes_count_str  = read_netstring( f );
 
-        if ( !cachedata.boundname || !time_secs_str || !time_nsecs_str ||
-            !age_str || !includes_count_str )
-        {
-            err_printf( "invalid %s\n", hcachename );
-            goto cleanup;
-        }
+/*
+ * Accumulates the contents of a new cache file.
+ */
 
-        timestamp_init( &cachedata.time, atoi( object_str( time_secs_str ) ),
-            atoi( object_str( time_nsecs_str ) ) );
-        cachedata.age = atoi( object_str( age_str ) ) + 1;
+struct hcache_writer
+{
+    std::vector<hcache_file_record> records;
+    std::vector<std::uint32_t> lists;
+    std::string strings;
+    std::unordered_map<std::string, std::uint32_t> string_offsets;
 
-        count = atoi( object_str( includes_count_str ) );
-        for ( l = L0, i = 0; i < count; ++i )
-        {
-            OBJECT * const s = read_netstring( f );
-            if ( !s )
-            {
-                err_printf( "invalid %s\n", hcachename );
-                list_free( l );
-                goto cleanup;
-            }
-            l = list_push_back( l, s );
-        }
-        cachedata.includes = l;
+    std::uint32_t add_string( char const * s )
+    {
+        auto i = string_offsets.find( s );
+        if ( i != string_offsets.end() )
+            return i->second;
+        std::uint32_t const offset = std::uint32_t( strings.size() );
+        strings.append( s, strlen( s ) + 1 );
+        string_offsets.emplace( s, offset );
+        return offset;
+    }
 
-        hdrscan_count_str = read_netstring( f );
-        if ( !hdrscan_count_str )
-        {
-            err_printf( "invalid %s\n", hcachename );
-            goto cleanup;
-        }
+    std::uint32_t add_list( LIST * l )
+    {
+        std::uint32_t const offset = std::uint32_t( lists.size() );
+        LISTITER iter = list_begin( l );
+        LISTITER const end = list_end( l );
+        for ( ; iter != end; iter = list_next( iter ) )
+            lists.push_back( add_string( object_str( list_item( iter ) ) ) );
+        return offset;
+    }
 
-        count = atoi( object_str( hdrscan_count_str ) );
-        for ( l = L0, i = 0; i < count; ++i )
-        {
-            OBJECT * const s = read_netstring( f );
-            if ( !s )
-            {
-                err_printf( "invalid %s\n", hcachename );
-                list_free( l );
-                goto cleanup;
-            }
-            l = list_push_back( l, s );
-        }
-        cachedata.hdrscan = l;
+    std::uint32_t add_map_list( std::uint32_t first, std::uint32_t count )
+    {
+        std::uint32_t const offset = std::uint32_t( lists.size() );
+        for ( std::uint32_t i = 0; i < count; ++i )
+            lists.push_back( add_string( hcachemap.strings +
+                hcachemap.lists[ first + i ] ) );
+        return offset;
+    }
 
-        c = (HCACHEDATA *)hash_insert( hcachehash, cachedata.boundname, &found )
-            ;
-        if ( !found )
-        {
-            c->boundname = cachedata.boundname;
-            c->includes  = cachedata.includes;
-            c->hdrscan   = cachedata.hdrscan;
-            c->age       = cachedata.age;
-            timestamp_copy( &c->time, &cachedata.time );
-        }
-        else
+    bool write( char const * filename )
+    {
+        hcache_file_header header;
+        memcpy( header.magic, CACHE_FILE_MAGIC, sizeof( header.magic ) );
+        header.version = CACHE_FILE_VERSION;
+        header.byte_order = CACHE_BYTE_ORDER;
+        header.record_count = std::uint32_t( records.size() );
+        header.bucket_count = 1;
+        while ( header.bucket_count < header.record_count )
+            header.bucket_count *= 2;
+        header.list_count = std::uint32_t( lists.size() );
+        header.strings_size = std::uint32_t( strings.size() );
+
+        std::vector<std::uint32_t> buckets( header.bucket_count, 0 );
+        for ( std::uint32_t i = 0; i < header.record_count; ++i )
         {
-            err_printf( "can not insert header cache item, bailing on %s"
-                "\n", hcachename );
-            goto cleanup;
+            std::uint32_t const bucket = hcache_hash( strings.c_str() +
+                records[ i ].boundname ) & ( header.bucket_count - 1 );
+            records[ i ].next = buckets[ bucket ];
+            buckets[ bucket ] = i + 1;
         }
 
-        c->next = hcachelist;
-        hcachelist = c;
-
-        object_free( record_type );
-        object_free( time_secs_str );
-        object_free( time_nsecs_str );
-        object_free( age_str );
-        object_free( includes_count_str );
-        object_free( hdrscan_count_str );
-        continue;
-
-cleanup:
-
-        if ( record_type ) object_free( record_type );
-        if ( time_secs_str ) object_free( time_secs_str );
-        if ( time_nsecs_str ) object_free( time_nsecs_str );
-        if ( age_str ) object_free( age_str );
-        if ( includes_count_str ) object_free( includes_count_str );
-        if ( hdrscan_count_str ) object_free( hdrscan_count_str );
-
-        if ( cachedata.boundname ) object_free( cachedata.boundname );
-        if ( cachedata.includes ) list_free( cachedata.includes );
-        if ( cachedata.hdrscan ) list_free( cachedata.hdrscan );
-
-        goto bail;
+        FILE * const f = fopen( filename, "wb" );
+        if ( !f )
+            return false;
+        bool ok = fwrite( &header, sizeof( header ), 1, f ) == 1;
+        ok = ok && fwrite( records.data(), sizeof( hcache_file_record ),
+            records.size(), f ) == records.size();
+        ok = ok && fwrite( buckets.data(), sizeof( std::uint32_t ),
+            buckets.size(), f ) == buckets.size();
+        ok = ok && fwrite( lists.data(), sizeof( std::uint32_t ),
+            lists.size(), f ) == lists.size();
+        ok = ok && fwrite( strings.data(), 1, strings.size(), f ) ==
+            strings.size();
+        return ( fclose( f ) == 0 ) && ok;
     }
-
-    if ( is_debug_header() )
-        out_printf( "hcache read from file %s\n", hcachename );
-
-bail:
-    if ( version )
-        object_free( version );
-    fclose( f );
-}
+};
 
 
 void hcache_done()
 {
-    FILE       * f;
     HCACHEDATA * c;
     int          header_count = 0;
     const char * hcachename;
@@ -366,55 +434,75 @@ void hcache_done()
     if ( !( hcachename = cache_name() ) )
         goto cleanup;
 
-    if ( !( f = fopen( hcachename, "wb" ) ) )
+    maxage = cache_maxage();
+
     {
-        err_printf( "[errno %d] failed to write hcache file '%s': %s",
-            errno, hcachename, strerror(errno) );
-        goto cleanup;
-    }
+        hcache_writer writer;
 
-    maxage = cache_maxage();
+        /* The entries we looked at during this run. */
+        for ( c = hcachelist; c; c = c->next )
+        {
+            if ( maxage == 0 )
+                c->age = 0;
+            else if ( c->age > maxage )
+                continue;
+
+            hcache_file_record r;
+            r.time_secs = std::uint64_t( c->time.secs );
+            r.time_nsecs = std::uint32_t( c->time.nsecs );
+            r.age = std::uint32_t( c->age );
+            r.boundname = writer.add_string( object_str( c->boundname ) );
+            r.next = 0;
+            r.includes_count = std::uint32_t( list_length( c->includes ) );
+            r.includes = writer.add_list( c->includes );
+            r.hdrscan_count = std::uint32_t( list_length( c->hdrscan ) );
+            r.hdrscan = writer.add_list( c->hdrscan );
+            writer.records.push_back( r );
+            ++header_count;
+        }
 
-    /* Print out the version. */
-    write_netstring( f, "%s",CACHE_FILE_VERSION );
+        /* And the ones we did not, which get older. */
+        for ( std::uint32_t i = 0; i < hcachemap.materialized.size(); ++i )
+        {
+            hcache_file_record r = hcachemap.records[ i ];
+            if ( hcachemap.materialized[ i ] || !hcache_record_valid( &r ) )
+                continue;
+            r.age = maxage == 0 ? 0 : r.age + 1;
+            if ( int( r.age ) > maxage )
+                continue;
+            r.boundname = writer.add_string( hcachemap.strings + r.boundname );
+            r.next = 0;
+            r.includes = writer.add_map_list( r.includes, r.includes_count );
+            r.hdrscan = writer.add_map_list( r.hdrscan, r.hdrscan_count );
+            writer.records.push_back( r );
+            ++header_count;
+        }
 
-    c = hcachelist;
-    for ( c = hcachelist; c; c = c->next )
-    {
-        LISTITER iter;
-        LISTITER end;
-
-        if ( maxage == 0 )
-            c->age = 0;
-        else if ( c->age > maxage )
-            continue;
-
-        write_netstring( f, "%s", CACHE_RECORD_HEADER );
-        write_netstring( f, "%s", object_str( c->boundname ) );
-        write_netstring( f, "%lu", (long unsigned)c->time.secs );
-        write_netstring( f, "%lu", (long unsigned)c->time.nsecs );
-        write_netstring( f, "%lu", (long unsigned)c->age );
-        write_netstring( f, "%lu", (long unsigned)list_length(
-            c->includes ) );
-        for ( iter = list_begin( c->includes ), end = list_end( c->includes );
-            iter != end; iter = list_next( iter ) )
-            write_netstring( f, "%s", object_str( list_item( iter ) ) );
-        write_netstring( f, "%lu", (long unsigned)list_length(
-            c->hdrscan ) );
-        for ( iter = list_begin( c->hdrscan ), end = list_end( c->hdrscan );
-            iter != end; iter = list_next( iter ) )
-            write_netstring( f, "%s", object_str( list_item( iter ) ) );
-        fputs( "\n", f );
-        ++header_count;
+        /* Write to a new file and move it in place, as the current one might
+         * still be mapped in memory.
+         */
+        std::string const tmpname = std::string( hcachename ) + ".tmp";
+        if ( !writer.write( tmpname.c_str() ) )
+        {
+            err_printf( "[errno %d] failed to write hcache file '%s': %s",
+                errno, hcachename, strerror(errno) );
+            remove( tmpname.c_str() );
+            goto cleanup;
+        }
+        hcachemap.data.reset();
+        remove( hcachename );
+        if ( rename( tmpname.c_str(), hcachename ) != 0 )
+        {
+            err_printf( "[errno %d] failed to write hcache file '%s': %s",
+                errno, hcachename, strerror(errno) );
+            goto cleanup;
+        }
     }
-    write_netstring( f, "%s", CACHE_RECORD_END );
 
     if ( is_debug_header() )
         out_printf( "hcache written to %s.   %d dependencies, %.0f%% hit rate\n",
             hcachename, header_count, queries ? 100.0 * hits / queries : 0 );
 
-    fclose ( f );
-
 cleanup:
     for ( c = hcachelist; c; c = c->next )
     {
@@ -427,6 +515,42 @@ cleanup:
     if ( hcachehash )
         hashdone( hcachehash );
     hcachehash = 0;
+    hcachemap.data.reset();
+    hcachemap.header = 0;
+    hcachemap.materialized.clear();
+}
+
+
+static int hcache_hdrscan_equal( LIST * const l1, LIST * const l2 )
+{
+    LISTITER iter1 = list_begin( l1 );
+    LISTITER const end1 = list_end( l1 );
+    LISTITER iter2 = list_begin( l2 );
+    LISTITER const end2 = list_end( l2 );
+    for ( ; iter1 != end1 && iter2 != end2; iter1 = list_next( iter1 ),
+        iter2 = list_next( iter2 ) )
+        if ( !object_equal( list_item( iter1 ), list_item( iter2 ) ) )
+            return 0;
+    return iter1 == end1 && iter2 == end2;
+}
+
+
+/*
+ * hcache_valid() - check if hcache() would use the cached includes of the file,
+ * instead of scanning it.
+ */
+
+int hcache_valid( OBJECT * boundname, timestamp const * time, LIST * hdrscan )
+{
+    HCACHEDATA * c;
+
+    if ( !hcachehash )
+        return 0;
+    if ( !( c = (HCACHEDATA *)hash_find( hcachehash, boundname ) ) &&
+        !( c = hcache_map_find( boundname ) ) )
+        return 0;
+    return !timestamp_cmp( &c->time, time ) &&
+        hcache_hdrscan_equal( hdrscan, c->hdrscan );
 }
 
 
@@ -436,27 +560,12 @@ LIST * hcache( TARGET * t, int rec, b2::regex::program re[], LIST * hdrscan )
 
     ++queries;
 
-    if ( ( c = (HCACHEDATA *)hash_find( hcachehash, t->boundname ) ) )
+    if ( ( c = (HCACHEDATA *)hash_find( hcachehash, t->boundname ) ) ||
+        ( c = hcache_map_find( t->boundname ) ) )
     {
         if ( !timestamp_cmp( &c->time, &t->time ) )
         {
-            LIST * const l1 = hdrscan;
-            LIST * const l2 = c->hdrscan;
-            LISTITER iter1 = list_begin( l1 );
-            LISTITER const end1 = list_end( l1 );
-            LISTITER iter2 = list_begin( l2 );
-            LISTITER const end2 = list_end( l2 );
-            while ( iter1 != end1 && iter2 != end2 )
-            {
-                if ( !object_equal( list_item( iter1 ), list_item( iter2 ) ) )
-                    iter1 = end1;
-                else
-                {
-                    iter1 = list_next( iter1 );
-                    iter2 = list_next( iter2 );
-                }
-            }
-            if ( iter1 != end1 || iter2 != end2 )
+            if ( !hcache_hdrscan_equal( hdrscan, c->hdrscan ) )
             {
                 if ( is_debug_header() )
                 {
@@ -14,5 +14,6 @@
 void hcache_init( void );
 void hcache_done( void );
 LIST * hcache( TARGET * t, int rec, b2::regex::program re[], LIST * hdrscan );
+int hcache_valid( OBJECT * boundname, timestamp const * time, LIST * hdrscan );
 
 #endif
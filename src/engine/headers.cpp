@@ -18,9 +18,16 @@
  *
  * External routines:
  *    headers() - scan a target for include files and call HDRRULE
+ *    headers_prefetch() - start scanning a target ahead of headers()
+ *    headers_prefetch_done() - discard unused prefetched scans
  *
  * Internal routines:
  *    headers1() - using regexp, scan a file and build include LIST
+ *
+ * The file reading and regexp matching of prefetched scans happens in the
+ * task executor threads. Only the results, as plain strings, are handed back
+ * to headers1(). Hence HDRRULE invocations, and all Jam data, stay on the main
+ * thread and in the same order as without prefetching.
  */
 
 #include "jam.h"
@@ -35,6 +42,10 @@
 #include "parse.h"
 #include "regexp.h"
 #include "rules.h"
+#include "search.h"
+#include "tasks.h"
+#include "timestamp.h"
+#include "types.h"
 #include "variable.h"
 #include "output.h"
 
@@ -45,41 +56,198 @@
 #include <errno.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#if B2_USE_STD_THREADS
+#include <condition_variable>
+#endif
 
 
 // max numebr of regular expression sourced from HDRSCAN
 #define MAX_SCAN_REGEXPS 10
 
 
+// max length of the lines matched, longer lines are matched in pieces
+#define MAX_SCAN_LINE 1023
+
+
 /*
- * headers() - scan a target for include files and call HDRRULE
+ * headers_scan() - read the file and collect the matches of the regexps.
+ * Returns 0, or the errno of failing to open the file. Only uses the given
+ * arguments, hence it can run in any thread.
+ *
+ * The regexps are matched to each line, or MAX_SCAN_LINE long piece of a line,
+ * in turn. But as most lines don't have includes we first search the whole
+ * file for the literal text each regexp requires (i.e. "include"). And only
+ * match the regexps on the lines that have it.
  */
 
-void headers( TARGET * t )
+static int headers_scan( char const * file, int rec, b2::regex::program re[],
+    std::vector<std::string> & found )
 {
-    module_t * rootm = root_module();
+    FILE * f;
+    char buf[ 64 * 1024 ];
+    std::size_t n;
+    std::string data;
+    int i;
 
-    b2::list_cref hdrscan( var_get( rootm, constant_HDRSCAN ) );
-    if ( hdrscan.empty() ) return;
+    if ( !( f = fopen( file, "r" ) ) )
+        return errno ? errno : ENOENT;
+    while ( ( n = fread( buf, 1, sizeof( buf ), f ) ) > 0 )
+        data.append( buf, n );
+    fclose( f );
 
-    b2::list_cref hdrrule( var_get( rootm, constant_HDRRULE ) );
-    if ( hdrrule.empty() ) return;
+    /* The literals, and where they are next found, per regexp. We can only
+     * skip lines if all the regexps have a literal.
+     */
+    b2::string_view literal[ MAX_SCAN_REGEXPS ];
+    std::size_t literal_at[ MAX_SCAN_REGEXPS ];
+    bool skip_lines = rec > 0;
+    for ( i = 0; i < rec; ++i )
+    {
+        literal[ i ] = re[ i ].required_literal();
+        literal_at[ i ] = literal[ i ].empty() ? std::string::npos
+            : data.find( literal[ i ].data(), 0, literal[ i ].size() );
+        skip_lines = skip_lines && !literal[ i ].empty();
+    }
 
-    if ( is_debug_header() )
-        out_printf( "header scan %s\n", object_str( t->name ) );
+    std::size_t line = 0;
+    while ( line < data.size() )
+    {
+        if ( skip_lines )
+        {
+            /* Go to the line with the nearest literal, if any. */
+            std::size_t nearest = std::string::npos;
+            for ( i = 0; i < rec; ++i )
+            {
+                if ( literal_at[ i ] < line )
+                    literal_at[ i ] = data.find( literal[ i ].data(), line,
+                        literal[ i ].size() );
+                nearest = std::min( nearest, literal_at[ i ] );
+            }
+            if ( nearest == std::string::npos )
+                break;
+            std::size_t const line_begin = data.rfind( '\n', nearest ) + 1;
+            if ( line_begin > line )
+                line = line_begin;
+            line += ( nearest - line ) / MAX_SCAN_LINE * MAX_SCAN_LINE;
+        }
+
+        /* The extent of the line, or the next piece of it. */
+        std::size_t line_end = data.find( '\n', line );
+        line_end = line_end == std::string::npos
+            ? data.size() : line_end + 1;
+        line_end = std::min( line_end, line + MAX_SCAN_LINE );
+        b2::string_view text( data.data() + line, line_end - line );
+        text = text.substr( 0, text.find( '\0' ) );
+
+        for ( i = 0; i < rec; ++i )
+        {
+            if ( !literal[ i ].empty() && text.find( literal[ i ] ) ==
+                b2::string_view::npos )
+                continue;
+            auto re_i = re [ i ].search( text );
+            if ( re_i && re_i[ 1 ].begin() )
+                found.emplace_back( re_i[ 1 ].begin(), re_i[ 1 ].end() );
+        }
+
+        line = line_end;
+    }
+
+    return 0;
+}
+#undef MAX_SCAN_LINE
+
+
+/*
+ * A scan of a file queued ahead of its headers() call. The scan is run by
+ * whichever gets to it first, a task thread or the consuming headers1().
+ */
+
+namespace {
+
+struct header_scan
+{
+    enum { scan_queued, scan_running, scan_done };
+
+    std::string file;
+    int rec = 0;
+    b2::regex::program re[ MAX_SCAN_REGEXPS ];
+    std::vector<std::string> found;
+    int error = 0;
+    int state = scan_queued;
+    b2::mutex_t mx;
+#if B2_USE_STD_THREADS
+    std::condition_variable done_cv;
+#endif
+
+    /* Runs the scan, unless it was already started. */
+    void run()
+    {
+        {
+            b2::scope_lock_t lock( mx );
+            if ( state != scan_queued ) return;
+            state = scan_running;
+        }
+        error = headers_scan( file.c_str(), rec, re, found );
+        {
+            b2::scope_lock_t lock( mx );
+            state = scan_done;
+#if B2_USE_STD_THREADS
+            done_cv.notify_all();
+#endif
+        }
+    }
+
+    /* Runs, or waits for, the scan to complete. */
+    void complete()
+    {
+        run();
+#if B2_USE_STD_THREADS
+        b2::scope_lock_t lock( mx );
+        done_cv.wait( lock, [this]() { return state == scan_done; } );
+#endif
+    }
+
+    /* Prevents the scan from running if it did not start yet. */
+    void cancel()
+    {
+        b2::scope_lock_t lock( mx );
+        if ( state == scan_queued ) state = scan_done;
+    }
+};
+
+} // namespace
+
+static std::unordered_map<std::string, std::shared_ptr<header_scan>>
+    header_scans;
+static std::unordered_set<TARGET *> header_scans_tried;
+static std::shared_ptr<b2::task::group> header_scans_tasks;
+
+
+/*
+ * headers_regexps() - compile the regular expressions in HDRSCAN, returning
+ * their count. Compilation errors print a nice error message, as coming from
+ * the target "HDRSCAN on" variable, and exit.
+ */
+
+static int headers_regexps( TARGET * t, LIST * hdrscan, FRAME * frame_re,
+    std::string & varname, b2::regex::program re_prog[] )
+{
+    module_t * rootm = root_module();
 
     b2::list_cref fln_arg( var_get( rootm, constant_FILENAME ) );
     b2::value_ptr file_ptr = fln_arg.empty() ? nullptr : list_front( *fln_arg );
-    b2::list_cref mod_arg( var_get( rootm, constant_MODULE ) );
-    b2::value_ptr user_mod = mod_arg.empty() ? nullptr : list_front( *mod_arg );
 
     // this is used for error reporting purposes only
-    FRAME frame_re[ 1 ];
     frame_init( frame_re );
-    std::string varname = std::string("HDRSCAN on ") + object_str( t->name );
+    varname = std::string("HDRSCAN on ") + object_str( t->name );
     frame_re->rulename = varname.c_str();
-    lol_add( frame_re->args, list_copy( *hdrscan ) );
+    lol_add( frame_re->args, list_copy( hdrscan ) );
     // try to retrieve at least the user jamfile filename
     if (file_ptr)
     {
@@ -88,20 +256,47 @@ void headers( TARGET * t )
     }
 
     // compile all regular expressions in HDRSCAN
-    b2::regex::program re_prog[MAX_SCAN_REGEXPS];
     int rec = 0;
     {
         // compilation errors print a nice error message and exit
         b2::regex::frame_ctx ctx(frame_re);
 
-        b2::list_cref::iterator iter = hdrscan.begin();
-        b2::list_cref::iterator end = hdrscan.end();
-        for ( ; ( rec < MAX_SCAN_REGEXPS ) && iter != end; iter++ )
+        LISTITER iter = list_begin( hdrscan );
+        LISTITER const end = list_end( hdrscan );
+        for ( ; ( rec < MAX_SCAN_REGEXPS ) && iter != end; iter = list_next( iter ) )
         {
-            re_prog[ rec ].reset( (*iter)->str() );
+            re_prog[ rec ].reset( object_str( list_item( iter ) ) );
             rec += 1;
         }
     }
+    return rec;
+}
+
+
+/*
+ * headers() - scan a target for include files and call HDRRULE
+ */
+
+void headers( TARGET * t )
+{
+    module_t * rootm = root_module();
+
+    b2::list_cref hdrscan( var_get( rootm, constant_HDRSCAN ) );
+    if ( hdrscan.empty() ) return;
+
+    b2::list_cref hdrrule( var_get( rootm, constant_HDRRULE ) );
+    if ( hdrrule.empty() ) return;
+
+    if ( is_debug_header() )
+        out_printf( "header scan %s\n", object_str( t->name ) );
+
+    b2::list_cref mod_arg( var_get( rootm, constant_MODULE ) );
+    b2::value_ptr user_mod = mod_arg.empty() ? nullptr : list_front( *mod_arg );
+
+    FRAME frame_re[ 1 ];
+    std::string varname;
+    b2::regex::program re_prog[MAX_SCAN_REGEXPS];
+    int const rec = headers_regexps( t, *hdrscan, frame_re, varname, re_prog );
 
     FRAME frame[ 1 ];
     frame_init( frame );
@@ -137,6 +332,64 @@ void headers( TARGET * t )
     frame_free( frame );
     frame_free( frame_re );
 }
+
+
+/*
+ * headers_prefetch() - start scanning a target, that make0() will get to
+ * later, in the background. Like headers() it expects the target variables to
+ * be set. The location of the target is only probed, the actual binding, and
+ * the headers() call, happen as usual. The prefetched result is only used if
+ * headers1() scans the same file with the same regexps.
+ */
+
+void headers_prefetch( TARGET * t )
+{
+    if ( !header_scans_tried.insert( t ).second ) return;
+
+    module_t * rootm = root_module();
+
+    LIST * hdrscan = var_get( rootm, constant_HDRSCAN );
+    if ( list_empty( hdrscan ) ) return;
+    if ( list_empty( var_get( rootm, constant_HDRRULE ) ) ) return;
+
+    timestamp time;
+    OBJECT * boundname = search_probe( t->name, &time,
+        t->flags & T_FLAG_ISFILE );
+    std::string file = object_str( boundname );
+    bool const skip = timestamp_empty( &time ) || file.empty()
+        || header_scans.count( file ) > 0
+#ifdef OPT_HEADER_CACHE_EXT
+        || hcache_valid( boundname, &time, hdrscan )
+#endif
+        ;
+    object_free( boundname );
+    if ( skip ) return;
+
+    auto scan = std::make_shared<header_scan>();
+    scan->file = file;
+    FRAME frame_re[ 1 ];
+    std::string varname;
+    scan->rec = headers_regexps( t, hdrscan, frame_re, varname, scan->re );
+    frame_free( frame_re );
+    header_scans.emplace( file, scan );
+
+    if ( !header_scans_tasks )
+        header_scans_tasks = b2::task::executor::get().make();
+    header_scans_tasks->queue( [scan]() { scan->run(); } );
+}
+
+
+/*
+ * headers_prefetch_done() - discard the prefetched scans that were not used.
+ * The files may change after this, e.g. by getting updated.
+ */
+
+void headers_prefetch_done()
+{
+    for ( auto & scan : header_scans ) scan.second->cancel();
+    header_scans.clear();
+    header_scans_tried.clear();
+}
 #undef MAX_SCAN_REGEXPS
 
 
@@ -146,9 +399,8 @@ void headers( TARGET * t )
 
 LIST * headers1( LIST * l, OBJECT * file, int rec, b2::regex::program re[] )
 {
-    FILE * f;
-    char buf[ 1024 ];
-    int i;
+    std::vector<std::string> found;
+    int error = 0;
 
 #ifdef OPT_IMPROVED_PATIENCE_EXT
     static int count = 0;
@@ -166,30 +418,35 @@ LIST * headers1( LIST * l, OBJECT * file, int rec, b2::regex::program re[] )
         return l;
     }
 
-    if ( !( f = fopen( object_str( file ), "r" ) ) )
+    /* Use the prefetched scan if it matches, otherwise scan here. */
+    auto prefetched = header_scans.find( object_str( file ) );
+    if ( prefetched != header_scans.end() && prefetched->second->rec == rec
+        && std::equal( re, re + rec, prefetched->second->re ) )
+    {
+        std::shared_ptr<header_scan> scan = prefetched->second;
+        header_scans.erase( prefetched );
+        scan->complete();
+        error = scan->error;
+        found.swap( scan->found );
+    }
+    else
+        error = headers_scan( object_str( file ), rec, re, found );
+
+    if ( error )
     {
         /* No source files will be generated when -n flag is passed */
-        if ( !globs.noexec || errno != ENOENT )
+        if ( !globs.noexec || error != ENOENT )
             err_printf( "[errno %d] failed to scan file '%s': %s",
-                errno, object_str( file ), strerror(errno) );
+                error, object_str( file ), strerror( error ) );
         return l;
     }
 
-    while ( fgets( buf, sizeof( buf ), f ) )
+    for ( auto const & header : found )
     {
-        for ( i = 0; i < rec; ++i )
-        {
-            auto re_i = re [ i ].search( buf );
-            if ( re_i && re_i[ 1 ].begin() )
-            {
-                std::string header(re_i[ 1 ].begin(), re_i[ 1 ].end());
-                if ( is_debug_header() )
-                    out_printf( "header found: %s\n", header.c_str() );
-                l = list_push_back( l, object_new( header.c_str() ) );
-            }
-        }
+        if ( is_debug_header() )
+            out_printf( "header found: %s\n", header.c_str() );
+        l = list_push_back( l, object_new( header.c_str() ) );
     }
 
-    fclose( f );
     return l;
 }
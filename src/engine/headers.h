@@ -15,6 +15,8 @@
 #include "jam_fwd.h"
 
 void headers( TARGET * t );
+void headers_prefetch( TARGET * t );
+void headers_prefetch_done();
 
 LIST * headers1( LIST *l, OBJECT * file, int rec, b2::regex::program re[] );
 
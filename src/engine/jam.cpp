@@ -116,9 +116,13 @@
 #include "jam_strings.h"
 #include "lists.h"
 #include "make.h"
+#include "mod_action_cache.h"
 #include "mod_args.h"
 #include "mod_command_db.h"
+#include "mod_graph_snapshot.h"
+#include "mod_shell_cache.h"
 #include "mod_sysinfo.h"
+#include "mod_timing_db.h"
 #include "modules.h"
 #include "output.h"
 #include "parse.h"
@@ -203,6 +207,8 @@ void global_config::out_print() const
 	out_printf("  > jobs: %d\n", globs.jobs);
 	out_printf("  > quitquick: %s\n", true_false(globs.quitquick));
 	out_printf("  > newestfirst: %s\n", true_false(globs.newestfirst));
+	out_printf("  > critical_path: %s\n", true_false(globs.critical_path));
+	out_printf("  > jam_cache: %s\n", true_false(globs.jam_cache));
 	out_printf("  > debug:");
 	for (auto v : globs.debug) out_printf(" %s", true_false(v));
 	out_puts("\n");
@@ -350,6 +356,12 @@ int guarded_main(int argc, char * argv[])
 			   .name("-g")
 			   .help("Build from newest sources first.");
 
+	cli |= lyra::opt(globs.critical_path)
+			   .name("--critical-path")
+			   .help(
+				   "Run the actions on the longest remaining chain of actions "
+				   "first.");
+
 	cli |= lyra::opt(globs.timeout, "x")
 			   .name("-l")
 			   .help(
@@ -366,6 +378,51 @@ int guarded_main(int argc, char * argv[])
 				   "Maximum target output saved (kb), "
 				   "default is to save all output.");
 
+	cli |= lyra::opt(
+		[](const std::string & v) {
+			if (!v.empty()) b2::action_cache::set_dir(b2::value_ref(v));
+		},
+		"dir")
+			   .name("--action-cache")
+			   .help(
+				   "Restore action outputs from, and store them to, a content "
+				   "addressed cache in dir.");
+
+	cli |= lyra::opt(
+		[](const std::string & v) {
+			if (!v.empty()) b2::timing_db::set_file(b2::value_ref(v));
+		},
+		"file")
+			   .name("--timing-db")
+			   .help("Record, and use, the times actions take to run in file.");
+
+	cli |= lyra::opt(
+		[](const std::string & v) {
+			if (!v.empty()) b2::shell_cache::set_file(b2::value_ref(v));
+		},
+		"file")
+			   .name("--shell-cache")
+			   .help(
+				   "Reuse the output of the SHELL commands, run with the cache "
+				   "option, recorded in file.");
+
+	cli |= lyra::opt(
+		[](const std::string & v) {
+			if (!v.empty()) b2::graph_snapshot::set_file(b2::value_ref(v));
+		},
+		"file")
+			   .name("--graph-snapshot")
+			   .help(
+				   "Skip loading and checking the targets when the inputs "
+				   "recorded in file, by a build with nothing to update, did "
+				   "not change.");
+
+	cli |= lyra::opt(globs.jam_cache)
+			   .name("--jam-cache")
+			   .help(
+				   "Load the Jamfiles, and build system modules, compiled in "
+				   "a previous run instead of parsing them again.");
+
 	cli |= lyra ::opt(
 		[](const std::string & val) {
 			/* Turn on/off debugging */
@@ -390,7 +447,7 @@ int guarded_main(int argc, char * argv[])
 		},
 		"x")
 			   .name("-d")
-			   .help("Set the debug level to x (0-13,console,mi).")
+			   .help("Set the debug level to x (0-14,console,mi).")
 			   .cardinality(0, 0);
 
 	cli |= lyra::opt(args_data.out_filename, "x")
@@ -493,6 +550,13 @@ int guarded_main(int argc, char * argv[])
 		}
 	}
 
+	/* Nothing to do when the inputs of the last null build did not change. */
+	if (b2::graph_snapshot::start(arg_c, arg_v, use_environ))
+	{
+		b2::trigger_event_exit_main(EXITOK);
+		return EXITOK;
+	}
+
 	{
 		PROFILE_ENTER(MAIN);
 
@@ -678,6 +742,7 @@ int guarded_main(int argc, char * argv[])
 
 		PROFILE_EXIT(MAIN);
 	}
+	b2::graph_snapshot::save(status);
 	b2::trigger_event_exit_main(status ? EXITBAD : EXITOK);
 
 	return status ? EXITBAD : EXITOK;
@@ -458,7 +458,7 @@
 
 /* Jam private definitions below. */
 
-#define DEBUG_MAX 14
+#define DEBUG_MAX 15
 
 struct global_config
 {
@@ -472,6 +472,10 @@ struct global_config
 	bool quitquick = false;
 	// Build newest sources first.
 	bool newestfirst = false;
+	// Start the actions on the longest remaining chain of actions first.
+	bool critical_path = false;
+	// Cache the compiled Jamfiles next to them.
+	bool jam_cache = false;
 	// Where to send the output streams.
 	int pipe_action = 0;
 	// If a debug level flag was given.
@@ -553,6 +557,8 @@ inline bool is_debug_parse() { return globs.debug[11]; }
 inline bool is_debug_graph() { return globs.debug[12]; }
 /* show fate changes in make0() */
 inline bool is_debug_fate() { return globs.debug[13]; }
+/* show the compiled code of rules and actions */
+inline bool is_debug_bytecode() { return globs.debug[14]; }
 
 /* Everyone gets the memory definitions. */
 #include "mem.h"
@@ -44,6 +44,7 @@ struct program;
 // rules.h
 using RULE = struct _rule;
 using TARGET = struct _target;
+struct rule_cache;
 
 // timestamp.h
 using timestamp = struct timestamp;
@@ -25,6 +25,9 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include <assert.h>
 
+#include <atomic>
+#include <cstdint>
+
 static int32_t get_bucket(int32_t size)
 {
 	int32_t bucket = 0;
@@ -32,9 +35,72 @@ static int32_t get_bucket(int32_t size)
 	return bucket;
 }
 
+/*
+ * Most lists are short, and short lived. The freed lists of up to
+ * 2^(list_freelist_buckets-1) elements are kept in free lists, for each bucket
+ * size, to reuse them for the next allocations instead of going back to the
+ * heap. The free lists are per thread, as lists are also made in the task
+ * executor threads. They are released when the thread ends, after which the
+ * lists go back to the heap directly.
+ */
+
+namespace {
+
+const int32_t list_freelist_buckets = 4;
+
+thread_local LIST * freelists[list_freelist_buckets] = {};
+thread_local bool freelists_closed = false;
+
+struct list_freelists_release
+{
+	bool used = false;
+
+	~list_freelists_release()
+	{
+		freelists_closed = true;
+		for (int32_t b = 0; b < list_freelist_buckets; ++b)
+		{
+			while (freelists[b])
+			{
+				LIST * l = freelists[b];
+				freelists[b] = l->impl.next;
+				BJAM_FREE(l);
+			}
+		}
+	}
+};
+
+thread_local list_freelists_release freelists_release;
+
+/* The allocation counts for the "-d+9" memory stats. */
+struct list_stats
+{
+	std::atomic<std::uint64_t> allocated { 0 };
+	std::atomic<std::uint64_t> reused { 0 };
+	std::atomic<std::uint64_t> released { 0 };
+	std::atomic<std::uint64_t> recycled { 0 };
+};
+
+list_stats stats;
+
+inline void count(std::atomic<std::uint64_t> & n)
+{
+	if (is_debug_mem()) n.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
 static LIST * list_alloc(int32_t size)
 {
 	int32_t bucket = get_bucket(size);
+	if (bucket < list_freelist_buckets && freelists[bucket])
+	{
+		LIST * l = freelists[bucket];
+		freelists[bucket] = l->impl.next;
+		count(stats.reused);
+		return b2::jam::ctor_ptr<LIST>(l);
+	}
+	count(stats.allocated);
 	return b2::jam::ctor_ptr<LIST>(BJAM_CALLOC(
 		1, sizeof(LIST) + (size_t(1) << bucket) * sizeof(OBJECT *)));
 }
@@ -46,6 +112,19 @@ static void list_dealloc(LIST * l)
 
 	if (size == 0) return;
 
+	int32_t bucket = get_bucket(size);
+	if (bucket < list_freelist_buckets && !freelists_closed)
+	{
+		// Touch the releaser, when first needed, for it to be constructed,
+		// and destructed, with the thread.
+		if (!freelists[bucket]) freelists_release.used = true;
+		b2::jam::dtor_ptr(node);
+		node->impl.next = freelists[bucket];
+		freelists[bucket] = node;
+		count(stats.recycled);
+		return;
+	}
+	count(stats.released);
 	b2::jam::free_ptr(node);
 }
 
@@ -342,7 +421,18 @@ LIST * list_unique(LIST * sorted_list)
 	return result;
 }
 
-void list_done() { }
+void list_done()
+{
+	if (is_debug_mem())
+	{
+		out_printf(
+			"lists: %llu allocated, %llu reused, %llu recycled, %llu released\n",
+			(unsigned long long)stats.allocated.load(),
+			(unsigned long long)stats.reused.load(),
+			(unsigned long long)stats.recycled.load(),
+			(unsigned long long)stats.released.load());
+	}
+}
 
 void lol_add_err()
 {
@@ -27,6 +27,7 @@
  *
  * Internal routines:
  *  make0() - bind and scan everything to make a TARGET
+ *  make0bindprefetch() - query the paths targets may bind to in parallel
  *  make0sort() - reorder TARGETS chain by their time (newest to oldest)
  */
 
@@ -34,15 +35,18 @@
 #include "make.h"
 
 #include "command.h"
+#include "filesys.h"
 #ifdef OPT_HEADER_CACHE_EXT
 # include "hcache.h"
 #endif
 #include "headers.h"
 #include "lists.h"
+#include "mod_graph_snapshot.h"
 #include "object.h"
 #include "parse.h"
 #include "rules.h"
 #include "search.h"
+#include "tasks.h"
 #include "timestamp.h"
 #include "variable.h"
 #include "execcmd.h"
@@ -50,10 +54,14 @@
 
 #include <assert.h>
 
+#include <unordered_set>
+#include <vector>
+
 #ifndef max
 # define max(a,b) ((a)>(b)?(a):(b))
 #endif
 
+static void make0bindprefetch( LIST * targets );
 static targets_uptr make0sort( targets_uptr c );
 
 #ifdef OPT_GRAPH_DEBUG_EXT
@@ -115,12 +123,14 @@ int32_t make( LIST * targets, bool anyhow )
     {
         LISTITER iter, end;
         PROFILE_ENTER( MAKE_MAKE0 );
+        make0bindprefetch( targets );
         for ( iter = list_begin( targets ), end = list_end( targets ); iter != end; iter = list_next( iter ) )
         {
             TARGET * t = bindtarget( list_item( iter ) );
             if ( t->fate == T_FATE_INIT )
                 make0( t, 0, 0, counts, anyhow, 0 );
         }
+        headers_prefetch_done();
         PROFILE_EXIT( MAKE_MAKE0 );
     }
 
@@ -133,6 +143,27 @@ int32_t make( LIST * targets, bool anyhow )
     }
 #endif
 
+    make_report( counts );
+    b2::graph_snapshot::made( *counts );
+
+    status = counts->cantfind || counts->cantmake;
+
+    {
+        PROFILE_ENTER( MAKE_MAKE1 );
+        status |= make1( targets );
+        PROFILE_EXIT( MAKE_MAKE1 );
+    }
+
+    return status;
+}
+
+
+/*
+ * make_report() - print the counts of targets found, when debugging make.
+ */
+
+void make_report( COUNTS const * counts )
+{
     if ( is_debug_make() )
     {
         if ( counts->targets )
@@ -151,16 +182,6 @@ int32_t make( LIST * targets, bool anyhow )
             out_printf( "...can't make %d target%s...\n", counts->cantmake,
                 counts->cantmake > 1 ? "s" : "" );
     }
-
-    status = counts->cantfind || counts->cantmake;
-
-    {
-        PROFILE_ENTER( MAKE_MAKE1 );
-        status |= make1( targets );
-        PROFILE_EXIT( MAKE_MAKE1 );
-    }
-
-    return status;
 }
 
 
@@ -271,6 +292,118 @@ int32_t make0rescan( TARGET * t, TARGET * rescanning )
 }
 
 
+/*
+ * make0prefetch() - start the header scans of the dependencies, and their
+ * dependencies, that make0() did not get to yet. Scanning them in parallel
+ * while make0() works through the dependencies one at a time. Not done when
+ * tracing the search of targets, to only trace their actual binding.
+ */
+
+static void make0prefetch( TARGET * t, int32_t depth )
+{
+    targets_ptr c;
+    if ( is_debug_search() )
+        return;
+    for ( c = t->depends.get(); c; c = c->next.get() )
+    {
+        TARGET * const d = c->target;
+        if ( d->fate != T_FATE_INIT )
+            continue;
+        if ( ( d->binding == T_BIND_UNBOUND ) &&
+            !( d->flags & ( T_FLAG_NOTFILE | T_FLAG_INTERNAL ) ) )
+        {
+            pushsettings( root_module(), d->settings );
+            headers_prefetch( d );
+            popsettings( root_module(), d->settings );
+        }
+        if ( depth > 1 )
+            make0prefetch( d, depth - 1 );
+    }
+}
+
+
+/*
+ * make0bindprefetch() - query the file system, all together in parallel, about
+ * the paths that the targets, and their dependencies, bind to. Before make0()
+ * binds them one at a time, and finds the paths already cached. Done in rounds
+ * that follow search(). First the path each target binds to when it exists,
+ * then the next path only for the targets not found at the one before. Only
+ * covers the dependencies known before make0(), not the headers it finds.
+ *
+ * Skipped when the queries can not run in parallel, when it would only add to
+ * the time.
+ */
+
+static void make0bindprefetch( LIST * targets )
+{
+    std::vector<TARGET *> pending;
+    std::unordered_set<TARGET *> seen;
+    std::vector<TARGET *> unbound;
+
+#ifdef OS_NT
+    bool const parallel = false;
+#else
+    bool const parallel = b2::task::executor::get().parallelism() > 1;
+#endif
+    if ( !parallel )
+        return;
+
+    for ( auto name : b2::list_cref( targets ) )
+    {
+        TARGET * const t = bindtarget( name );
+        if ( t->fate == T_FATE_INIT && seen.insert( t ).second )
+            pending.push_back( t );
+    }
+
+    while ( !pending.empty() )
+    {
+        TARGET * const t = pending.back();
+        pending.pop_back();
+        if ( ( t->binding == T_BIND_UNBOUND ) &&
+            !( t->flags & T_FLAG_NOTFILE ) )
+            unbound.push_back( t );
+        for ( targets_ptr c = t->depends.get(); c; c = c->next.get() )
+            if ( c->target->fate == T_FATE_INIT &&
+                seen.insert( c->target ).second )
+                pending.push_back( c->target );
+    }
+
+    for ( int32_t n = 0; !unbound.empty(); ++n )
+    {
+        std::vector<TARGET *> searched;
+        LIST * paths = L0;
+        for ( TARGET * t : unbound )
+        {
+            pushsettings( root_module(), t->settings );
+            OBJECT * const path = search_path( t->name, n );
+            popsettings( root_module(), t->settings );
+            if ( !path )
+                continue;
+            searched.push_back( t );
+            paths = list_push_back( paths, path );
+        }
+
+        /* The missing paths are in the same order as the searched targets. */
+        LIST * const missing = file_query_prefetch( paths );
+        LISTITER m = list_begin( missing );
+        LISTITER const m_end = list_end( missing );
+        LISTITER p = list_begin( paths );
+        unbound.clear();
+        for ( TARGET * t : searched )
+        {
+            if ( m != m_end && object_equal( list_item( m ), list_item( p ) ) )
+            {
+                unbound.push_back( t );
+                m = list_next( m );
+            }
+            p = list_next( p );
+        }
+        list_free( missing );
+        list_free( paths );
+    }
+}
+
+
 /*
  * make0() - bind and scan everything to make a TARGET.
  *
@@ -408,6 +541,7 @@ void make0
      */
 
     /* Step 3a: Recursively make0() dependencies. */
+    make0prefetch( t, 2 );
     for ( c = t->depends.get(); c; c = c->next.get() )
     {
         int32_t const internal = t->flags & T_FLAG_INTERNAL;
@@ -32,6 +32,9 @@ struct COUNTS {
 void make0( TARGET * t, TARGET * p, int32_t depth, COUNTS * counts, bool anyhow,
     TARGET * rescanning );
 
+/* Prints the counts of targets found, when debugging make. */
+void make_report( COUNTS const * counts );
+
 
 /* Specifies that the target should be updated. */
 void mark_target_for_updating( OBJECT * target );
@@ -31,6 +31,7 @@
  *
  * Internal support routines:
  *   make1cmds()     - turn ACTIONS into CMDs, grouping, splitting, etc.
+ *   make1weights()  - compute the critical path weights for --critical-path
  *   make1list()     - turn a list of targets into a LIST, for $(<) and $(>)
  *   make1settings() - for vars with bound values, build up replacement lists
  *   make1bind()     - bind targets that weren't bound in dependency analysis
@@ -55,11 +56,16 @@
 #include "output.h"
 #include "startup.h"
 
+#include "mod_action_cache.h"
 #include "mod_summary.h"
+#include "mod_timing_db.h"
 
 #include <assert.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <memory>
+#include <unordered_set>
+#include <vector>
 
 #if !defined( NT ) || defined( __GNUC__ )
     #include <unistd.h>  /* for unlink */
@@ -69,6 +75,7 @@ static CMD      * make1cmds      ( TARGET * );
 static LIST     * make1list      ( LIST *, const targets_uptr &, int32_t flags );
 static SETTINGS * make1settings  ( struct module_t *, LIST * vars );
 static void       make1bind      ( TARGET * );
+static void       make1weights   ( LIST * targets );
 static void       push_cmds( CMDLIST * cmds, int32_t status );
 static int32_t    cmd_sem_lock( TARGET * t );
 static void       cmd_sem_unlock( TARGET * t );
@@ -94,6 +101,7 @@ static const char * targets_skipped = "targets skipped";
 #define T_STATE_MAKE1A  0  /* make1a() should be called */
 #define T_STATE_MAKE1B  1  /* make1b() should be called */
 #define T_STATE_MAKE1C  2  /* make1c() should be called */
+#define T_STATE_MAKE1C_READY  3  /* make1c() should run the next command */
 
 namespace {
 typedef struct _state state;
@@ -126,6 +134,26 @@ static state * state_freelist = NULL;
 /* Currently running command counter. */
 static int32_t cmdsrunning;
 
+/* Targets with a command ready to run, for --critical-path. The ones with the
+ * largest path weight run first, and otherwise in the order they got ready.
+ */
+namespace {
+struct ready_cmd
+{
+    double weight;
+    uint64_t order;
+    TARGET * t;
+
+    bool operator<( ready_cmd const & o ) const
+    {
+        return weight < o.weight || ( weight == o.weight && order > o.order );
+    }
+};
+}
+
+static std::vector<ready_cmd> ready_cmds;
+static uint64_t ready_cmds_order = 0;
+
 
 static state * alloc_state()
 {
@@ -229,6 +257,9 @@ int32_t make1( LIST * targets )
         push_stack_on_stack( &state_stack, &temp_stack );
     }
 
+    if ( globs.critical_path )
+        make1weights( targets );
+
     /* Clear any state left over from the past */
     quit = 0;
 
@@ -246,10 +277,22 @@ int32_t make1( LIST * targets )
                 case T_STATE_MAKE1A: make1a( pState ); break;
                 case T_STATE_MAKE1B: make1b( pState ); break;
                 case T_STATE_MAKE1C: make1c( pState ); break;
+                case T_STATE_MAKE1C_READY: make1c( pState ); break;
                 default:
                     assert( !"make1(): Invalid state detected." );
             }
         }
+        /* Start the ready command with the longest path, if there is room. */
+        if ( quit )
+            ready_cmds.clear();
+        if ( !ready_cmds.empty() && cmdsrunning < globs.jobs )
+        {
+            std::pop_heap( ready_cmds.begin(), ready_cmds.end() );
+            push_state( &state_stack, ready_cmds.back().t, NULL,
+                T_STATE_MAKE1C_READY );
+            ready_cmds.pop_back();
+            continue;
+        }
         if ( !cmdsrunning )
             break;
         /* Wait for outstanding commands to finish running. */
@@ -541,6 +584,7 @@ static void make1c( state const * const pState )
 {
     TARGET * const t = pState->t;
     CMD * const cmd = (CMD *)t->cmds;
+    bool const ready = pState->curstate == T_STATE_MAKE1C_READY;
     int32_t exec_flags = 0;
 
     if ( cmd )
@@ -560,6 +604,14 @@ static void make1c( state const * const pState )
             return;
         }
 
+        /* With --critical-path the command waits its turn in make1(). */
+        if ( globs.critical_path && !ready )
+        {
+            ready_cmds.push_back( { t->path_weight, ready_cmds_order++, t } );
+            std::push_heap( ready_cmds.begin(), ready_cmds.end() );
+            return;
+        }
+
 #ifdef OPT_SEMAPHORE
         if ( ! cmd_sem_lock( t ) )
         {
@@ -610,6 +662,14 @@ static void make1c( state const * const pState )
             timestamp_copy( &time_info.end, &time_info.start );
             make1c_closure( t, EXEC_CMD_OK, &time_info, "", "", EXIT_OK );
         }
+        else if ( b2::action_cache::restore( t, cmd ) )
+        {
+            /* The outputs got restored from the action cache. */
+            timing_info time_info = { 0 };
+            timestamp_current( &time_info.start );
+            timestamp_copy( &time_info.end, &time_info.start );
+            make1c_closure( t, EXEC_CMD_OK, &time_info, "", "", EXIT_OK );
+        }
         else
         {
             exec_cmd( cmd->buf, exec_flags, make1c_closure, t, cmd->shell );
@@ -622,7 +682,7 @@ static void make1c( state const * const pState )
              * affected Boost Build tests be updated.
              */
             assert( 0 < globs.jobs );
-            while ( cmdsrunning >= globs.jobs )
+            while ( !globs.critical_path && cmdsrunning >= globs.jobs )
                 exec_wait();
         }
     }
@@ -710,6 +770,7 @@ static void make1c( state const * const pState )
                      */
                     make0( t->includes, t->parents->target, 0, 0, 0, t->includes
                         );
+                    headers_prefetch_done();
                     /* Link the old includes on to make sure that it gets
                      * cleaned up correctly.
                      */
@@ -947,9 +1008,17 @@ static void make1c_closure
     out_flush();
     err_flush();
 
+    /* Record the outputs of the command in the action cache. */
+    b2::action_cache::store( cmd, status_orig == EXEC_CMD_OK );
+
     if ( !globs.noexec )
     {
         call_timing_rule( t, time );
+        /* Commands faked, or restored from the action cache, have no times. */
+        if ( timestamp_cmp( &time->start, &time->end ) || time->user ||
+            time->system )
+            b2::timing_db::record( cmd->rule->name,
+                list_front( lol_get( (LOL *)&cmd->args, 0 ) ), *time );
         if ( is_debug_execcmd() )
             out_printf( "%f sec system; %f sec user; %f sec clock\n",
                 time->system, time->user,
@@ -1456,6 +1525,63 @@ static void make1bind( TARGET * t )
 }
 
 
+/*
+ * make1weights() - compute the critical path weights for --critical-path
+ *
+ * The path weight of a target is the longest chain of actions, from the target
+ * up to one of the targets being built, that need to run one after the other.
+ * Each action to run counts with its duration as estimated by the timing-db.
+ */
+
+static double make1weight( TARGET * t )
+{
+    double weight = 0;
+    if ( !t->actions || t->fate < T_FATE_BUILD || t->fate >= T_FATE_BROKEN )
+        return 0;
+    for ( actions_ptr a = t->actions; a; a = a->next )
+        weight += b2::timing_db::estimate( a->action->rule->name,
+            t->boundname );
+    return weight;
+}
+
+static void make1weights_order( TARGET * t, std::unordered_set<TARGET *> &
+    visited, std::vector<TARGET *> & order )
+{
+    targets_ptr c;
+    if ( !visited.insert( t ).second )
+        return;
+    for ( c = t->depends.get(); c; c = c->next.get() )
+        make1weights_order( c->target, visited, order );
+    order.push_back( t );
+}
+
+static void make1weights( LIST * targets )
+{
+    std::unordered_set<TARGET *> visited;
+    std::vector<TARGET *> order;
+    LISTITER iter, end;
+
+    for ( iter = list_begin( targets ), end = list_end( targets ); iter != end;
+        iter = list_next( iter ) )
+        make1weights_order( bindtarget( list_item( iter ) ), visited, order );
+
+    /* Visit the dependants before their dependencies, passing down the
+     * longest path to each dependency.
+     */
+    for ( TARGET * t : order )
+        t->path_weight = 0;
+    for ( auto i = order.rbegin(); i != order.rend(); ++i )
+    {
+        TARGET * const t = *i;
+        targets_ptr c;
+        t->path_weight += make1weight( t );
+        for ( c = t->depends.get(); c; c = c->next.get() )
+            c->target->path_weight = std::max( c->target->path_weight,
+                t->path_weight );
+    }
+}
+
+
 static bool targets_contains( const targets_uptr & ts, TARGET * t )
 {
     targets_ptr l = ts.get();
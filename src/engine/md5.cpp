@@ -382,3 +382,25 @@ md5_finish(md5_state_t *pms, md5_byte_t digest[16])
     for (i = 0; i < 16; ++i)
         digest[i] = (md5_byte_t)(pms->abcd[i >> 2] >> ((i & 3) << 3));
 }
+
+void
+b2::md5_add(md5_state_t & state, const std::string & s)
+{
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(s.c_str()),
+        s.size() + 1);
+}
+
+std::string
+b2::md5_hex(md5_state_t & state)
+{
+    static const char hex[] = "0123456789abcdef";
+    md5_byte_t digest[16];
+    std::string result;
+    md5_finish(&state, digest);
+    for (md5_byte_t b : digest)
+    {
+        result += hex[(b >> 4) & 0xf];
+        result += hex[b & 0xf];
+    }
+    return result;
+}
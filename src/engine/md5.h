@@ -55,6 +55,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 
 /*
  * This package supports both compile-time and run-time determination of CPU
@@ -85,4 +86,14 @@ void md5_append(md5_state_t *pms, const md5_byte_t *data, std::size_t nbytes);
 /* Finish the message and return the digest. */
 void md5_finish(md5_state_t *pms, md5_byte_t digest[16]);
 
+namespace b2 {
+
+/* Append a string, and its terminating null to separate consecutive strings. */
+void md5_add(md5_state_t & state, const std::string & s);
+
+/* Finish the message and return the digest as hex digits. */
+std::string md5_hex(md5_state_t & state);
+
+} // namespace b2
+
 #endif /* md5_INCLUDED */
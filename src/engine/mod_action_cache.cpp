@@ -0,0 +1,286 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "jam.h"
+#include "mod_action_cache.h"
+
+#include "cwd.h"
+#include "events.h"
+#include "filesys.h"
+#include "lists.h"
+#include "md5.h"
+#include "object.h"
+#include "output.h"
+#include "pathsys.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace b2 { namespace action_cache {
+
+namespace {
+
+const char * key_version = "b2-action-cache-1";
+
+bool is_file(const std::string & path)
+{
+	struct stat st;
+	return ::stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG;
+}
+
+bool copy_file(const std::string & from, const std::string & to)
+{
+	FILE * in = std::fopen(from.c_str(), "rb");
+	if (!in) return false;
+	bool ok = b2::filesys::replace_file(to, [in](FILE * out) {
+		char buf[64 * 1024];
+		std::size_t n = 0;
+		while ((n = std::fread(buf, 1, sizeof(buf), in)) > 0)
+			if (std::fwrite(buf, 1, n, out) != n) return false;
+		return !std::ferror(in);
+	}, true);
+	std::fclose(in);
+	return ok;
+}
+
+void make_dirs(const std::string & path)
+{
+	std::string::size_type i = 0;
+	while ((i = path.find_first_of("/\\", i + 1)) != std::string::npos)
+		file_mkdir(path.substr(0, i).c_str());
+	file_mkdir(path.c_str());
+}
+
+struct cache
+{
+	std::string dir;
+	std::unordered_map<std::string, std::string> digests;
+	std::unordered_map<CMD *, std::string> pending;
+	int32_t hits = 0;
+	int32_t stored = 0;
+
+	static cache & get()
+	{
+		static cache c;
+		return c;
+	}
+
+	void set_dir(const std::string & d)
+	{
+		if (dir.empty())
+		{
+			add_event_callback(event_tag::exit_main,
+				std::function<void(int)>(
+					[](int) { cache::get().exit_main(); }));
+		}
+		dir = b2::paths::normalize(
+			b2::paths::is_rooted(d) ? d : b2::cwd_str() + "/" + d);
+		make_dirs(dir);
+	}
+
+	// Content digest of a file, cached for the duration of the run.
+	const std::string & file_digest(OBJECT * path)
+	{
+		std::string p = object_str(path);
+		auto i = digests.find(p);
+		if (i != digests.end()) return i->second;
+		md5_state_t state;
+		md5_init(&state);
+		if (is_file(p))
+		{
+			b2::filesys::file_buffer data(p, true);
+			md5_append(&state,
+				reinterpret_cast<const md5_byte_t *>(data.begin()),
+				data.size());
+		}
+		return digests.emplace(p, md5_hex(state)).first->second;
+	}
+
+	// Collect the dependencies that influence the result of building `t`.
+	// That's the direct dependencies and, transitively, the headers they
+	// include. Internal include nodes are traversed but not recorded.
+	void collect_inputs(TARGET * t,
+		std::unordered_set<TARGET *> & visited,
+		std::vector<TARGET *> & inputs)
+	{
+		for (targets_ptr c = t->depends.get(); c; c = c->next.get())
+		{
+			TARGET * d = c->target;
+			if (!visited.insert(d).second) continue;
+			if (!(d->flags & T_FLAG_INTERNAL)) inputs.push_back(d);
+			if (d->flags & T_FLAG_INTERNAL)
+				collect_inputs(d, visited, inputs);
+			else if (d->includes && visited.insert(d->includes).second)
+				collect_inputs(d->includes, visited, inputs);
+		}
+	}
+
+	std::string compute_key(TARGET * t, CMD * cmd)
+	{
+		md5_state_t state;
+		md5_init(&state);
+		md5_add(state, key_version);
+		md5_add(state, cmd->buf->value);
+		for (auto s : list_cref(cmd->shell)) md5_add(state, s->str());
+
+		std::unordered_set<TARGET *> visited { t };
+		std::vector<TARGET *> inputs;
+		collect_inputs(t, visited, inputs);
+		// Sort so that dependency ordering (i.e. "-g") does not affect the key.
+		std::sort(inputs.begin(), inputs.end(), [](TARGET * a, TARGET * b) {
+			return std::strcmp(object_str(a->boundname),
+					   object_str(b->boundname))
+				< 0;
+		});
+		for (TARGET * d : inputs)
+		{
+			md5_add(state, object_str(d->boundname));
+			if (d->flags & T_FLAG_NOTFILE)
+				md5_add(state, "*");
+			else
+				md5_add(state, file_digest(d->boundname));
+		}
+		return md5_hex(state);
+	}
+
+	std::string entry_dir(const std::string & key)
+	{
+		return dir + "/" + key.substr(0, 2) + "/" + key;
+	}
+
+	bool restore(TARGET * t, CMD * cmd)
+	{
+		LIST * outputs = lol_get(&cmd->args, 0);
+		if (list_empty(outputs)
+			|| (t->flags & (T_FLAG_NOTFILE | T_FLAG_FAIL_EXPECTED)))
+			return false;
+
+		std::string key = compute_key(t, cmd);
+		std::string entry = entry_dir(key);
+		FILE * manifest = std::fopen((entry + "/outputs").c_str(), "r");
+		if (!manifest)
+		{
+			pending[cmd] = key;
+			return false;
+		}
+
+		// The manifest lists one "<mode> <path>" line per output, in the
+		// order of the action targets.
+		bool ok = true;
+		int32_t index = 0;
+		for (auto output : list_cref(outputs))
+		{
+			unsigned mode = 0;
+			char path[4096];
+			if (std::fscanf(manifest, "%o %4095[^\n]\n", &mode, path) != 2
+				|| output->str() != std::string(path))
+			{
+				ok = false;
+				break;
+			}
+			ok = copy_file(entry + "/" + std::to_string(index++), path);
+			if (!ok) break;
+#ifndef NT
+			::chmod(path, mode);
+#endif
+			digests.erase(path);
+		}
+		std::fclose(manifest);
+
+		if (!ok)
+		{
+			pending[cmd] = key;
+			return false;
+		}
+		if (is_debug_execcmd())
+			out_printf("...restored %s from action cache %s...\n",
+				object_str(list_front(outputs)), key.c_str());
+		hits += 1;
+		return true;
+	}
+
+	void store(CMD * cmd, bool succeeded)
+	{
+		auto pending_i = pending.find(cmd);
+		if (pending_i == pending.end()) return;
+		std::string key = std::move(pending_i->second);
+		pending.erase(pending_i);
+
+		LIST * outputs = lol_get(&cmd->args, 0);
+		for (auto output : list_cref(outputs))
+		{
+			// The output files changed, forget the old digests.
+			digests.erase(output->str());
+			if (!is_file(output->str())) succeeded = false;
+		}
+		if (!succeeded) return;
+
+		// Fill a temporary entry and move it in place when complete. That way
+		// concurrent, or interrupted, builds never see partial entries.
+		std::string entry = entry_dir(key);
+		OBJECT * tmp_name = path_tmpnam();
+		std::string entry_tmp = entry + "." + object_str(tmp_name);
+		object_free(tmp_name);
+		make_dirs(entry_tmp);
+		FILE * manifest = std::fopen((entry_tmp + "/outputs").c_str(), "w");
+		bool ok = manifest != nullptr;
+		int32_t index = 0;
+		for (auto output : list_cref(outputs))
+		{
+			if (!ok) break;
+			std::string blob = entry_tmp + "/" + std::to_string(index++);
+			ok = copy_file(output->str(), blob);
+			struct stat st;
+			unsigned mode
+				= ::stat(output->str(), &st) == 0 ? st.st_mode & 07777 : 0644;
+			ok = ok && std::fprintf(manifest, "%o %s\n", mode, output->str()) > 0;
+		}
+		if (manifest) ok = (std::fclose(manifest) == 0) && ok;
+		if (!ok || std::rename(entry_tmp.c_str(), entry.c_str()) != 0)
+		{
+			for (int32_t i = 0; i < index; ++i)
+				std::remove((entry_tmp + "/" + std::to_string(i)).c_str());
+			std::remove((entry_tmp + "/outputs").c_str());
+			std::remove(entry_tmp.c_str());
+			return;
+		}
+		stored += 1;
+	}
+
+	void exit_main()
+	{
+		if (is_debug_make() && (hits > 0 || stored > 0))
+			out_printf("...action cache: %d restored, %d stored...\n", hits,
+				stored);
+	}
+};
+
+} // namespace
+
+void set_dir(value_ref dirname) { cache::get().set_dir(dirname->str()); }
+
+bool enabled() { return !cache::get().dir.empty(); }
+
+bool restore(TARGET * t, CMD * cmd)
+{
+	if (!enabled()) return false;
+	return cache::get().restore(t, cmd);
+}
+
+void store(CMD * cmd, bool succeeded)
+{
+	if (!enabled()) return;
+	cache::get().store(cmd, succeeded);
+}
+
+}} // namespace b2::action_cache
@@ -0,0 +1,82 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_ACTION_CACHE_H
+#define B2_MOD_ACTION_CACHE_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "command.h"
+#include "rules.h"
+#include "value.h"
+
+/* tag::reference[]
+
+[[b2.reference.modules.action_cache]]
+= `action-cache` module.
+
+A local, content addressed, cache of action results. When enabled each action
+command is keyed by its expanded command text, the shell it runs in, and the
+content digests of all its dependencies (sources and discovered headers). If an
+entry for the key exists the recorded outputs are restored from the cache
+instead of running the command. Successful commands record their outputs into
+the cache.
+
+The cache is enabled with the `--action-cache=<dir>` command line option or by
+calling `action-cache.set-dir`.
+
+end::reference[] */
+
+namespace b2 { namespace action_cache {
+
+/* tag::reference[]
+
+== `b2::action_cache::set_dir`
+
+====
+[horizontal]
+Jam:: `rule set-dir ( dirname )`
+{CPP}:: `void set_dir(value_ref dirname);`
+====
+
+Enables the action cache, storing entries in the given directory. The
+directory is created if it doesn't exist.
+
+end::reference[] */
+void set_dir(value_ref dirname);
+
+// Internal..
+
+bool enabled();
+
+// Try and restore the outputs of the command from the cache. Returns true if
+// the outputs got restored and the command does not need to run.
+bool restore(TARGET * t, CMD * cmd);
+
+// Record the outputs of the command in the cache, if the command succeeded
+// and it was looked up with `restore` before.
+void store(CMD * cmd, bool succeeded);
+
+}} // namespace b2::action_cache
+
+namespace b2 {
+
+struct action_cache_module : b2::bind::module_<action_cache_module>
+{
+	const char * module_name = "action-cache";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		binder.def(&action_cache::set_dir, "set-dir", ("dirname" * _1));
+		binder.loaded();
+	}
+};
+
+} // namespace b2
+
+#endif
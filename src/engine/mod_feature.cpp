@@ -0,0 +1,1071 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "mod_feature.h"
+
+#include "mod_jam_errors.h"
+#include "mod_version.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace b2 { namespace feature {
+
+namespace {
+
+using value_set = std::unordered_set<value_ref,
+	value_ref::hash_function,
+	value_ref::equal_function>;
+template <class T>
+using value_map = std::unordered_map<value_ref,
+	T,
+	value_ref::hash_function,
+	value_ref::equal_function>;
+
+// The attribute names, in the order of the attribute bits.
+const char * const attribute_names[] = { "implicit", "composite", "optional",
+	"symmetric", "free", "incidental", "path", "dependency", "propagated",
+	"link-incompatible", "subfeature", "order-sensitive", "hidden",
+	"version" };
+const std::size_t attribute_count
+	= sizeof(attribute_names) / sizeof(attribute_names[0]);
+
+struct feature_def
+{
+	unsigned attributes = 0;
+	list_ref attribute_list;
+	list_ref values;
+	value_set value_index;
+	value_ref default_value;
+	list_ref subfeatures;
+};
+
+struct registry
+{
+	// The features, by their "<name>".
+	value_map<feature_def> features;
+	// The features that are not subfeatures, in declaration order.
+	list_ref top_features;
+	value_set top_feature_index;
+	// The features with each attribute, in declaration order.
+	list_ref attribute_features[attribute_count];
+	// The feature of each implicit value.
+	value_map<value_ref> implicit_features;
+	// The subfeature name for each "<feature>value-string<>subvalue".
+	value_map<value_ref> subvalue_subfeatures;
+	// The components of the composite properties.
+	value_map<list_ref> components;
+	// The ungristed features that are relevant when the key feature is.
+	value_map<list_ref> dependencies;
+};
+
+registry & current()
+{
+	static registry r;
+	return r;
+}
+
+// The registries moved aside by prepare-test, by the temporary module name.
+std::unordered_map<std::string, registry> & saved()
+{
+	static std::unordered_map<std::string, registry> r;
+	return r;
+}
+
+std::size_t attribute_index(unsigned bit)
+{
+	std::size_t i = 0;
+	while (bit > 1u) bit >>= 1, ++i;
+	return i;
+}
+
+feature_def * find(value_ref feature)
+{
+	if (!feature.has_value()) return nullptr;
+	auto & features = current().features;
+	auto i = features.find(feature);
+	return i == features.end() ? nullptr : &i->second;
+}
+
+unsigned bits_of(value_ref feature)
+{
+	feature_def * def = find(feature);
+	return def ? def->attributes : 0;
+}
+
+// The grist, i.e. the "<feature>", of the property, or empty if none.
+std::string grist_of(const char * p)
+{
+	const char * e = p[0] == '<' ? std::strchr(p, '>') : nullptr;
+	return e ? std::string(p, e + 1) : std::string();
+}
+
+// The value of the property, i.e. without the grist.
+const char * value_of(const char * p)
+{
+	const char * e = p[0] == '<' ? std::strchr(p, '>') : nullptr;
+	return e ? e + 1 : p;
+}
+
+// Adds the "<>" to the name, if not already there. Like ":G=name" does.
+value_ref grist(value_ref name)
+{
+	std::string s = name->str();
+	if (s.empty()) return name;
+	if (s.front() != '<') s.insert(0, 1, '<');
+	if (s.back() != '>') s.push_back('>');
+	return value_ref(s);
+}
+
+std::string ungrist(const std::string & feature)
+{
+	if (feature.size() >= 2 && feature.front() == '<' && feature.back() == '>')
+		return feature.substr(1, feature.size() - 2);
+	return feature;
+}
+
+std::vector<std::string> split_string(const char * s, char separator)
+{
+	std::vector<std::string> result;
+	for (const char * b = s;; ++s)
+	{
+		if (*s == separator || *s == '\0')
+		{
+			result.emplace_back(b, s);
+			if (*s == '\0') break;
+			b = s + 1;
+		}
+	}
+	return result;
+}
+
+// The string order, as SORT uses.
+bool less(value_ptr a, value_ptr b)
+{
+	return std::strcmp(a->str(), b->str()) < 0;
+}
+
+// The argument, of one element, to errors.error.
+list_ref message(const std::string & text) { return list_ref(value_ref(text)); }
+
+// The default property of the feature, if it has one.
+value_ref default_of(value_ref feature)
+{
+	feature_def * def = find(feature);
+	if (!def || !def->default_value.has_value()
+		|| (def->attributes
+			& (attribute_free | attribute_optional | attribute_version)))
+		return value_ref();
+	return value_ref(std::string(feature->str()) + def->default_value->str());
+}
+
+// Is a feature with an unbounded set of values, i.e. a free feature.
+bool is_variable_feature(value_ref feature)
+{
+	return (bits_of(feature) & attribute_free) != 0;
+}
+
+value_ref find_implied_subfeature(const std::string & feature,
+	const char * value_string,
+	const char * subvalue)
+{
+	// The subfeatures specific to the value come first, then the ones for any
+	// value of the feature.
+	auto & subfeatures = current().subvalue_subfeatures;
+	auto i = subfeatures.find(
+		value_ref(feature + value_string + "<>" + subvalue));
+	if (i == subfeatures.end() && *value_string)
+		i = subfeatures.find(value_ref(feature + "<>" + subvalue));
+	return i == subfeatures.end() ? value_ref() : i->second;
+}
+
+// Given an ungristed string, finds the longest prefix which is a top-level
+// feature name followed by a dash. Feature names can contain dashes, hence
+// the prefixes to look at are all the ones that end before a dash.
+struct top_feature_split
+{
+	bool has_rest = false;
+	std::string top, rest;
+
+	explicit top_feature_split(const std::string & feature_plus)
+	{
+		auto & tops = current().top_feature_index;
+		for (std::size_t n = feature_plus.size();; --n)
+		{
+			if (n == feature_plus.size() || feature_plus[n] == '-')
+			{
+				top = feature_plus.substr(0, n);
+				if (tops.count(value_ref("<" + top + ">")) > 0)
+				{
+					has_rest = n < feature_plus.size();
+					if (has_rest) rest = feature_plus.substr(n + 1);
+					return;
+				}
+			}
+			if (n == 0) break;
+		}
+	}
+};
+
+// Return true iff f is an ordinary subfeature of the parent-property's
+// feature, or if f is a subfeature of the parent-property's feature specific
+// to the parent-property's value.
+bool is_subfeature_of(const char * parent_property, value_ref f)
+{
+	if (!(bits_of(f) & attribute_subfeature)) return false;
+	std::string name = f->str();
+	auto lt = name.find('<');
+	auto gt = name.rfind('>');
+	auto colon = gt == std::string::npos ? gt : name.rfind(':', gt);
+	if (lt != std::string::npos && colon != std::string::npos && colon > lt)
+	{
+		// The feature has the form <topfeature-topvalue:subfeature>, e.g.
+		// <toolset-msvc:version>.
+		top_feature_split feature_value(name.substr(lt + 1, colon - lt - 1));
+		return feature_value.has_rest
+			&& "<" + feature_value.top + ">" + feature_value.rest
+			== parent_property;
+	}
+	// The feature has the form <topfeature-subfeature>, e.g.
+	// <toolset-version>
+	top_feature_split top_sub(ungrist(name));
+	return top_sub.has_rest && !top_sub.rest.empty()
+		&& "<" + top_sub.top + ">" == grist_of(parent_property);
+}
+
+// The properties that are subproperties of the parent property, sorted.
+list_ref sorted_subproperties(
+	const char * parent_property, const std::vector<value_ptr> & properties)
+{
+	std::vector<value_ptr> subs;
+	for (auto p : properties)
+		if (is_subfeature_of(parent_property, value_ref(grist_of(p->str()))))
+			subs.push_back(p);
+	std::stable_sort(subs.begin(), subs.end(), less);
+	list_ref result;
+	for (auto p : subs) result.push_back(p);
+	return result;
+}
+
+std::string joined_values(const list_ref & properties)
+{
+	std::string result;
+	for (auto p : properties)
+	{
+		if (!result.empty()) result += "-";
+		result += value_of(p->str());
+	}
+	return result;
+}
+
+void expand_composite(value_ref property, list_ref & result)
+{
+	result.push_back(value_ptr(property));
+	auto & components = current().components;
+	auto i = components.find(property);
+	if (i != components.end())
+		for (auto c : i->second) expand_composite(value_ref(c), result);
+}
+
+// Given a feature and value, or just a value corresponding to an implicit
+// feature, adds the property set consisting of all component subfeatures and
+// their values. For example both "<toolset>gcc-2.95.2-linux" and
+// "gcc-2.95.2-linux" add:
+//
+//   <toolset>gcc <toolset-gcc:version>2.95.2 <toolset-gcc:os>linux
+void expand_subfeatures_aux(value_ref feature,
+	const char * value,
+	bool dont_validate,
+	list_ref & result,
+	bind::context_ref_ context_ref)
+{
+	if (!feature.has_value())
+		feature = implied_feature(value_ref(value), context_ref);
+	else
+		validate_feature(feature, context_ref);
+	if (!dont_validate)
+		validate_value_string(
+			std::make_tuple(feature, value_ref(value)), context_ref);
+
+	const std::string f = feature->str();
+	auto components = split_string(value, '-');
+	list_ref subproperties;
+	for (std::size_t i = 1; i < components.size(); ++i)
+	{
+		value_ref subfeature = find_implied_subfeature(
+			f, components[0].c_str(), components[i].c_str());
+		// If no subfeature was found reconstitute the value string and use
+		// that.
+		if (!subfeature.has_value())
+		{
+			result.push_back(f + value);
+			return;
+		}
+		subproperties.push_back("<" + ungrist(f) + "-" + subfeature->str()
+			+ ">" + components[i]);
+	}
+	result.push_back(f + components[0]);
+	result.append(subproperties);
+}
+
+// The expansion rules require explicit features, this checks for values of
+// implicit features given without their feature.
+void check_explicit(list_cref properties,
+	const char * message_prefix,
+	bind::context_ref_ context_ref)
+{
+	value_set values;
+	for (auto p : properties) values.insert(value_ref(value_of(p->str())));
+	for (auto p : properties)
+	{
+		if (values.count(value_ref(p)) > 0)
+		{
+			jam::errors::error(lists()
+					| message(std::string(message_prefix) + "\"" + p->str()
+						+ "\" appears to be the value of an un-expanded "
+						  "implicit feature"),
+				context_ref);
+			return;
+		}
+	}
+}
+
+} // namespace
+
+void declare(value_ref name, list_cref attributes)
+{
+	registry & r = current();
+	value_ref feature = grist(name);
+	feature_def & def = r.features[feature];
+	def.attribute_list = attributes;
+	def.attributes = 0;
+	for (auto a : attributes)
+	{
+		for (std::size_t i = 0; i < attribute_count; ++i)
+		{
+			if (std::strcmp(a->str(), attribute_names[i]) == 0)
+			{
+				def.attributes |= 1u << i;
+				r.attribute_features[i].push_back(value_ptr(feature));
+			}
+		}
+	}
+	if (!(def.attributes & attribute_subfeature))
+	{
+		r.top_features.push_back(value_ptr(feature));
+		r.top_feature_index.insert(feature);
+	}
+}
+
+list_ref attributes(value_ref feature)
+{
+	feature_def * def = find(feature);
+	return def ? def->attribute_list : list_ref();
+}
+
+list_ref values(value_ref feature)
+{
+	feature_def * def = find(grist(feature));
+	return def ? def->values : list_ref();
+}
+
+list_ref subfeatures(value_ref feature)
+{
+	feature_def * def = find(grist(feature));
+	return def ? def->subfeatures : list_ref();
+}
+
+bool valid(list_cref names)
+{
+	for (auto name : names)
+		if (!find(value_ref(name))) return false;
+	return true;
+}
+
+list_ref defaults(list_cref features)
+{
+	list_ref result;
+	for (auto f : features)
+	{
+		value_ref d = default_of(grist(value_ref(f)));
+		if (d.has_value()) result.push_back(value_ptr(d));
+	}
+	return result;
+}
+
+list_ref free_features()
+{
+	return current().attribute_features[attribute_index(attribute_free)];
+}
+
+list_ref get_values(value_ref feature, list_cref properties)
+{
+	const std::string f = grist(feature)->str();
+	list_ref result;
+	for (auto p : properties)
+		if (grist_of(p->str()) == f) result.push_back(value_of(p->str()));
+	return result;
+}
+
+list_ref split(value_ref property_set)
+{
+	// The pieces are separated by slashes or backslashes, since Jam, unbidden,
+	// sometimes swaps slash direction on NT.
+	std::vector<std::string> pieces;
+	const char * s = property_set->str();
+	for (const char * b = s;; ++s)
+	{
+		if (*s == '/' || *s == '\\' || *s == '\0')
+		{
+			std::string x(b, s);
+			if (grist_of(x.c_str()).empty() && !pieces.empty()
+				&& !grist_of(pieces.back().c_str()).empty())
+				pieces.back() += "/" + x;
+			else
+				pieces.push_back(x);
+			if (*s == '\0') break;
+			b = s + 1;
+		}
+	}
+	list_ref result;
+	for (auto & p : pieces) result.push_back(p);
+	return result;
+}
+
+list_ref expand_subfeatures(
+	list_cref properties, bool dont_validate, bind::context_ref_ context_ref)
+{
+	list_ref result;
+	for (auto p : properties)
+	{
+		const std::string g = grist_of(p->str());
+		// Don't expand subfeatures in subfeatures
+		if (g.find(':') != std::string::npos)
+			result.push_back(p);
+		else
+			expand_subfeatures_aux(g.empty() ? value_ref() : value_ref(g),
+				value_of(p->str()), dont_validate, result, context_ref);
+	}
+	return result;
+}
+
+list_ref expand_composites(list_cref properties, bind::context_ref_ context_ref)
+{
+	value_set given { properties.begin(), properties.end() };
+	value_set explicit_features;
+	for (auto p : properties)
+		explicit_features.insert(value_ref(grist_of(p->str())));
+
+	list_ref result;
+	value_set in_result, result_features;
+	auto add = [&](value_ref x, value_ref f) {
+		result.push_back(value_ptr(x));
+		in_result.insert(x);
+		result_features.insert(f);
+	};
+	for (auto p : properties)
+	{
+		list_ref expanded;
+		expand_composite(value_ref(p), expanded);
+		for (auto x : expanded)
+		{
+			if (in_result.count(value_ref(x)) > 0) continue;
+			value_ref f(grist_of(x->str()));
+			if (bits_of(f) & (attribute_free | attribute_version))
+			{
+				add(x, f);
+			}
+			else if (given.count(value_ref(x)) == 0)
+			{
+				// x is the result of expansion, and not explicitly-specified.
+				if (explicit_features.count(f) > 0) continue;
+				if (result_features.count(f) > 0)
+				{
+					jam::errors::error(lists()
+							| message("expansions of composite features result "
+									  "in conflicting values for "
+								+ std::string(f->str()))
+							| *(list_ref(value_ref("values:"))
+									  .append(get_values(f, result.cref()))
+								+ value_of(x->str()))
+							| message("one contributing composite property was "
+								+ std::string(p->str())),
+						context_ref);
+				}
+				else
+					add(x, f);
+			}
+			else if (result_features.count(f) > 0)
+			{
+				jam::errors::error(lists()
+						| message("explicitly-specified values of non-free "
+								  "feature "
+							+ std::string(f->str()) + " conflict")
+						| *(list_ref(value_ref("existing values:"))
+								  .append(get_values(f, properties)))
+						| *(list_ref() + "value from expanding " + p->str()
+							+ ":" + value_of(x->str())),
+					context_ref);
+			}
+			else
+				add(x, f);
+		}
+	}
+	return result;
+}
+
+list_ref expand(list_cref properties, bind::context_ref_ context_ref)
+{
+	list_ref expanded = expand_subfeatures(properties, false, context_ref);
+	list_ref expanded2 = expand_composites(expanded.cref(), context_ref);
+	while (!(expanded2 == expanded))
+	{
+		// check for composites expanding to subfeatures
+		expanded = expand_subfeatures(expanded2.cref(), false, context_ref);
+		expanded2 = expand_composites(expanded.cref(), context_ref);
+	}
+	return expanded2;
+}
+
+list_ref add_defaults(list_cref properties, bind::context_ref_ context_ref)
+{
+	check_explicit(properties,
+		"add-defaults requires explicitly specified features, but ",
+		context_ref);
+
+	value_set features;
+	for (auto p : properties) features.insert(value_ref(grist_of(p->str())));
+
+	list_ref more;
+	for (auto f : current().top_features)
+	{
+		if (features.count(value_ref(f)) > 0) continue;
+		value_ref d = default_of(value_ref(f));
+		if (d.has_value()) more.push_back(value_ptr(d));
+	}
+
+	// This is similar to property.refine, except that it does not remove
+	// subfeatures, because we might be adding the default value of a
+	// subfeature.
+	value_set to_remove;
+	for (auto & f : features)
+		if (!is_variable_feature(f)) to_remove.insert(f);
+
+	value_set in_more { more.begin(), more.end() };
+	list_ref worklist(properties);
+	worklist.append(more);
+	value_set expanded_from_composite;
+	list_ref to_expand(more);
+	while (!worklist.empty())
+	{
+		// Add defaults for subfeatures of features which are present.
+		for (auto p : worklist)
+		{
+			value_ref g(grist_of(p->str()));
+			feature_def * def = find(g);
+			if (!def) continue;
+			const std::string f = ungrist(g->str());
+			for (auto s : def->subfeatures)
+			{
+				value_ref sub("<" + f + "-" + s->str() + ">");
+				if (features.count(sub) > 0
+					|| !is_subfeature_of(p->str(), sub))
+					continue;
+				value_ref d = default_of(sub);
+				if (d.has_value()) to_expand.push_back(value_ptr(d));
+			}
+		}
+		worklist.reset();
+
+		// Expand subfeatures of newly added properties
+		value_set in_to_expand { to_expand.begin(), to_expand.end() };
+		list_ref expanded;
+		for (auto t : to_expand) expand_composite(value_ref(t), expanded);
+		for (auto m : expanded)
+		{
+			value_ref g(grist_of(m->str()));
+			if (to_remove.count(g) > 0) continue;
+			bool const is_variable = is_variable_feature(g);
+			if (expanded_from_composite.count(g) > 0 && !is_variable
+				&& in_more.count(value_ref(m)) == 0)
+			{
+				jam::errors::error(lists()
+						| message("default values for " + std::string(g->str())
+								+ " conflict"),
+					context_ref);
+			}
+			if (in_to_expand.count(value_ref(m)) == 0)
+				expanded_from_composite.insert(g);
+			more.push_back(m);
+			in_more.insert(value_ref(m));
+			if (!(bits_of(g) & attribute_subfeature) && !is_variable)
+				worklist.push_back(m);
+		}
+		to_expand.reset();
+	}
+
+	std::vector<value_ptr> result;
+	for (auto p : properties) result.push_back(p);
+	for (auto p : more) result.push_back(p);
+	std::sort(result.begin(), result.end(), less);
+	result.erase(std::unique(result.begin(), result.end(),
+					 [](value_ptr a, value_ptr b) { return !less(a, b); }),
+		result.end());
+	list_ref unique;
+	for (auto p : result) unique.push_back(p);
+	return unique;
+}
+
+list_ref minimize(list_cref properties, bind::context_ref_ context_ref)
+{
+	check_explicit(properties,
+		"minimize requires an expanded property set, but ", context_ref);
+
+	// Remove properties implied by composite features.
+	auto & composites = current().components;
+	value_set components, component_features;
+	for (auto p : properties)
+	{
+		auto i = composites.find(value_ref(p));
+		if (i == composites.end()) continue;
+		for (auto c : i->second)
+		{
+			components.insert(value_ref(c));
+			component_features.insert(value_ref(grist_of(c->str())));
+		}
+	}
+
+	// Handle subfeatures and implicit features, with the subfeatures moved to
+	// the end.
+	std::vector<value_ptr> x, x_subfeatures;
+	for (auto p : properties)
+	{
+		if (components.count(value_ref(p)) > 0) continue;
+		if (bits_of(value_ref(grist_of(p->str()))) & attribute_subfeature)
+			x_subfeatures.push_back(p);
+		else
+			x.push_back(p);
+	}
+	x.insert(x.end(), x_subfeatures.begin(), x_subfeatures.end());
+
+	list_ref result;
+	while (!x.empty())
+	{
+		value_ptr fullp = x.front();
+		value_ref f(grist_of(fullp->str()));
+		unsigned const a = bits_of(f);
+
+		// Eliminate features in implicit properties.
+		std::string p = (a & attribute_implicit) ? value_of(fullp->str())
+												 : fullp->str();
+
+		// Locate all subproperties of x[1] in the property set.
+		list_ref subproperties = sorted_subproperties(fullp->str(), x);
+		if (!subproperties.empty())
+		{
+			// Reconstitute the joined property name.
+			result.push_back(p + "-" + joined_values(subproperties));
+			value_set subs { subproperties.begin(), subproperties.end() };
+			std::vector<value_ptr> rest;
+			for (std::size_t i = 1; i < x.size(); ++i)
+				if (subs.count(value_ref(x[i])) == 0) rest.push_back(x[i]);
+			x.swap(rest);
+		}
+		else
+		{
+			// Eliminate properties whose value is equal to feature's default,
+			// which are not symmetric and which do not contradict values
+			// implied by composite properties.
+
+			// Since all component properties of composites in the set have
+			// been eliminated, any remaining property whose feature is the
+			// same as a component of a composite in the set must have a
+			// non-redundant value.
+			value_ref d = default_of(f);
+			if (!d.has_value() || d != fullp || (a & attribute_symmetric)
+				|| component_features.count(f) > 0)
+				result.push_back(p);
+			x.erase(x.begin());
+		}
+	}
+	return result;
+}
+
+list_ref expand_relevant(list_cref features)
+{
+	auto & dependencies = current().dependencies;
+	value_map<list_ref> local_dependencies;
+	list_ref result;
+	for (auto f : features)
+	{
+		// This looks like a conditional, even though it isn't really.
+		// (Free features can never be used in conditionals)
+		std::string s = f->str();
+		auto split = s.rfind(":<relevant>");
+		if (split != std::string::npos)
+			local_dependencies[value_ref(s.substr(0, split))].push_back(
+				s.substr(split + 11));
+		else
+			result.push_back(f);
+	}
+	value_set in_result { result.begin(), result.end() };
+	list_ref queue(result);
+	while (!queue.empty())
+	{
+		list_ref added;
+		for (auto m : { &dependencies, &local_dependencies })
+		{
+			for (auto q : queue)
+			{
+				auto i = m->find(value_ref(q));
+				if (i == m->end()) continue;
+				for (auto d : i->second)
+					if (in_result.count(value_ref(d)) == 0) added.push_back(d);
+			}
+		}
+		result.append(added);
+		in_result.insert(added.begin(), added.end());
+		queue = std::move(added);
+	}
+	return result;
+}
+
+unsigned attribute_bits(value_ref feature) { return bits_of(feature); }
+
+void extend_feature(
+	value_ref feature, list_cref values, bind::context_ref_ context_ref)
+{
+	feature = grist(feature);
+	validate_feature(feature, context_ref);
+	feature_def * def = find(feature);
+	if (!def) return;
+	if (def->attributes & attribute_implicit)
+	{
+		auto & implicit_features = current().implicit_features;
+		for (auto v : values)
+		{
+			value_ref & f = implicit_features[value_ref(v)];
+			if (f.has_value())
+				jam::errors::error(lists()
+						| message(std::string(v->str())
+							+ " is already associated with the \"" + f->str()
+							+ "\" feature"),
+					context_ref);
+			f = feature;
+		}
+	}
+	if (def->values.empty())
+	{
+		// This is the first value specified for this feature so make it be the
+		// default.
+		def->default_value
+			= values.empty() ? value_ref() : value_ref(values[0]);
+	}
+	def->values.append(values);
+	def->value_index.insert(values.begin(), values.end());
+}
+
+void extend_subfeature(std::tuple<value_ref, value_ref> feature_value_string,
+	value_ref subfeature,
+	list_cref subvalues,
+	bind::context_ref_ context_ref)
+{
+	value_ref feature = grist(std::get<0>(feature_value_string));
+	value_ref value_string = std::get<1>(feature_value_string);
+	validate_feature(feature, context_ref);
+	const std::string vs = value_string.has_value() ? value_string->str() : "";
+	if (!vs.empty())
+		validate_value_string(
+			std::make_tuple(feature, value_string), context_ref);
+
+	const std::string subfeature_name
+		= vs.empty() ? subfeature->str() : vs + ":" + subfeature->str();
+	extend_feature(value_ref(ungrist(feature->str()) + "-" + subfeature_name),
+		subvalues, context_ref);
+
+	// Provide a way to get from the given feature or property and subfeature
+	// value to the subfeature name.
+	auto & subfeatures = current().subvalue_subfeatures;
+	for (auto v : subvalues)
+		subfeatures[value_ref(feature->str() + vs + "<>" + v->str())]
+			= value_ref(subfeature_name);
+}
+
+void add_subfeature(value_ref feature, value_ref subfeature_name)
+{
+	feature = grist(feature);
+	feature_def * def = find(feature);
+	if (def) def->subfeatures.push_back(value_ptr(subfeature_name));
+
+	// Features and subfeatures are always relevant as a group
+	auto & dependencies = current().dependencies;
+	const std::string f = ungrist(feature->str());
+	const std::string sub = f + "-" + subfeature_name->str();
+	dependencies[value_ref(f)].push_back(sub);
+	dependencies[value_ref(sub)].push_back(f);
+}
+
+void set_default(
+	value_ref feature, value_ref value, bind::context_ref_ context_ref)
+{
+	value_ref f = grist(feature);
+	feature_def * def = find(f);
+	unsigned const a = def ? def->attributes : 0;
+	const char * bad_attribute = (a & attribute_free) ? "free"
+		: (a & attribute_optional)                    ? "optional"
+		: (a & attribute_version)                     ? "version"
+													  : nullptr;
+	if (bad_attribute)
+	{
+		jam::errors::error(lists()
+				| message(std::string(bad_attribute) + " property "
+					+ f->str() + " cannot have a default."),
+			context_ref);
+		return;
+	}
+	if (!def || def->value_index.count(value) == 0)
+	{
+		jam::errors::error(lists()
+				| message("The specified default value, '"
+					+ std::string(value->str()) + "' is invalid")
+				| *(list_ref() + "allowed values are:").append(values(f)),
+			context_ref);
+		return;
+	}
+	def->default_value = value;
+}
+
+void compose(value_ref composite_property,
+	list_cref component_properties,
+	bind::context_ref_ context_ref)
+{
+	const std::string feature = grist_of(composite_property->str());
+	if (!(bits_of(value_ref(feature)) & attribute_composite))
+	{
+		jam::errors::error(lists()
+				| message(feature + " is not a composite feature"),
+			context_ref);
+		return;
+	}
+	auto & components = current().components[composite_property];
+	if (!components.empty())
+	{
+		jam::errors::error(lists()
+				| *(list_ref() + ("components of "
+									   + std::string(composite_property->str())
+									   + " already set:"))
+					   .append(components),
+			context_ref);
+		return;
+	}
+	for (auto c : component_properties)
+	{
+		if (composite_property == c)
+		{
+			jam::errors::error(lists()
+					| message("composite property "
+						+ std::string(composite_property->str())
+						+ " cannot have itself as a component"),
+				context_ref);
+			return;
+		}
+	}
+	components = component_properties;
+
+	// A composite feature is relevant if any composed feature is relevant
+	auto & dependencies = current().dependencies;
+	for (auto c : component_properties)
+	{
+		const std::string g = grist_of(c->str());
+		if (!g.empty())
+			dependencies[value_ref(ungrist(g))].push_back(ungrist(feature));
+	}
+}
+
+bool is_implicit_value(value_ref value_string)
+{
+	auto v = split_string(value_string->str(), '-');
+	auto & implicit_features = current().implicit_features;
+	auto i = implicit_features.find(value_ref(v[0]));
+	if (i == implicit_features.end()) return false;
+	const std::string feature = i->second->str();
+	for (std::size_t s = 1; s < v.size(); ++s)
+		if (!find_implied_subfeature(feature, v[0].c_str(), v[s].c_str())
+				 .has_value())
+			return false;
+	return true;
+}
+
+value_ref implied_feature(
+	value_ref implicit_value, bind::context_ref_ context_ref)
+{
+	const char * s = implicit_value->str();
+	const char * dash = std::strchr(s, '-');
+	auto & implicit_features = current().implicit_features;
+	auto i = implicit_features.find(
+		dash ? value_ref(std::string(s, dash)) : implicit_value);
+	if (i == implicit_features.end())
+	{
+		jam::errors::error(lists()
+				| message("\"" + std::string(s)
+					+ "\" is not an implicit feature value"),
+			context_ref);
+		return value_ref(""); // Keep testing happy; it expects a result.
+	}
+	return i->second;
+}
+
+value_ref implied_subfeature(std::tuple<value_ref, value_ref> feature_subvalue,
+	value_ref value_string,
+	bind::context_ref_ context_ref)
+{
+	const std::string feature = std::get<0>(feature_subvalue)->str();
+	const char * subvalue = std::get<1>(feature_subvalue)->str();
+	const char * vs = value_string.has_value() ? value_string->str() : "";
+	// Feature should be of the form <feature-name>.
+	if (grist_of(feature.c_str()) != feature)
+	{
+		jam::errors::error(lists()
+				| *(list_ref() + "invalid" + "feature" + feature.c_str()),
+			context_ref);
+	}
+	value_ref subfeature = find_implied_subfeature(feature, vs, subvalue);
+	if (!subfeature.has_value())
+	{
+		jam::errors::error(lists()
+				| message("\"" + std::string(subvalue)
+					+ "\" is not a known subfeature value of " + feature + vs),
+			context_ref);
+	}
+	return subfeature;
+}
+
+bool is_subvalue(value_ref feature,
+	value_ref value_string,
+	value_ref subfeature,
+	value_ref subvalue,
+	bind::context_ref_ context_ref)
+{
+	feature = grist(feature);
+	validate_feature(feature, context_ref);
+	const std::string vs = value_string.has_value() ? value_string->str() : "";
+	if (!vs.empty())
+		validate_value_string(
+			std::make_tuple(feature, value_string), context_ref);
+	const std::string subfeature_name
+		= vs.empty() ? subfeature->str() : vs + ":" + subfeature->str();
+	auto & subfeatures = current().subvalue_subfeatures;
+	auto i = subfeatures.find(
+		value_ref(feature->str() + vs + "<>" + subvalue->str()));
+	return i != subfeatures.end() && subfeature_name == i->second->str();
+}
+
+void validate_feature(value_ref feature, bind::context_ref_ context_ref)
+{
+	if (!find(feature))
+		jam::errors::error(lists()
+				| message("unknown feature \""
+					+ std::string(feature->str()) + "\""),
+			context_ref);
+}
+
+void validate_value_string(std::tuple<value_ref, value_ref> feature_value,
+	bind::context_ref_ context_ref)
+{
+	value_ref feature = std::get<0>(feature_value);
+	value_ref value_string = std::get<1>(feature_value);
+	feature_def * def = find(feature);
+	unsigned const a = def ? def->attributes : 0;
+	if (a & attribute_version)
+	{
+		// Check that the value is a valid semver.
+		if (!semver_verify(value_string))
+			jam::errors::error(lists()
+					| message("\"" + std::string(value_string->str())
+						+ "\" is not a valid semantic version for feature \""
+						+ feature->str() + "\""),
+				context_ref);
+		return;
+	}
+	if ((a & attribute_free) || (def && def->value_index.count(value_string)))
+		return;
+
+	auto parts = (def && !def->subfeatures.empty())
+		? split_string(value_string->str(), '-')
+		: std::vector<std::string> { value_string->str() };
+	if ((!def || def->value_index.count(value_ref(parts[0])) == 0)
+		// An empty value is allowed for optional features.
+		&& (!parts[0].empty() || !(a & attribute_optional)))
+	{
+		list_ref legal = list_ref() + "legal" + "values:";
+		if (def)
+			for (auto v : def->values)
+				legal.push_back("\"" + std::string(v->str()) + "\"");
+		jam::errors::error(lists()
+				| message("\"" + parts[0]
+					+ "\" is not a known value of feature " + feature->str())
+				| *legal,
+			context_ref);
+	}
+
+	// This will validate any subfeature values in value-string.
+	for (std::size_t i = 1; i < parts.size(); ++i)
+		implied_subfeature(std::make_tuple(feature, value_ref(parts[i])),
+			value_ref(parts[0]), context_ref);
+}
+
+list_ref select_subfeatures(value_ref parent_property, list_cref features)
+{
+	list_ref result;
+	for (auto f : features)
+		if (is_subfeature_of(parent_property->str(), value_ref(f)))
+			result.push_back(f);
+	return result;
+}
+
+list_ref compress_subproperties(
+	list_cref properties, bind::context_ref_ context_ref)
+{
+	std::vector<value_ptr> all { properties.begin(), properties.end() };
+	list_ref result;
+	for (auto p : properties)
+	{
+		const std::string g = grist_of(p->str());
+		if (g.empty())
+		{
+			// Expecting fully-gristed properties.
+			jam::errors::error(lists()
+					| message("assertion failure: Expected variable "
+							  "\"p:G\" not to be an empty list"),
+				context_ref);
+		}
+		if (bits_of(value_ref(g)) & attribute_subfeature) continue;
+		list_ref subs = sorted_subproperties(p->str(), all);
+		result.push_back(
+			subs.empty() ? std::string(p->str())
+						 : std::string(p->str()) + "-" + joined_values(subs));
+	}
+	return result;
+}
+
+void prepare_test(value_ref temp_module)
+{
+	saved()[temp_module->str()] = std::move(current());
+	current() = registry();
+}
+
+void finish_test(value_ref temp_module)
+{
+	auto i = saved().find(temp_module->str());
+	current() = i == saved().end() ? registry() : std::move(i->second);
+	if (i != saved().end()) saved().erase(i);
+}
+
+}} // namespace b2::feature
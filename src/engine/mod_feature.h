@@ -0,0 +1,408 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_FEATURE_H
+#define B2_MOD_FEATURE_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "lists.h"
+#include "value.h"
+
+#include <tuple>
+
+/* tag::reference[]
+
+[[b2.reference.modules.feature]]
+= `feature` module.
+
+The registry of the declared features. For each feature it keeps the
+attributes, as bits, the values, the default, and the subfeatures. And it
+indexes the implicit values to their features, the subfeature values to their
+subfeatures, and the composite properties to their components. The `feature`
+build system module declares the features with these, and the expansion rules
+of it, that run for every build request and target, are implemented here.
+
+end::reference[] */
+
+namespace b2 { namespace feature {
+
+/* tag::reference[]
+
+== `b2::feature::declare`
+
+====
+[horizontal]
+Jam:: `rule declare ( name : attributes * )`
+{CPP}:: `void declare(value_ref name, list_cref attributes);`
+====
+
+Adds the feature, with the `<name>` grist, and its attributes to the registry.
+The `feature.feature` rule checks the declaration before adding it.
+
+end::reference[] */
+void declare(value_ref name, list_cref attributes);
+
+/* tag::reference[]
+
+== `b2::feature::attributes`
+
+====
+[horizontal]
+Jam:: `rule attributes ( feature )`
+{CPP}:: `list_ref attributes(value_ref feature);`
+====
+
+Returns the attributes of the given feature.
+
+end::reference[] */
+list_ref attributes(value_ref feature);
+
+/* tag::reference[]
+
+== `b2::feature::values`
+
+====
+[horizontal]
+Jam:: `rule values ( feature )`
+{CPP}:: `list_ref values(value_ref feature);`
+====
+
+Returns the values of the given feature.
+
+end::reference[] */
+list_ref values(value_ref feature);
+
+/* tag::reference[]
+
+== `b2::feature::subfeatures`
+
+====
+[horizontal]
+Jam:: `rule subfeatures ( feature )`
+{CPP}:: `list_ref subfeatures(value_ref feature);`
+====
+
+Returns the names of the subfeatures of the given feature. The names of the
+subfeatures specific to a value are of the form `value:subfeature`.
+
+end::reference[] */
+list_ref subfeatures(value_ref feature);
+
+/* tag::reference[]
+
+== `b2::feature::valid`
+
+====
+[horizontal]
+Jam:: `rule valid ( names + )`
+{CPP}:: `bool valid(list_cref names);`
+====
+
+Returns true iff all `names` elements are valid features.
+
+end::reference[] */
+bool valid(list_cref names);
+
+/* tag::reference[]
+
+== `b2::feature::defaults`
+
+====
+[horizontal]
+Jam:: `rule defaults ( features * )`
+{CPP}:: `list_ref defaults(list_cref features);`
+====
+
+Returns the default property values for the given features.
+
+end::reference[] */
+list_ref defaults(list_cref features);
+
+/* tag::reference[]
+
+== `b2::feature::free_features`
+
+====
+[horizontal]
+Jam:: `rule free-features ( )`
+{CPP}:: `list_ref free_features();`
+====
+
+Returns the free features.
+
+end::reference[] */
+list_ref free_features();
+
+/* tag::reference[]
+
+== `b2::feature::get_values`
+
+====
+[horizontal]
+Jam:: `rule get-values ( feature : properties * )`
+{CPP}:: `list_ref get_values(value_ref feature, list_cref properties);`
+====
+
+Return all values of the given feature specified by the given property set.
+
+end::reference[] */
+list_ref get_values(value_ref feature, list_cref properties);
+
+/* tag::reference[]
+
+== `b2::feature::split`
+
+====
+[horizontal]
+Jam:: `rule split ( property-set )`
+{CPP}:: `list_ref split(value_ref property_set);`
+====
+
+Given a property-set of the form
+`v1/v2/...vN-1/<fN>vN/<fN+1>vN+1/...<fM>vM`, returns
+`v1 v2 ... vN-1 <fN>vN <fN+1>vN+1 ... <fM>vM`. Note that vN...vM may contain
+slashes, or backslashes.
+
+end::reference[] */
+list_ref split(value_ref property_set);
+
+/* tag::reference[]
+
+== `b2::feature::expand_subfeatures`
+
+====
+[horizontal]
+Jam:: `rule expand-subfeatures ( properties * : dont-validate ? )`
+{CPP}:: `list_ref expand_subfeatures(list_cref properties, bool dont_validate,
+bind::context_ref_ context_ref);`
+====
+
+Make all elements of properties corresponding to implicit features explicit,
+and express all subfeature values as separate properties in their own right.
+For example, `gcc-2.95.2-linux` or `<toolset>gcc-2.95.2-linux` might expand to
+`<toolset>gcc <toolset-gcc:version>2.95.2 <toolset-gcc:os>linux`.
+
+end::reference[] */
+list_ref expand_subfeatures(list_cref properties,
+	bool dont_validate,
+	bind::context_ref_ context_ref);
+
+/* tag::reference[]
+
+== `b2::feature::expand_composites`
+
+====
+[horizontal]
+Jam:: `rule expand-composites ( properties * )`
+{CPP}:: `list_ref expand_composites(list_cref properties,
+bind::context_ref_ context_ref);`
+====
+
+Expand all composite properties in the set so that all components are
+explicitly expressed.
+
+end::reference[] */
+list_ref expand_composites(
+	list_cref properties, bind::context_ref_ context_ref);
+
+/* tag::reference[]
+
+== `b2::feature::expand`
+
+====
+[horizontal]
+Jam:: `rule expand ( properties * )`
+{CPP}:: `list_ref expand(list_cref properties, bind::context_ref_
+context_ref);`
+====
+
+Given a property set which may consist of composite and implicit properties
+and combined subfeature values, returns an expanded, normalized property set
+with all implicit features expressed explicitly, all subfeature values
+individually expressed, and all components of composite properties expanded.
+
+end::reference[] */
+list_ref expand(list_cref properties, bind::context_ref_ context_ref);
+
+/* tag::reference[]
+
+== `b2::feature::add_defaults`
+
+====
+[horizontal]
+Jam:: `rule add-defaults ( properties * )`
+{CPP}:: `list_ref add_defaults(list_cref properties, bind::context_ref_
+context_ref);`
+====
+
+Given a set of fully expanded properties, add default values for features not
+represented in the set.
+
+end::reference[] */
+list_ref add_defaults(list_cref properties, bind::context_ref_ context_ref);
+
+/* tag::reference[]
+
+== `b2::feature::minimize`
+
+====
+[horizontal]
+Jam:: `rule minimize ( properties * )`
+{CPP}:: `list_ref minimize(list_cref properties, bind::context_ref_
+context_ref);`
+====
+
+Given an expanded property set, eliminate all redundancy: properties that are
+elements of other (composite) properties in the set will be eliminated.
+Non-symmetric properties equal to default values will be eliminated unless
+they override a value from some composite property. Implicit properties will
+be expressed without feature grist, and sub-property values will be expressed
+as elements joined to the corresponding main property.
+
+end::reference[] */
+list_ref minimize(list_cref properties, bind::context_ref_ context_ref);
+
+/* tag::reference[]
+
+== `b2::feature::expand_relevant`
+
+====
+[horizontal]
+Jam:: `rule expand-relevant ( features * )`
+{CPP}:: `list_ref expand_relevant(list_cref features);`
+====
+
+Returns all the features that also must be relevant when these features are
+relevant.
+
+end::reference[] */
+list_ref expand_relevant(list_cref features);
+
+// Internal..
+
+// The feature attributes, as bits.
+enum : unsigned
+{
+	attribute_implicit = 1u << 0,
+	attribute_composite = 1u << 1,
+	attribute_optional = 1u << 2,
+	attribute_symmetric = 1u << 3,
+	attribute_free = 1u << 4,
+	attribute_incidental = 1u << 5,
+	attribute_path = 1u << 6,
+	attribute_dependency = 1u << 7,
+	attribute_propagated = 1u << 8,
+	attribute_link_incompatible = 1u << 9,
+	attribute_subfeature = 1u << 10,
+	attribute_order_sensitive = 1u << 11,
+	attribute_hidden = 1u << 12,
+	attribute_version = 1u << 13
+};
+
+// The attribute bits of the feature, zero for unknown features.
+unsigned attribute_bits(value_ref feature);
+
+// Parts of feature.jam rules that change the registry.
+void extend_feature(
+	value_ref feature, list_cref values, bind::context_ref_ context_ref);
+void extend_subfeature(std::tuple<value_ref, value_ref> feature_value_string,
+	value_ref subfeature,
+	list_cref subvalues,
+	bind::context_ref_ context_ref);
+void add_subfeature(value_ref feature, value_ref subfeature_name);
+void set_default(
+	value_ref feature, value_ref value, bind::context_ref_ context_ref);
+void compose(value_ref composite_property,
+	list_cref component_properties,
+	bind::context_ref_ context_ref);
+
+// Queries and checks of feature.jam rules.
+bool is_implicit_value(value_ref value_string);
+value_ref implied_feature(
+	value_ref implicit_value, bind::context_ref_ context_ref);
+value_ref implied_subfeature(std::tuple<value_ref, value_ref> feature_subvalue,
+	value_ref value_string,
+	bind::context_ref_ context_ref);
+bool is_subvalue(value_ref feature,
+	value_ref value_string,
+	value_ref subfeature,
+	value_ref subvalue,
+	bind::context_ref_ context_ref);
+void validate_feature(value_ref feature, bind::context_ref_ context_ref);
+void validate_value_string(std::tuple<value_ref, value_ref> feature_value,
+	bind::context_ref_ context_ref);
+list_ref select_subfeatures(value_ref parent_property, list_cref features);
+list_ref compress_subproperties(
+	list_cref properties, bind::context_ref_ context_ref);
+
+// Move the registry aside, to test with a fresh one, and back.
+void prepare_test(value_ref temp_module);
+void finish_test(value_ref temp_module);
+
+}} // namespace b2::feature
+
+namespace b2 {
+
+struct feature_module : b2::bind::module_<feature_module>
+{
+	const char * module_name = "feature";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		using namespace b2::feature;
+		binder.def(&declare, "declare", "name" * _1 | "attributes" * _n)
+			.def(&attributes, "attributes", "feature" * _1)
+			.def(&values, "values", "feature" * _1)
+			.def(&subfeatures, "subfeatures", "feature" * _1)
+			.def(&valid, "valid", "names" * _1n)
+			.def(&defaults, "defaults", "features" * _n)
+			.def(&free_features, "free-features")
+			.def(&get_values, "get-values",
+				"feature" * _1 | "properties" * _n)
+			.def(&split, "split", "property-set" * _1)
+			.def(&expand_subfeatures, "expand-subfeatures",
+				"properties" * _n | "dont-validate" * _01)
+			.def(&expand_composites, "expand-composites", "properties" * _n)
+			.def(&expand, "expand", "properties" * _n)
+			.def(&add_defaults, "add-defaults", "properties" * _n)
+			.def(&minimize, "minimize", "properties" * _n)
+			.def(&expand_relevant, "expand-relevant", "features" * _n)
+			.def(&extend_feature, "extend-feature",
+				"feature" * _1 | "values" * _n)
+			.def(&extend_subfeature, "extend-subfeature",
+				("feature" * _1 + "value-string" * _01) | "subfeature" * _1
+					| "subvalues" * _n)
+			.def(&add_subfeature, "add-subfeature",
+				"feature" * _1 | "subfeature" * _1)
+			.def(&set_default, "set-default", "feature" * _1 | "value" * _1)
+			.def(&compose, "compose",
+				"composite-property" * _1 | "component-properties" * _n)
+			.def(&is_implicit_value, "is-implicit-value",
+				"value-string" * _1)
+			.def(&implied_feature, "implied-feature", "implicit-value" * _1)
+			.def(&implied_subfeature, "implied-subfeature",
+				("feature" * _1 + "subvalue" * _1) | "value-string" * _01)
+			.def(&is_subvalue, "is-subvalue",
+				"feature" * _1 | "value-string" * _01 | "subfeature" * _1
+					| "subvalue" * _1)
+			.def(&validate_feature, "validate-feature", "feature" * _1)
+			.def(&validate_value_string, "validate-value-string",
+				"feature" * _1 + "value-string" * _1)
+			.def(&select_subfeatures, "select-subfeatures",
+				"parent-property" * _1 | "features" * _n)
+			.def(&compress_subproperties, "compress-subproperties",
+				"properties" * _n)
+			.def(&prepare_test, "prepare-test", "temp-module" * _1)
+			.def(&finish_test, "finish-test", "temp-module" * _1);
+	}
+};
+
+} // namespace b2
+
+#endif
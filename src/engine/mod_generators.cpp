@@ -0,0 +1,256 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "mod_generators.h"
+
+#include "bindjam.h"
+#include "compile.h"
+#include "frames.h"
+#include "modules.h"
+#include "variable.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace b2 { namespace generators {
+
+namespace {
+
+template <class T>
+using value_map = std::unordered_map<value_ref,
+	T,
+	value_ref::hash_function,
+	value_ref::equal_function>;
+
+using bits = std::vector<std::uint64_t>;
+
+void set_bit(bits & b, std::size_t i)
+{
+	if (b.size() <= i / 64) b.resize(i / 64 + 1, 0);
+	b[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+// Are all the bits in `a` also in `b`.
+bool is_subset(const bits & a, const bits & b)
+{
+	for (std::size_t i = 0; i < a.size(); ++i)
+	{
+		std::uint64_t in_b = i < b.size() ? b[i] : 0;
+		if ((a[i] & ~in_b) != 0) return false;
+	}
+	return true;
+}
+
+struct generator_info
+{
+	value_ref id;
+	// The generator requirements, as bits of the requirement index.
+	bits requirements;
+	// The generators module variable with the ids the generator overrides.
+	value_ref override_variable;
+};
+
+// The bits for a property set, for the first `known` requirements.
+struct property_set_info
+{
+	std::size_t known = 0;
+	bits satisfied;
+};
+
+struct index
+{
+	value_map<generator_info> generators;
+	// The generators for each target type, in registration order.
+	value_map<list_ref> by_target_type;
+	// The bit for each distinct required property, or feature.
+	value_map<std::size_t> requirements;
+	value_map<property_set_info> property_sets;
+	// The viable generators, by target type and property set.
+	value_map<value_map<list_ref>> viable;
+};
+
+index & current()
+{
+	static index i;
+	return i;
+}
+
+module_ptr generators_module()
+{
+	static module_ptr m = bindmodule(value_ref("generators"));
+	return m;
+}
+
+bool debugging()
+{
+	return !list_cref(var_get(generators_module(), value_ref(".debug")))
+				.empty();
+}
+
+// The grist, i.e. the "<feature>", of the property, or empty if none.
+value_ref feature_of(value_ref p)
+{
+	const char * s = p->str();
+	const char * e = s[0] == '<' ? std::strchr(s, '>') : nullptr;
+	return e ? value_ref(std::string(s, e + 1)) : value_ref();
+}
+
+// The requirement bits the property set satisfies. A property requirement
+// needs to be in the property set, and a feature requirement needs some value
+// of the feature in it.
+const bits & satisfied_requirements(value_ref property_set)
+{
+	index & x = current();
+	property_set_info & ps = x.property_sets[property_set];
+	if (ps.known == x.requirements.size()) return ps.satisfied;
+	ps.known = x.requirements.size();
+	ps.satisfied.clear();
+	list_cref raw = *jam::variable(property_set->str(), "self.raw");
+	for (auto p : raw)
+	{
+		auto r = x.requirements.find(value_ref(p));
+		if (r != x.requirements.end()) set_bit(ps.satisfied, r->second);
+		value_ref f = feature_of(value_ref(p));
+		if (!f.has_value()) continue;
+		r = x.requirements.find(f);
+		if (r != x.requirements.end()) set_bit(ps.satisfied, r->second);
+	}
+	return ps.satisfied;
+}
+
+value_ref generator_id(value_ref generator, frame * outer)
+{
+	auto & generators = current().generators;
+	auto g = generators.find(generator);
+	if (g != generators.end()) return g->second.id;
+	list_ref id(call_member_rule(value_ref("id"), outer, list_ref(generator),
+					lists()),
+		true);
+	return value_ref(list_front(*id));
+}
+
+list_ref generator_overrides(value_ref generator, value_ref id)
+{
+	auto & generators = current().generators;
+	auto g = generators.find(generator);
+	value_ref var = g != generators.end()
+		? g->second.override_variable
+		: value_ref(".override." + std::string(id->str()));
+	return list_ref(var_get(generators_module(), var));
+}
+
+} // namespace
+
+void index_generator(value_ref generator,
+	value_ref id,
+	list_cref target_types,
+	list_cref requirements)
+{
+	index & x = current();
+	generator_info & g = x.generators[generator];
+	g.id = id;
+	g.override_variable = value_ref(".override." + std::string(id->str()));
+	g.requirements.clear();
+	for (auto r : requirements)
+	{
+		auto i = x.requirements.emplace(value_ref(r), x.requirements.size());
+		set_bit(g.requirements, i.first->second);
+	}
+	for (auto t : target_types)
+		x.by_target_type[value_ref(t)].push_back(value_ptr(generator));
+}
+
+list_ref find_viable_generators(value_ref target_type,
+	value_ref property_set,
+	bind::context_ref_ context_ref)
+{
+	frame * outer = context_ref.get<jam::jam_context>().frame;
+	index & x = current();
+
+	auto & by_property_set = x.viable[target_type];
+	auto v = by_property_set.find(property_set);
+	if (v == by_property_set.end())
+	{
+		list_ref viable;
+		auto candidates = x.by_target_type.find(target_type);
+		if (candidates == x.by_target_type.end() || debugging())
+		{
+			// Trying the base types, and cloning their generators, or showing
+			// the search, is left to the Jam rule.
+			jam::module_scope scope(outer, "generators");
+			viable = jam::run_rule(outer, "find-viable-generators-aux",
+				list_ref(target_type), list_ref(property_set));
+		}
+		else
+		{
+			const bits & satisfied = satisfied_requirements(property_set);
+			for (auto g : candidates->second)
+			{
+				auto i = x.generators.find(value_ref(g));
+				if (is_subset(i->second.requirements, satisfied))
+					viable.push_back(g);
+			}
+		}
+		v = by_property_set.emplace(property_set, viable).first;
+	}
+
+	// Avoid trying the same generator twice on different levels.
+	list_cref active = list_cref(
+		var_get(generators_module(), value_ref(".active-generators")));
+	list_ref viable;
+	std::vector<value_ref> ids;
+	for (auto g : v->second)
+	{
+		value_ref id = generator_id(value_ref(g), outer);
+		if (active.contains(value_ref(g)))
+		{
+			if (debugging())
+			{
+				jam::module_scope scope(outer, "generators");
+				jam::run_rule(outer, "generators.dout",
+					jam::run_rule(outer, "indent"),
+					list_ref(list_ref() + "   generator " + id->str()
+						+ "is active, discaring"));
+			}
+			continue;
+		}
+		viable.push_back(g);
+		ids.push_back(id);
+	}
+
+	// Generators which override 'all', and the ids of the overridden ones.
+	list_ref all_overrides;
+	std::vector<value_ref> all_overrides_ids;
+	list_ref overridden_ids;
+	std::size_t n = 0;
+	for (auto g : viable)
+	{
+		list_ref overrides = generator_overrides(value_ref(g), ids[n]);
+		if (overrides.contains(value_ref("all")))
+		{
+			all_overrides.push_back(g);
+			all_overrides_ids.push_back(ids[n]);
+		}
+		overridden_ids.append(overrides);
+		++n;
+	}
+	if (!all_overrides.empty())
+	{
+		viable = std::move(all_overrides);
+		ids = all_overrides_ids;
+	}
+	list_ref result;
+	n = 0;
+	for (auto g : viable)
+		if (!overridden_ids.contains(ids[n++])) result.push_back(g);
+	return result;
+}
+
+}} // namespace b2::generators
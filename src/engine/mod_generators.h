@@ -0,0 +1,98 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_GENERATORS_H
+#define B2_MOD_GENERATORS_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "lists.h"
+#include "value.h"
+
+/* tag::reference[]
+
+[[b2.reference.modules.generators]]
+= `generators` module.
+
+The index of the registered generators used to select the viable generators
+for a target type and property set. The generators are indexed by the target
+types they produce, and their requirements are kept as bits, one for each
+distinct required property or feature. The viable generators for each target
+type and property set are selected once and kept.
+
+end::reference[] */
+
+namespace b2 { namespace generators {
+
+/* tag::reference[]
+
+== `b2::generators::index_generator`
+
+====
+[horizontal]
+Jam:: `rule index-generator ( generator : id : target-types + : requirements *
+)`
+{CPP}:: `void index_generator(value_ref generator, value_ref id, list_cref
+target_types, list_cref requirements);`
+====
+
+Adds the registered `generator`, with the given `id`, to the index for each of
+its unique `target-types`. The `requirements` are the generator requirements,
+either properties, or features that must have some value.
+
+end::reference[] */
+void index_generator(value_ref generator,
+	value_ref id,
+	list_cref target_types,
+	list_cref requirements);
+
+/* tag::reference[]
+
+== `b2::generators::find_viable_generators`
+
+====
+[horizontal]
+Jam:: `rule find-viable-generators ( target-type : property-set )`
+{CPP}:: `list_ref find_viable_generators(value_ref target_type, value_ref
+property_set, bind::context_ref_ context_ref);`
+====
+
+Returns the generators that can produce `target-type` with the properties of
+`property-set`, excluding the currently active generators and the ones
+overridden by other viable generators. When no generator produces the target
+type itself, or when debugging the generators, the selection is done by the
+Jam `find-viable-generators-aux` rule.
+
+end::reference[] */
+list_ref find_viable_generators(value_ref target_type,
+	value_ref property_set,
+	bind::context_ref_ context_ref);
+
+}} // namespace b2::generators
+
+namespace b2 {
+
+struct generators_module : b2::bind::module_<generators_module>
+{
+	const char * module_name = "generators";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		using namespace b2::generators;
+		binder
+			.def(&index_generator, "index-generator",
+				"generator" * _1 | "id" * _1 | "target-types" * _1n
+					| "requirements" * _n)
+			.def(&find_viable_generators, "find-viable-generators",
+				"target-type" * _1 | "property-set" * _1);
+	}
+};
+
+} // namespace b2
+
+#endif
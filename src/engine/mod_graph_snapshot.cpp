@@ -0,0 +1,370 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "jam.h"
+#include "mod_graph_snapshot.h"
+
+#include "builtins.h"
+#include "cwd.h"
+#include "filesys.h"
+#include "frames.h"
+#include "md5.h"
+#include "pathsys.h"
+#include "startup.h"
+#include "timestamp.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace b2 { namespace graph_snapshot {
+
+namespace {
+
+const char * file_version = "b2-graph-snapshot-1";
+
+std::vector<std::string> split_fields(const std::string & line)
+{
+	std::vector<std::string> fields;
+	std::string::size_type b = 0;
+	for (;;)
+	{
+		std::string::size_type e = line.find('\t', b);
+		fields.push_back(b2::filesys::unescape_field(line.substr(b, e - b)));
+		if (e == std::string::npos) break;
+		b = e + 1;
+	}
+	return fields;
+}
+
+std::string absolute_path(const char * path)
+{
+	return b2::paths::normalize(b2::paths::is_rooted(path)
+			? std::string(path)
+			: b2::cwd_str() + "/" + path);
+}
+
+// The existence, kind, and modification time of the path.
+std::string file_state(const file_info_t * info)
+{
+	if (info == nullptr || !info->exists) return "-";
+	if (info->is_dir) return "d";
+	char state[64];
+	std::snprintf(state, sizeof(state), "%c%lld.%09d", info->is_file ? 'f' : 'o',
+		(long long)info->time.secs, info->time.nsecs);
+	return state;
+}
+
+void ignore_scan(void *, OBJECT *, int, timestamp const * const) {}
+
+// The digest of the lines returned by a SHELL call.
+std::string result_digest(LIST * result)
+{
+	md5_state_t state;
+	md5_init(&state);
+	for (auto item : b2::list_cref(result)) md5_add(state, item->str());
+	return md5_hex(state);
+}
+
+// A file with a version line, followed by the records of one build. Each
+// record is a line of tab separated fields, with the kind of record first:
+//
+// * "key", the digest of the engine binary, current directory, arguments, and
+//   environment.
+// * "file", a path, and its file state. The state is "-" for missing paths,
+//   "d" for directories, or the kind of file and its modification time. With
+//   a "*" instead of the time for the files the build wrote, where only the
+//   kind is checked.
+// * "dir", a path, and the digest of the paths in the directory.
+// * "shell", the digest of the result, the command, and the options of a SHELL
+//   call.
+// * "made", the counts of targets found by make.
+struct snapshot
+{
+	std::string filename;
+	std::string key;
+	bool is_recording = false;
+	std::string disabled;
+	int made_calls = 0;
+	std::vector<COUNTS> made_counts;
+	std::vector<std::string> shells;
+	std::unordered_set<std::string> outputs;
+	timestamp started;
+
+	static snapshot & get()
+	{
+		static snapshot s;
+		return s;
+	}
+
+	bool is_snapshot_file(const char * path)
+	{
+		std::string p = absolute_path(path);
+		return p == filename || p == filename + ".b2-tmp";
+	}
+
+	// The digest of the paths of the directory, without the snapshot.
+	std::string listing_digest(const file_info_t & dir)
+	{
+		std::vector<std::string> names;
+		for (auto path : b2::list_cref(dir.files))
+			if (!is_snapshot_file(path->str())) names.push_back(path->str());
+		std::sort(names.begin(), names.end());
+		md5_state_t state;
+		md5_init(&state);
+		for (auto & name : names) md5_add(state, name);
+		return md5_hex(state);
+	}
+
+	bool check_file(const std::string & path, const std::string & state)
+	{
+		b2::value_ref p(path);
+		std::string current = file_state(file_query(p));
+		if (state.size() == 2 && state[1] == '*')
+			return current.size() > 1 && current[0] == state[0];
+		return current == state;
+	}
+
+	bool check_dir(const std::string & path, const std::string & digest)
+	{
+		b2::value_ref p(path);
+		file_dirscan(p, ignore_scan, nullptr);
+		file_info_t * dir = file_query(p);
+		return dir && dir->is_dir && listing_digest(*dir) == digest;
+	}
+
+	bool check_shell(const std::vector<std::string> & fields)
+	{
+		FRAME frame;
+		frame_init(&frame);
+		for (std::size_t i = 2; i < fields.size(); ++i)
+			lol_add(frame.args, list_new(object_new(fields[i].c_str())));
+		LIST * result = builtin_shell(&frame, 0);
+		bool same = result_digest(result) == fields[1];
+		list_free(result);
+		frame_free(&frame);
+		return same;
+	}
+
+	// Are the recorded inputs the same as the current ones. Also collects the
+	// make counts to repeat.
+	bool is_current()
+	{
+		if (!b2::filesys::is_file(filename)) return false;
+		b2::filesys::file_buffer data(filename);
+		const char * i = data.begin();
+		const char * end = data.end();
+		auto next_line = [&]() {
+			const char * e
+				= static_cast<const char *>(std::memchr(i, '\n', end - i));
+			std::string line(i, e ? e : end);
+			i = e ? e + 1 : end;
+			return line;
+		};
+		if (next_line() != file_version) return false;
+		// The SHELL commands are run again last, after the cheaper checks.
+		std::vector<std::vector<std::string>> shell_records;
+		bool has_key = false;
+		while (i < end)
+		{
+			std::vector<std::string> fields = split_fields(next_line());
+			const std::string & kind = fields[0];
+			if (kind == "key" && fields.size() == 2)
+			{
+				if (fields[1] != key) return false;
+				has_key = true;
+			}
+			else if (kind == "file" && fields.size() == 3)
+			{
+				if (!check_file(fields[1], fields[2])) return false;
+			}
+			else if (kind == "dir" && fields.size() == 3)
+			{
+				if (!check_dir(fields[1], fields[2])) return false;
+			}
+			else if (kind == "shell" && fields.size() >= 3)
+			{
+				shell_records.push_back(fields);
+			}
+			else if (kind == "made" && fields.size() == 3)
+			{
+				COUNTS counts = {};
+				counts.targets = std::atoi(fields[1].c_str());
+				counts.temp = std::atoi(fields[2].c_str());
+				made_counts.push_back(counts);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		if (!has_key) return false;
+		for (auto & fields : shell_records)
+			if (!check_shell(fields)) return false;
+		return true;
+	}
+
+	// Was any file the build asked about, other than the ones it wrote,
+	// modified after the build started. The recorded state would not match
+	// what the build used.
+	bool inputs_changed()
+	{
+		bool changed = false;
+		b2::filesys::for_each_info([&](const file_info_t & info) {
+			if (changed || !info.queried || !info.exists || info.is_dir) return;
+			if (timestamp_cmp(&info.time, &started) < 0) return;
+			if (is_snapshot_file(info.name->str())) return;
+			if (outputs.count(absolute_path(info.name->str())) == 0)
+				changed = true;
+		});
+		return changed;
+	}
+
+	void write()
+	{
+		b2::filesys::replace_file(filename, [this](FILE * f) {
+			write(f);
+			return true;
+		});
+	}
+
+	void write(FILE * f)
+	{
+		std::fprintf(f, "%s\n", file_version);
+		std::fprintf(f, "key\t%s\n", key.c_str());
+		b2::filesys::for_each_info([&](const file_info_t & info) {
+			// The paths only found listing a directory are covered by the
+			// digest of the listing.
+			if (!info.queried || is_snapshot_file(info.name->str())) return;
+			// The files the build wrote are only checked to exist, as they
+			// may have changed after they were looked at.
+			std::string state = file_state(&info);
+			if (state.size() > 1
+				&& outputs.count(absolute_path(info.name->str())) > 0)
+				state = state.substr(0, 1) + "*";
+			std::fprintf(f, "file\t%s\t%s\n",
+				b2::filesys::escape_field(info.name->str()).c_str(),
+				state.c_str());
+			if (info.is_dir && !list_empty(info.files))
+				std::fprintf(f, "dir\t%s\t%s\n",
+					b2::filesys::escape_field(info.name->str()).c_str(),
+					listing_digest(info).c_str());
+		});
+		for (auto & shell : shells) std::fprintf(f, "%s\n", shell.c_str());
+		for (auto & counts : made_counts)
+			std::fprintf(f, "made\t%d\t%d\n", counts.targets, counts.temp);
+	}
+};
+
+std::string inputs_key(int argc, char ** argv, char ** env)
+{
+	md5_state_t state;
+	md5_init(&state);
+	md5_add(state, file_version);
+	md5_add(state, b2::startup::engine_identity());
+	md5_add(state, b2::cwd_str());
+	for (int a = 0; a < argc; ++a) md5_add(state, argv[a]);
+	md5_add(state, "");
+	std::vector<std::string> variables;
+	for (char ** e = env; e && *e; ++e) variables.push_back(*e);
+	std::sort(variables.begin(), variables.end());
+	for (auto & v : variables) md5_add(state, v);
+	return md5_hex(state);
+}
+
+} // namespace
+
+void disable(list_cref reason)
+{
+	disable_for(reason.empty() ? "disabled" : reason[0]->str());
+}
+
+void set_file(value_ref filename)
+{
+	snapshot::get().filename = absolute_path(filename->str());
+}
+
+bool start(int argc, char ** argv, char ** env)
+{
+	snapshot & s = snapshot::get();
+	if (s.filename.empty()) return false;
+	// The debugging output is not repeated.
+	for (int d = 3; d < DEBUG_MAX; ++d)
+		if (globs.debug[d]) return false;
+	s.key = inputs_key(argc, argv, env);
+	if (s.is_current())
+	{
+		for (auto & counts : s.made_counts) make_report(&counts);
+		return true;
+	}
+	s.made_counts.clear();
+	timestamp_current(&s.started);
+	s.is_recording = true;
+	return false;
+}
+
+void save(int status)
+{
+	snapshot & s = snapshot::get();
+	if (!s.is_recording) return;
+	s.is_recording = false;
+	if (status == 0 && s.disabled.empty() && s.made_calls > 0
+		&& !s.inputs_changed())
+		s.write();
+	else
+		std::remove(s.filename.c_str());
+}
+
+bool recording() { return snapshot::get().is_recording; }
+
+void disable_for(const char * reason)
+{
+	snapshot & s = snapshot::get();
+	if (!s.is_recording || !s.disabled.empty()) return;
+	s.disabled = reason;
+}
+
+void input(OBJECT * path)
+{
+	if (recording()) file_query(path);
+}
+
+void output(OBJECT * path)
+{
+	snapshot & s = snapshot::get();
+	if (s.is_recording) s.outputs.insert(absolute_path(path->str()));
+}
+
+void shell(LOL * args, LIST * result)
+{
+	snapshot & s = snapshot::get();
+	if (!s.is_recording) return;
+	std::string record = "shell\t" + result_digest(result);
+	for (int a = 0; a < args->count; ++a)
+	{
+		LIST * arg = lol_get(args, a);
+		if (list_empty(arg)) break;
+		record += "\t" + b2::filesys::escape_field(list_front(arg)->str());
+	}
+	s.shells.push_back(record);
+}
+
+void made(const COUNTS & counts)
+{
+	snapshot & s = snapshot::get();
+	if (!s.is_recording) return;
+	s.made_calls += 1;
+	if (counts.updating || counts.cantfind || counts.cantmake)
+		disable_for("updating targets");
+	// Only the counts that were printed are repeated.
+	if (is_debug_make()) s.made_counts.push_back(counts);
+}
+
+}} // namespace b2::graph_snapshot
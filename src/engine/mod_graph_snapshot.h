@@ -0,0 +1,117 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_GRAPH_SNAPSHOT_H
+#define B2_MOD_GRAPH_SNAPSHOT_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "lists.h"
+#include "make.h"
+#include "value.h"
+
+#include <string>
+
+/* tag::reference[]
+
+[[b2.reference.modules.graph_snapshot]]
+= `graph-snapshot` module.
+
+A snapshot of the inputs of a build that found nothing to update. It allows
+the following builds to skip loading the Jamfiles, generating the targets, and
+checking their timestamps, when nothing changed since. The snapshot records:
+
+* The engine binary, the current directory, the command line arguments, and the
+  environment variables.
+* The existence, and modification time, of every file the build looked at.
+  Including the Jamfiles, the build system modules, the sources, the headers
+  found by scanning, and the built targets.
+* The content of every directory the build listed, for example to find the
+  Jamfiles and modules, or to glob for files.
+* The `SHELL` commands run and a digest of what they returned.
+
+The snapshot is written only when the build finds nothing to update and
+succeeds, and none of the files it looked at were modified after it started.
+Other than the files the build wrote itself, like the configuration log, which
+are only checked to exist. A later build with the same arguments first checks
+the recorded inputs, running the recorded `SHELL` commands again. If none
+changed it prints what the build printed for the found targets and exits.
+Otherwise it runs the full build. The output of the Jamfiles, like
+configuration check results, is not repeated.
+
+The snapshot is enabled with the `--graph-snapshot=<file>` command line option.
+It is not used when debugging, with `-d3` or higher levels.
+
+end::reference[] */
+
+namespace b2 { namespace graph_snapshot {
+
+/* tag::reference[]
+
+== `b2::graph_snapshot::disable`
+
+====
+[horizontal]
+Jam:: `rule disable ( reason * )`
+{CPP}:: `void disable(list_cref reason);`
+====
+
+Prevents writing a snapshot of the current build. For when the build depends on
+inputs the snapshot can not check, like reading the Windows registry.
+
+end::reference[] */
+void disable(list_cref reason);
+
+// Internal..
+
+void set_file(value_ref filename);
+
+// Checks the snapshot, if enabled, against the current inputs. When it is
+// current repeats the output of the snapshot build and returns true. Otherwise
+// starts recording the inputs of this build.
+bool start(int argc, char ** argv, char ** env);
+
+// Writes the snapshot when the build found nothing to update and succeeded.
+// Otherwise removes any existing, now outdated, snapshot.
+void save(int status);
+
+bool recording();
+
+// Prevents writing the snapshot, as the build used an input it can not check.
+void disable_for(const char * reason);
+
+// Record that the build looked at the file, such as when reading it.
+void input(OBJECT * path);
+
+// Record that the build wrote the file, such as when opening it for writing.
+void output(OBJECT * path);
+
+// Record the arguments, and result, of a SHELL call.
+void shell(LOL * args, LIST * result);
+
+// Record the targets found by make.
+void made(const COUNTS & counts);
+
+}} // namespace b2::graph_snapshot
+
+namespace b2 {
+
+struct graph_snapshot_module : b2::bind::module_<graph_snapshot_module>
+{
+	const char * module_name = "graph-snapshot";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		binder.def(&graph_snapshot::disable, "disable", ("reason" * _n));
+		binder.loaded();
+	}
+};
+
+} // namespace b2
+
+#endif
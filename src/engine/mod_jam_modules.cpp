@@ -62,6 +62,7 @@ static void clone_rule(rule_ptr source_rule, module_ptr target_module)
     rule_localize(target_rule, target_module);
     // EXPORT $(target-module) : $(target-rule) ;
     target_rule->exported = 1;
+    rules_changed();
     // IMPORT $(target-module) : $(target-rule) : :
     // $(target-module).$(target-rule) ;
     std::string target_rule_name = value_ref(target_rule->name)->str();
@@ -10,6 +10,7 @@
 #include "frames.h"
 #include "lists.h"
 #include "mem.h"
+#include "mod_feature.h"
 #include "modules.h"
 #include "native.h"
 #include "object.h"
@@ -18,6 +19,11 @@
 
 #include <string.h>
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 struct ps_map_entry
 {
     struct ps_map_entry * next;
@@ -147,6 +153,8 @@ static struct ps_map_entry * ps_map_insert(struct ps_map * map, LIST * key)
 
 static struct ps_map all_property_sets;
 
+static void property_set_created( module_t * m, LIST * raw );
+
 LIST * property_set_create( FRAME * frame, int flags )
 {
     LIST * properties = lol_get( frame->args, 0 );
@@ -165,6 +173,7 @@ LIST * property_set_create( FRAME * frame, int flags )
             b2::list_ref() + "property-set" );
         LISTITER iter, end;
         pos->value = *val.begin();
+        property_set_created( bindmodule( pos->value ), unique );
         var_set( bindmodule( pos->value ), b2::value_ref( "self.raw" ), unique, VAR_SET );
 
         for ( iter = list_begin( unique ), end = list_end( unique ); iter != end; ++iter )
@@ -185,15 +194,11 @@ LIST * property_set_create( FRAME * frame, int flags )
 }
 
 /* binary search for the property value */
-LIST * property_set_get( FRAME * frame, int flags )
+static LIST * property_set_get_values( LIST * props, const char * name )
 {
-    OBJECT * varname = object_new( "self.raw" );
-    LIST * props = var_get( frame->module, varname );
-    const char * name = object_str( list_front( lol_get( frame->args, 0 ) ) );
     size_t name_len = strlen( name );
     LISTITER begin, end;
     LIST * result = L0;
-    object_free( varname );
 
     /* Assumes random access */
     begin = list_begin( props ), end = list_end( props );
@@ -253,6 +258,15 @@ LIST * property_set_get( FRAME * frame, int flags )
     return result;
 }
 
+LIST * property_set_get( FRAME * frame, int flags )
+{
+    OBJECT * varname = object_new( "self.raw" );
+    LIST * props = var_get( frame->module, varname );
+    object_free( varname );
+    return property_set_get_values( props,
+        object_str( list_front( lol_get( frame->args, 0 ) ) ) );
+}
+
 /* binary search for the property value */
 LIST * property_set_contains_features( FRAME * frame, int flags )
 {
@@ -299,6 +313,438 @@ LIST * property_set_contains_features( FRAME * frame, int flags )
     return list_new( object_copy( constant_true ) );
 }
 
+/*
+ * The native side of the property-set instances. It keeps the attributes of
+ * the features of the properties, looked up once, to classify the properties.
+ * And it remembers the results of the members, like the Jam members did in
+ * the "self.*" variables.
+ */
+
+namespace
+{
+
+using b2::feature::attribute_bits;
+using b2::feature::attribute_dependency;
+using b2::feature::attribute_free;
+using b2::feature::attribute_incidental;
+using b2::feature::attribute_propagated;
+using b2::feature::attribute_version;
+
+/* The grist, i.e. the "<feature>", of the property. */
+std::string property_grist( OBJECT * p )
+{
+    char const * s = object_str( p );
+    char const * e = s[ 0 ] == '<' ? strchr( s, '>' ) : nullptr;
+    return e ? std::string( s, e + 1 ) : std::string();
+}
+
+/* The value of the property, i.e. without the grist. */
+char const * property_value( OBJECT * p )
+{
+    char const * s = object_str( p );
+    char const * e = s[ 0 ] == '<' ? strchr( s, '>' ) : nullptr;
+    return e ? e + 1 : s;
+}
+
+struct property_set
+{
+    b2::list_ref raw;
+    bool canonical = false; /* made by property-set.create */
+    std::vector<unsigned> attributes;
+    bool attributes_initialized = false;
+
+    b2::list_ref base, free, incidental;
+    bool base_initialized = false;
+    b2::list_ref dependency, non_dependency;
+    bool dependency_initialized = false;
+    b2::list_ref conditional, non_conditional;
+    bool conditional_initialized = false;
+    b2::list_ref base_relevant;
+    bool relevant_initialized = false;
+    b2::list_ref as_path;
+    bool as_path_initialized = false;
+    OBJECT * propagated = nullptr;
+
+    /* Results of the members with a property-set argument, by the argument. */
+    std::unordered_map<OBJECT *, OBJECT *> refined, added, relevant, evaluated;
+
+    explicit property_set( LIST * raw_ ) : raw( raw_ ) {}
+
+    unsigned attributes_of( int32_t i )
+    {
+        if ( !attributes_initialized )
+        {
+            for ( OBJECT * p : raw )
+                attributes.push_back( attribute_bits( b2::value_ref(
+                    property_grist( p ) ) ) );
+            attributes_initialized = true;
+        }
+        return attributes[ i ];
+    }
+};
+
+std::unordered_map<module_t *, std::unique_ptr<property_set>>
+    property_sets;
+
+/* The native side of the instance. Which is created on first use, for
+ * instances not made with property-set.create.
+ */
+property_set & get_property_set( module_t * m )
+{
+    auto & ps = property_sets[ m ];
+    if ( !ps )
+        ps.reset( new property_set( var_get( m, b2::value_ref( "self.raw" ) )
+            ) );
+    return *ps;
+}
+
+} // namespace
+
+static void property_set_created( module_t * m, LIST * raw )
+{
+    property_sets[ m ].reset( new property_set( raw ) );
+    property_sets[ m ]->canonical = true;
+}
+
+namespace
+{
+
+property_set & get_property_set( OBJECT * name )
+{
+    return get_property_set( bindmodule( name ) );
+}
+
+OBJECT * create( FRAME * frame, b2::list_ref const & properties )
+{
+    b2::list_ref result = b2::jam::run_rule( frame, "property-set.create",
+        properties );
+    return object_copy( list_front( *result ) );
+}
+
+LIST * return_property_set( OBJECT * ps )
+{
+    return list_new( object_copy( ps ) );
+}
+
+bool contains( LIST * l, OBJECT * v )
+{
+    for ( OBJECT * i : b2::list_cref( l ) )
+        if ( object_equal( i, v ) ) return true;
+    return false;
+}
+
+void init_base( property_set & ps )
+{
+    if ( ps.base_initialized ) return;
+    int32_t i = 0;
+    for ( OBJECT * p : ps.raw )
+    {
+        unsigned const a = ps.attributes_of( i++ );
+        /* A feature can be both incidental and free, in which case we add it
+         * to incidental.
+         */
+        if ( a & attribute_incidental )
+            ps.incidental.push_back( object_copy( p ) );
+        else if ( a & attribute_free )
+            ps.free.push_back( object_copy( p ) );
+        else
+            ps.base.push_back( object_copy( p ) );
+    }
+    ps.base_initialized = true;
+}
+
+void init_dependency( property_set & ps )
+{
+    if ( ps.dependency_initialized ) return;
+    int32_t i = 0;
+    for ( OBJECT * p : ps.raw )
+    {
+        if ( ps.attributes_of( i++ ) & attribute_dependency )
+            ps.dependency.push_back( object_copy( p ) );
+        else
+            ps.non_dependency.push_back( object_copy( p ) );
+    }
+    ps.dependency_initialized = true;
+}
+
+void init_conditional( property_set & ps )
+{
+    if ( ps.conditional_initialized ) return;
+    int32_t i = 0;
+    for ( OBJECT * p : ps.raw )
+    {
+        /* TODO: Note that non-conditional properties may contain colon (':')
+         * characters as well, e.g. free or indirect properties. Indirect
+         * properties for example contain a full Jamfile path in their value
+         * which on Windows file systems contains ':' as the drive separator.
+         */
+        bool const free = ps.attributes_of( i++ ) & attribute_free;
+        if ( ( strchr( property_value( p ), ':' ) && !free )
+            || property_grist( p ) == "<conditional>" )
+            ps.conditional.push_back( object_copy( p ) );
+        else
+            ps.non_conditional.push_back( object_copy( p ) );
+    }
+    ps.conditional_initialized = true;
+}
+
+void init_relevant( FRAME * frame, property_set & ps )
+{
+    if ( ps.relevant_initialized ) return;
+    b2::list_ref relevant_features;
+    for ( OBJECT * f : b2::jam::run_rule( frame, "feature.expand-relevant",
+        b2::list_ref( property_set_get_values( *ps.raw, "<relevant>" ), true ) ) )
+        relevant_features.push_back( "<" + std::string( object_str( f ) )
+            + ">" );
+    int32_t i = 0;
+    for ( OBJECT * p : ps.raw )
+    {
+        unsigned const a = ps.attributes_of( i++ );
+        if ( !( a & ( attribute_incidental | attribute_free ) )
+            && contains( *relevant_features,
+                b2::value_ref( property_grist( p ) ) ) )
+            ps.base_relevant.push_back( object_copy( p ) );
+    }
+    ps.relevant_initialized = true;
+}
+
+} // namespace
+
+LIST * property_set_base( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_base( ps );
+    return list_copy( *ps.base );
+}
+
+LIST * property_set_free( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_base( ps );
+    return list_copy( *ps.free );
+}
+
+LIST * property_set_incidental( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_base( ps );
+    return list_copy( *ps.incidental );
+}
+
+LIST * property_set_dependency( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_dependency( ps );
+    return list_copy( *ps.dependency );
+}
+
+LIST * property_set_non_dependency( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_dependency( ps );
+    return list_copy( *ps.non_dependency );
+}
+
+LIST * property_set_conditional( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_conditional( ps );
+    return list_copy( *ps.conditional );
+}
+
+LIST * property_set_non_conditional( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_conditional( ps );
+    return list_copy( *ps.non_conditional );
+}
+
+LIST * property_set_base_relevant( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    init_relevant( frame, ps );
+    return list_copy( *ps.base_relevant );
+}
+
+/* The properties of the features marked as relevant by features-ps, without
+ * expanding them.
+ */
+LIST * property_set_relevant( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    OBJECT * const features_ps = list_front( lol_get( frame->args, 0 ) );
+    OBJECT * & result = ps.relevant[ features_ps ];
+    if ( !result )
+    {
+        b2::list_ref features;
+        for ( OBJECT * f : b2::list_cref( property_set_get_values(
+            *get_property_set( features_ps ).raw, "<relevant>" ) ) )
+            features.push_back( "<" + std::string( object_str( f ) ) + ">" );
+        b2::list_ref relevant;
+        int32_t i = 0;
+        for ( OBJECT * p : ps.raw )
+        {
+            if ( !( ps.attributes_of( i++ ) & attribute_incidental )
+                && contains( *features, b2::value_ref( property_grist( p ) ) ) )
+                relevant.push_back( object_copy( p ) );
+        }
+        result = create( frame, relevant );
+    }
+    return return_property_set( result );
+}
+
+LIST * property_set_propagated( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    if ( !ps.propagated )
+    {
+        b2::list_ref propagated;
+        int32_t i = 0;
+        for ( OBJECT * p : ps.raw )
+            if ( ps.attributes_of( i++ ) & attribute_propagated )
+                propagated.push_back( object_copy( p ) );
+        ps.propagated = create( frame, propagated );
+    }
+    return return_property_set( ps.propagated );
+}
+
+LIST * property_set_as_path( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    if ( !ps.as_path_initialized )
+    {
+        init_relevant( frame, ps );
+        ps.as_path = b2::jam::run_rule( frame, "property.as-path",
+            ps.base_relevant );
+        ps.as_path_initialized = true;
+    }
+    return list_copy( *ps.as_path );
+}
+
+/*
+ * The properties, refined by the requirements of the argument. The properties
+ * of the non-free, non-conditional, features of the requirements replace the
+ * properties, and their subfeatures, of the same features.
+ */
+LIST * property_set_refine( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    OBJECT * const requirements_ps = list_front( lol_get( frame->args, 0 ) );
+    OBJECT * & result = ps.refined[ requirements_ps ];
+    if ( !result )
+    {
+        property_set & requirements = get_property_set( requirements_ps );
+        std::vector<std::string> unset;
+        bool resolve_version = false;
+        int32_t i = 0;
+        for ( OBJECT * r : requirements.raw )
+        {
+            unsigned const a = requirements.attributes_of( i++ );
+            /* Do not consider conditional requirements. */
+            if ( strstr( property_value( r ), ":<" ) || ( a & attribute_free ) )
+                continue;
+            std::string const f = property_grist( r );
+            if ( a & attribute_version )
+                resolve_version = true;
+            else if ( !contains( *ps.raw, r ) )
+            {
+                /* Kill subfeatures of properties that we're changing, except
+                 * the non-specific subfeatures.
+                 */
+                for ( OBJECT * sub : b2::feature::subfeatures(
+                    b2::value_ref( f ) ) )
+                {
+                    if ( strchr( object_str( sub ), ':' ) )
+                        unset.push_back( f.substr( 0, f.size() - 1 ) + "-"
+                            + object_str( sub ) + ">" );
+                }
+            }
+            unset.push_back( f );
+        }
+        b2::list_ref refined;
+        if ( resolve_version )
+        {
+            /* Resolving compatible versions is left to property.refine. */
+            refined = b2::jam::run_rule( frame, "property.refine", ps.raw,
+                requirements.raw );
+        }
+        else
+        {
+            for ( OBJECT * p : ps.raw )
+            {
+                /* Keep conditional properties, and anything that is not
+                 * overridden, i.e. not in the requirements.
+                 */
+                if ( strstr( property_value( p ), ":<" ) )
+                    refined.push_back( object_copy( p ) );
+                else
+                {
+                    std::string const f = property_grist( p );
+                    bool overridden = false;
+                    for ( auto const & u : unset )
+                        if ( u == f ) { overridden = true; break; }
+                    if ( !overridden )
+                        refined.push_back( object_copy( p ) );
+                }
+            }
+            refined.append( requirements.raw );
+        }
+        result = create( frame, refined );
+    }
+    return return_property_set( result );
+}
+
+LIST * property_set_add( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    OBJECT * const other = list_front( lol_get( frame->args, 0 ) );
+    OBJECT * & result = ps.added[ other ];
+    if ( !result )
+    {
+        b2::list_ref added( ps.raw );
+        added.append( get_property_set( other ).raw );
+        result = create( frame, added );
+    }
+    return return_property_set( result );
+}
+
+/*
+ * The property set with the conditional properties evaluated in the context,
+ * this property set by default. Without any conditional properties, or
+ * <build>no, that is the same property set.
+ */
+LIST * property_set_evaluate_conditionals( FRAME * frame, int flags )
+{
+    property_set & ps = get_property_set( frame->module );
+    LIST * const context_arg = lol_get( frame->args, 0 );
+    OBJECT * const context = list_empty( context_arg )
+        ? frame->module->name : list_front( context_arg );
+    OBJECT * & result = ps.evaluated[ context ];
+    if ( !result )
+    {
+        bool evaluate = false;
+        int32_t i = 0;
+        for ( OBJECT * p : ps.raw )
+        {
+            bool const free = ps.attributes_of( i++ ) & attribute_free;
+            if ( ( strstr( object_str( p ), ":<" ) && !free )
+                || property_grist( p ) == "<conditional>"
+                || strcmp( object_str( p ), "<build>no" ) == 0 )
+            {
+                evaluate = true;
+                break;
+            }
+        }
+        if ( !evaluate && ps.canonical )
+            result = object_copy( frame->module->name );
+        else
+            result = create( frame, b2::jam::run_rule( frame,
+                "property.evaluate-conditionals-in-context", ps.raw,
+                get_property_set( context ).raw ) );
+    }
+    return return_property_set( result );
+}
+
 void init_property_set()
 {
     {
@@ -313,10 +759,37 @@ void init_property_set()
         char const * args[] = { "features", "*", 0 };
         declare_native_rule( "class@property-set", "contains-features", args, property_set_contains_features, 1 );
     }
+    {
+        char const * args[] = { 0 };
+        declare_native_rule( "class@property-set", "base", args, property_set_base, 1 );
+        declare_native_rule( "class@property-set", "free", args, property_set_free, 1 );
+        declare_native_rule( "class@property-set", "incidental", args, property_set_incidental, 1 );
+        declare_native_rule( "class@property-set", "dependency", args, property_set_dependency, 1 );
+        declare_native_rule( "class@property-set", "non-dependency", args, property_set_non_dependency, 1 );
+        declare_native_rule( "class@property-set", "conditional", args, property_set_conditional, 1 );
+        declare_native_rule( "class@property-set", "non-conditional", args, property_set_non_conditional, 1 );
+        declare_native_rule( "class@property-set", "base-relevant", args, property_set_base_relevant, 1 );
+        declare_native_rule( "class@property-set", "propagated", args, property_set_propagated, 1 );
+        declare_native_rule( "class@property-set", "as-path", args, property_set_as_path, 1 );
+    }
+    {
+        char const * args[] = { "features-ps", 0 };
+        declare_native_rule( "class@property-set", "relevant", args, property_set_relevant, 1 );
+    }
+    {
+        char const * args[] = { "ps", 0 };
+        declare_native_rule( "class@property-set", "refine", args, property_set_refine, 1 );
+        declare_native_rule( "class@property-set", "add", args, property_set_add, 1 );
+    }
+    {
+        char const * args[] = { "context", "?", 0 };
+        declare_native_rule( "class@property-set", "evaluate-conditionals", args, property_set_evaluate_conditionals, 1 );
+    }
     ps_map_init( &all_property_sets );
 }
 
 void property_set_done()
 {
+    property_sets.clear();
     ps_map_destroy( &all_property_sets );
 }
@@ -0,0 +1,342 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "jam.h"
+#include "mod_shell_cache.h"
+
+#include "cwd.h"
+#include "events.h"
+#include "filesys.h"
+#include "md5.h"
+#include "pathsys.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace b2 { namespace shell_cache {
+
+namespace {
+
+const char * file_version = "b2-shell-cache-1";
+
+// The environment variables that change the output of most commands. And
+// those that change where the compilers, and interpreters, that the toolsets
+// probe look for their parts.
+const char * const keyed_environment[] = { "PATH", "LANG", "LC_ALL",
+	"LC_MESSAGES", "GCC_EXEC_PREFIX", "COMPILER_PATH", "PYTHONHOME",
+	"PYTHONPATH" };
+
+#ifdef NT
+const char path_list_separator = ';';
+#else
+const char path_list_separator = ':';
+#endif
+
+bool is_name_char(char c)
+{
+	return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// The names of the environment variables the command refers to.
+std::vector<std::string> command_environment(const std::string & command)
+{
+	std::vector<std::string> names;
+	for (std::string::size_type i = 0; i < command.size(); ++i)
+	{
+		std::string::size_type b = std::string::npos;
+		std::string::size_type e = std::string::npos;
+		if (command[i] == '$' && i + 1 < command.size())
+		{
+			b = command[i + 1] == '{' ? i + 2 : i + 1;
+			for (e = b; e < command.size() && is_name_char(command[e]); ++e)
+			{}
+		}
+		else if (command[i] == '%')
+		{
+			b = i + 1;
+			e = command.find('%', b);
+			if (e == std::string::npos) break;
+		}
+		if (b == std::string::npos || e == b) continue;
+		bool is_name = true;
+		for (auto n = b; n < e; ++n)
+			is_name = is_name && is_name_char(command[n]);
+		if (!is_name) continue;
+		names.push_back(command.substr(b, e - b));
+		i = command[i] == '%' ? e : e - 1;
+	}
+	return names;
+}
+
+// The first word of each command in the pipeline, or list, of commands. Or
+// false if the commands use shell syntax, like command substitution,
+// subshells, or variable assignments, that hides which programs run.
+bool command_programs(
+	const std::string & command, std::vector<std::string> & programs)
+{
+	std::string word;
+	bool in_word = false;
+	bool at_start = true;
+	char quote = 0;
+	auto end_word = [&]() -> bool {
+		if (in_word && at_start)
+		{
+			if (word.find('=') != std::string::npos) return false;
+			programs.push_back(word);
+			at_start = false;
+		}
+		word.clear();
+		in_word = false;
+		return true;
+	};
+	for (std::string::size_type i = 0; i < command.size(); ++i)
+	{
+		char c = command[i];
+		if (quote != 0)
+		{
+			if (c == quote)
+				quote = 0;
+			else
+				word += c;
+			continue;
+		}
+		if (c == '"' || c == '\'')
+		{
+			quote = c;
+			in_word = true;
+		}
+		else if (c == '`' || c == '(' || c == ')')
+		{
+			return false;
+		}
+		else if (c == '|' || c == ';'
+			|| (c == '&' && (i == 0 || (command[i - 1] != '>'
+				&& command[i - 1] != '<'))))
+		{
+			if (!end_word()) return false;
+			at_start = true;
+		}
+		else if (std::isspace(static_cast<unsigned char>(c)))
+		{
+			if (!end_word()) return false;
+		}
+		else
+		{
+			word += c;
+			in_word = true;
+		}
+	}
+	return quote == 0 && end_word() && !programs.empty();
+}
+
+// The path, modification time, size, and inode of the program, found in the
+// PATH when it has no directory. Or empty if the program is not found.
+std::string program_signature(const std::string & program)
+{
+	std::vector<std::string> candidates;
+	if (program.find_first_of("/\\") != std::string::npos)
+	{
+		candidates.push_back(program);
+	}
+	else
+	{
+		const char * path = std::getenv("PATH");
+		std::string dirs = path ? path : "";
+		std::string::size_type b = 0;
+		while (b <= dirs.size())
+		{
+			std::string::size_type e = dirs.find(path_list_separator, b);
+			if (e == std::string::npos) e = dirs.size();
+			std::string dir = dirs.substr(b, e - b);
+			if (dir.empty()) dir = ".";
+			candidates.push_back(dir + "/" + program);
+#ifdef NT
+			for (const char * ext : { ".exe", ".com", ".bat", ".cmd" })
+				candidates.push_back(dir + "/" + program + ext);
+#endif
+			b = e + 1;
+		}
+	}
+	for (auto & c : candidates)
+	{
+		struct stat st;
+		if (::stat(c.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+			continue;
+		char info[96];
+		std::snprintf(info, sizeof(info), "\t%lld\t%lld\t%llu",
+			(long long)st.st_mtime, (long long)st.st_size,
+			(unsigned long long)st.st_ino);
+		return c + info;
+	}
+	return std::string();
+}
+
+// The cache file is a version line followed by one record line per command
+// run: "<key>\t<output>", with the output escaped. Later records replace
+// earlier ones. When the superseded records outnumber the current ones the
+// file is rewritten with only the current records.
+struct cache
+{
+	std::string filename;
+	std::unordered_map<std::string, std::string> records;
+	std::size_t record_lines = 0;
+	FILE * out = nullptr;
+
+	static cache & get()
+	{
+		static cache c;
+		return c;
+	}
+
+	void set_file(const std::string & f)
+	{
+		if (filename.empty())
+		{
+			add_event_callback(event_tag::exit_main,
+				std::function<void(int)>(
+					[](int) { cache::get().exit_main(); }));
+		}
+		close();
+		records.clear();
+		record_lines = 0;
+		filename = b2::paths::normalize(
+			b2::paths::is_rooted(f) ? f : b2::cwd_str() + "/" + f);
+		load();
+	}
+
+	void load()
+	{
+		if (!b2::filesys::is_file(filename)) return;
+		b2::filesys::file_buffer data(filename);
+		const char * i = data.begin();
+		const char * end = data.end();
+		auto next_line = [&]() {
+			const char * e = static_cast<const char *>(
+				std::memchr(i, '\n', end - i));
+			std::string line(i, e ? e : end);
+			i = e ? e + 1 : end;
+			return line;
+		};
+		// Files from other versions, or that are not ours, are ignored and
+		// replaced.
+		if (next_line() != file_version) return;
+		while (i < end)
+		{
+			std::string line = next_line();
+			std::string::size_type output_at = line.find('\t');
+			if (output_at == std::string::npos) continue;
+			records[line.substr(0, output_at)]
+				= b2::filesys::unescape_field(line.substr(output_at + 1));
+			record_lines += 1;
+		}
+	}
+
+	bool open()
+	{
+		if (out) return true;
+		if (record_lines == 0)
+		{
+			out = std::fopen(filename.c_str(), "w");
+			if (out) std::fprintf(out, "%s\n", file_version);
+		}
+		else
+		{
+			out = std::fopen(filename.c_str(), "a");
+		}
+		return out != nullptr;
+	}
+
+	void close()
+	{
+		if (out) std::fclose(out);
+		out = nullptr;
+	}
+
+	void write(FILE * f, const std::string & k, const std::string & output)
+	{
+		std::fprintf(f, "%s\t%s\n", k.c_str(),
+			b2::filesys::escape_field(output).c_str());
+	}
+
+	void store(const std::string & k, const std::string & output)
+	{
+		records[k] = output;
+		if (!open()) return;
+		write(out, k, output);
+		// Flush to keep the records of commands run before a failure.
+		std::fflush(out);
+		record_lines += 1;
+	}
+
+	void exit_main()
+	{
+		close();
+		if (record_lines <= records.size() * 2) return;
+		b2::filesys::replace_file(filename, [this](FILE * f) {
+			std::fprintf(f, "%s\n", file_version);
+			for (auto & r : records) write(f, r.first, r.second);
+			return true;
+		});
+	}
+};
+
+} // namespace
+
+void set_file(value_ref filename) { cache::get().set_file(filename->str()); }
+
+bool enabled() { return !cache::get().filename.empty(); }
+
+std::string key(const char * command)
+{
+	std::vector<std::string> programs;
+	if (!command_programs(command, programs)) return std::string();
+	md5_state_t state;
+	md5_init(&state);
+	md5_add(state, file_version);
+	md5_add(state, command);
+	md5_add(state, b2::cwd_str());
+	for (const char * name : keyed_environment)
+	{
+		const char * v = std::getenv(name);
+		md5_add(state, std::string(name) + "=" + (v ? v : ""));
+	}
+	for (auto & name : command_environment(command))
+	{
+		const char * v = std::getenv(name.c_str());
+		md5_add(state, name + "=" + (v ? v : ""));
+	}
+	for (auto & program : programs)
+	{
+		std::string signature = program_signature(program);
+		if (signature.empty()) return std::string();
+		md5_add(state, signature);
+	}
+	return md5_hex(state);
+}
+
+bool find(const std::string & key, std::string & output)
+{
+	auto & records = cache::get().records;
+	auto r = records.find(key);
+	if (r == records.end()) return false;
+	output = r->second;
+	return true;
+}
+
+void store(const std::string & key, const std::string & output)
+{
+	if (!enabled()) return;
+	cache::get().store(key, output);
+}
+
+}} // namespace b2::shell_cache
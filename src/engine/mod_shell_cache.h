@@ -0,0 +1,99 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_SHELL_CACHE_H
+#define B2_MOD_SHELL_CACHE_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "lists.h"
+#include "value.h"
+
+#include <string>
+
+/* tag::reference[]
+
+[[b2.reference.modules.shell_cache]]
+= `shell-cache` module.
+
+A persistent record of the output of `SHELL` commands that are run with the
+`cache` option. Such as the commands that toolsets run to find the version,
+and configuration, of the compilers and tools. A command is cached only when
+it succeeds, and the recorded output is used again in later runs as long as
+these are the same:
+
+* The command text.
+* The current directory.
+* The `PATH`, `LANG`, `LC_ALL`, and `LC_MESSAGES` environment variables. The
+  `GCC_EXEC_PREFIX`, `COMPILER_PATH`, `PYTHONHOME`, and `PYTHONPATH`
+  environment variables, that change what the compiler and interpreter probes
+  of the toolsets find. And any other variables the command refers to, as
+  `$NAME`, `${NAME}`, or `%NAME%`.
+* The path, modification time, size, and inode of the program that each
+  command in the pipeline, or list, of commands runs. As found in the `PATH`
+  if not given with a directory.
+
+Commands that use shell syntax that hides which programs run, like command
+substitution, subshells, or variable assignments, are not cached. Neither
+are the commands whose programs are not found.
+
+The cache is enabled with the `--shell-cache=<file>` command line option or by
+calling `shell-cache.set-file`.
+
+end::reference[] */
+
+namespace b2 { namespace shell_cache {
+
+/* tag::reference[]
+
+== `b2::shell_cache::set_file`
+
+====
+[horizontal]
+Jam:: `rule set-file ( filename )`
+{CPP}:: `void set_file(value_ref filename);`
+====
+
+Enables caching the output of the `SHELL` commands in the given file. Any
+existing records in the file are loaded.
+
+end::reference[] */
+void set_file(value_ref filename);
+
+// Internal..
+
+bool enabled();
+
+// The key for the current state of the inputs of the command. Or empty if the
+// command can not be cached.
+std::string key(const char * command);
+
+// Sets the output recorded for the key, and returns true, if any.
+bool find(const std::string & key, std::string & output);
+
+// Record the output of a successful run of the command with the key.
+void store(const std::string & key, const std::string & output);
+
+}} // namespace b2::shell_cache
+
+namespace b2 {
+
+struct shell_cache_module : b2::bind::module_<shell_cache_module>
+{
+	const char * module_name = "shell-cache";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		binder.def(&shell_cache::set_file, "set-file", ("filename" * _1));
+		binder.loaded();
+	}
+};
+
+} // namespace b2
+
+#endif
@@ -0,0 +1,212 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "jam.h"
+#include "mod_timing_db.h"
+
+#include "cwd.h"
+#include "events.h"
+#include "filesys.h"
+#include "pathsys.h"
+#include "timestamp.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace b2 { namespace timing_db {
+
+namespace {
+
+const char * file_version = "b2-timing-db-1";
+
+struct times
+{
+	double wall = 0;
+	double user = 0;
+	double system = 0;
+};
+
+// The database file is a version line followed by one record line per action
+// run, in the order they ran: "<wall> <user> <system>\t<rule>\t<target>".
+// Later records replace earlier ones. When the superseded records outnumber the
+// current ones the file is rewritten with only the current records.
+struct db
+{
+	std::string filename;
+	std::unordered_map<std::string, times> records;
+	std::size_t record_lines = 0;
+	FILE * out = nullptr;
+	double wall_total = 0;
+
+	static db & get()
+	{
+		static db d;
+		return d;
+	}
+
+	static std::string key(value_ref rule, value_ref target)
+	{
+		std::string k = rule->str();
+		k += '\t';
+		k += target->str();
+		return k;
+	}
+
+	void set_file(const std::string & f)
+	{
+		if (filename.empty())
+		{
+			add_event_callback(event_tag::exit_main,
+				std::function<void(int)>([](int) { db::get().exit_main(); }));
+		}
+		close();
+		records.clear();
+		record_lines = 0;
+		wall_total = 0;
+		filename = b2::paths::normalize(
+			b2::paths::is_rooted(f) ? f : b2::cwd_str() + "/" + f);
+		load();
+	}
+
+	void load()
+	{
+		if (!b2::filesys::is_file(filename)) return;
+		b2::filesys::file_buffer data(filename);
+		const char * i = data.begin();
+		const char * end = data.end();
+		auto next_line = [&]() {
+			const char * e = static_cast<const char *>(
+				std::memchr(i, '\n', end - i));
+			std::string line(i, e ? e : end);
+			i = e ? e + 1 : end;
+			return line;
+		};
+		// Files from other versions, or that are not ours, are ignored and
+		// replaced.
+		if (next_line() != file_version) return;
+		while (i < end)
+		{
+			std::string line = next_line();
+			std::string::size_type rule_at = line.find('\t');
+			if (rule_at == std::string::npos
+				|| line.find('\t', rule_at + 1) == std::string::npos)
+				continue;
+			times t;
+			char * n = nullptr;
+			t.wall = std::strtod(line.c_str(), &n);
+			t.user = std::strtod(n, &n);
+			t.system = std::strtod(n, &n);
+			add(line.substr(rule_at + 1), t);
+			record_lines += 1;
+		}
+	}
+
+	void add(const std::string & k, const times & t)
+	{
+		times & r = records[k];
+		wall_total += t.wall - r.wall;
+		r = t;
+	}
+
+	bool open()
+	{
+		if (out) return true;
+		if (record_lines == 0)
+		{
+			out = std::fopen(filename.c_str(), "w");
+			if (out) std::fprintf(out, "%s\n", file_version);
+		}
+		else
+		{
+			out = std::fopen(filename.c_str(), "a");
+		}
+		return out != nullptr;
+	}
+
+	void close()
+	{
+		if (out) std::fclose(out);
+		out = nullptr;
+	}
+
+	void write(FILE * f, const std::string & k, const times & t)
+	{
+		std::fprintf(f, "%.6f %.6f %.6f\t%s\n", t.wall, t.user, t.system,
+			k.c_str());
+	}
+
+	void record(value_ref rule, value_ref target, const times & t)
+	{
+		std::string k = key(rule, target);
+		add(k, t);
+		if (!open()) return;
+		write(out, k, t);
+		record_lines += 1;
+	}
+
+	double estimate(value_ref rule, value_ref target)
+	{
+		auto r = records.find(key(rule, target));
+		if (r != records.end()) return r->second.wall;
+		if (!records.empty()) return wall_total / records.size();
+		return 1;
+	}
+
+	void exit_main()
+	{
+		close();
+		if (record_lines <= records.size() * 2) return;
+		b2::filesys::replace_file(filename, [this](FILE * f) {
+			std::fprintf(f, "%s\n", file_version);
+			for (auto & r : records) write(f, r.first, r.second);
+			return true;
+		});
+	}
+};
+
+} // namespace
+
+void set_file(value_ref filename) { db::get().set_file(filename->str()); }
+
+list_ref get(value_ref rule, value_ref target)
+{
+	list_ref result;
+	auto & records = db::get().records;
+	auto r = records.find(db::key(rule, target));
+	if (r != records.end())
+	{
+		for (double t : { r->second.wall, r->second.user, r->second.system })
+		{
+			char n[32];
+			std::snprintf(n, sizeof(n), "%.6f", t);
+			result.push_back(std::string(n));
+		}
+	}
+	return result;
+}
+
+bool enabled() { return !db::get().filename.empty(); }
+
+void record(value_ref rule, value_ref target, const timing_info & time)
+{
+	if (!enabled()) return;
+	times t;
+	t.wall = timestamp_delta_seconds(&time.start, &time.end);
+	t.user = time.user;
+	t.system = time.system;
+	db::get().record(rule, target, t);
+}
+
+double estimate(value_ref rule, value_ref target)
+{
+	if (!enabled()) return 1;
+	return db::get().estimate(rule, target);
+}
+
+}} // namespace b2::timing_db
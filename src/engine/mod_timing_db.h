@@ -0,0 +1,103 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_TIMING_DB_H
+#define B2_MOD_TIMING_DB_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "execcmd.h"
+#include "lists.h"
+#include "value.h"
+
+/* tag::reference[]
+
+[[b2.reference.modules.timing_db]]
+= `timing-db` module.
+
+A persistent record of how long actions took to run. For every action command
+that runs the wall clock, user, and system times are recorded keyed by the
+action rule name and the bound name of the first target of the action. The
+records are appended to the database file as the build goes. And when loading
+the most recent record for each action is used.
+
+The recorded times are used to estimate the duration of actions. For example
+the `--critical-path` scheduling uses them to find the longest chains of
+actions.
+
+The database is enabled with the `--timing-db=<file>` command line option or by
+calling `timing-db.set-file`.
+
+end::reference[] */
+
+namespace b2 { namespace timing_db {
+
+/* tag::reference[]
+
+== `b2::timing_db::set_file`
+
+====
+[horizontal]
+Jam:: `rule set-file ( filename )`
+{CPP}:: `void set_file(value_ref filename);`
+====
+
+Enables recording action times to the given file. Any existing records in the
+file are loaded.
+
+end::reference[] */
+void set_file(value_ref filename);
+
+/* tag::reference[]
+
+== `b2::timing_db::get`
+
+====
+[horizontal]
+Jam:: `rule get ( rule : target )`
+{CPP}:: `list_ref get(value_ref rule, value_ref target);`
+====
+
+Returns the wall clock, user, and system times, in seconds, of the last run of
+the action `rule` for the bound `target` name. Or an empty list if the action
+was not recorded.
+
+end::reference[] */
+list_ref get(value_ref rule, value_ref target);
+
+// Internal..
+
+bool enabled();
+
+// Record the times of running the action rule for the target.
+void record(value_ref rule, value_ref target, const timing_info & time);
+
+// The estimated wall clock seconds to run the action rule for the target. For
+// actions not recorded this is the average of the recorded actions, or 1 if
+// there are none.
+double estimate(value_ref rule, value_ref target);
+
+}} // namespace b2::timing_db
+
+namespace b2 {
+
+struct timing_db_module : b2::bind::module_<timing_db_module>
+{
+	const char * module_name = "timing-db";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		binder.def(&timing_db::set_file, "set-file", ("filename" * _1));
+		binder.def(&timing_db::get, "get", ("rule" * _1) | ("target" * _1));
+		binder.loaded();
+	}
+};
+
+} // namespace b2
+
+#endif
@@ -0,0 +1,173 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#include "mod_toolset.h"
+
+#include "bindjam.h"
+#include "compile.h"
+#include "frames.h"
+#include "mod_feature.h"
+#include "rules.h"
+#include "variable.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace b2 { namespace toolset {
+
+namespace {
+
+using value_set = std::unordered_set<value_ref,
+	value_ref::hash_function,
+	value_ref::equal_function>;
+template <class T>
+using value_map = std::unordered_map<value_ref,
+	T,
+	value_ref::hash_function,
+	value_ref::equal_function>;
+
+// A property of a flag condition property set.
+struct condition_property
+{
+	value_ref property;
+	value_ref feature;
+	// A value-less property, like "<architecture>", that matches when the
+	// feature is absent.
+	bool absent = false;
+};
+
+using condition = std::vector<condition_property>;
+
+// The gristed feature of the property, or empty if none.
+value_ref feature_of(value_ref p)
+{
+	const char * s = p->str();
+	const char * e = s[0] == '<' ? std::strchr(s, '>') : nullptr;
+	return e ? value_ref(std::string(s, e + 1)) : value_ref();
+}
+
+// The flag conditions are few, and fixed when the flags are declared. So they
+// are split once.
+const condition & split_condition(value_ref property_set)
+{
+	static value_map<condition> conditions;
+	auto i = conditions.find(property_set);
+	if (i != conditions.end()) return i->second;
+	condition & c = conditions[property_set];
+	for (auto p : b2::feature::split(property_set))
+	{
+		condition_property cp;
+		cp.property = value_ref(p);
+		cp.feature = feature_of(cp.property);
+		cp.absent = cp.feature.has_value() && cp.feature == cp.property;
+		c.push_back(cp);
+	}
+	return c;
+}
+
+// The variable settings of a rule, or module, for a property set. Grouped by
+// variable, in the order they first appear, to append them with one call.
+using target_settings = std::vector<std::pair<value_ref, list_ref>>;
+
+// The settings, by rule-or-module and property set. Both the property sets
+// given, and the ones filtered to the relevant features, are keys to the
+// shared settings.
+using settings_map = value_map<std::shared_ptr<const target_settings>>;
+value_map<settings_map> & settings_cache()
+{
+	static value_map<settings_map> cache;
+	return cache;
+}
+
+std::shared_ptr<const target_settings> make_settings(list_cref interleaved)
+{
+	std::shared_ptr<target_settings> settings
+		= std::make_shared<target_settings>();
+	value_map<std::size_t> index;
+	for (auto i = interleaved.begin(); i != interleaved.end(); ++i)
+	{
+		value_ref variable(*i);
+		if (++i == interleaved.end()) break;
+		auto v = index.find(variable);
+		if (v == index.end())
+		{
+			v = index.emplace(variable, settings->size()).first;
+			settings->emplace_back(variable, list_ref());
+		}
+		(*settings)[v->second].second.push_back(*i);
+	}
+	return settings;
+}
+
+} // namespace
+
+list_ref find_property_subset(list_cref property_sets, list_cref properties)
+{
+	value_set present;
+	value_set present_features;
+	for (auto p : properties)
+	{
+		present.insert(value_ref(p));
+		value_ref f = feature_of(value_ref(p));
+		if (f.has_value()) present_features.insert(f);
+	}
+	for (auto s : property_sets)
+	{
+		bool matches = true;
+		for (auto & p : split_condition(value_ref(s)))
+		{
+			if (present.count(p.property) > 0) continue;
+			if (p.absent && present_features.count(p.feature) == 0) continue;
+			matches = false;
+			break;
+		}
+		if (matches) return list_ref(value_ref(s));
+	}
+	return list_ref();
+}
+
+void set_target_variables(
+	std::tuple<value_ref, list_ref> rule_or_module_targets,
+	value_ref property_set,
+	bind::context_ref_ context_ref)
+{
+	value_ref rule_or_module = std::get<0>(rule_or_module_targets);
+	const list_ref & targets = std::get<1>(rule_or_module_targets);
+
+	auto & cache = settings_cache()[rule_or_module];
+	auto i = cache.find(property_set);
+	if (i == cache.end())
+	{
+		frame * outer = context_ref.get<jam::jam_context>().frame;
+		jam::module_scope scope(outer, "toolset");
+		list_ref filtered = jam::run_rule(outer, "filter-property-set",
+			list_ref(rule_or_module), list_ref(property_set));
+		value_ref filtered_ps(list_front(*filtered));
+		auto f = cache.find(filtered_ps);
+		if (f == cache.end())
+		{
+			list_ref interleaved
+				= jam::run_rule(outer, "set-target-variables-aux",
+					list_ref(rule_or_module), list_ref(filtered_ps));
+			f = cache.emplace(filtered_ps, make_settings(interleaved.cref()))
+					.first;
+		}
+		i = cache.emplace(property_set, f->second).first;
+	}
+
+	for (auto t : targets)
+	{
+		target_ref target { value_ref(t) };
+		for (auto & s : *i->second) target.on_append(s.first, s.second);
+	}
+}
+
+}} // namespace b2::toolset
@@ -0,0 +1,97 @@
+/*
+Copyright 2026 René Ferdinand Rivera Morell
+Distributed under the Boost Software License, Version 1.0.
+(See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+*/
+
+#ifndef B2_MOD_TOOLSET_H
+#define B2_MOD_TOOLSET_H
+
+#include "config.h"
+
+#include "bind.h"
+#include "lists.h"
+#include "value.h"
+
+#include <tuple>
+
+/* tag::reference[]
+
+[[b2.reference.modules.toolset]]
+= `toolset` module.
+
+The parts of the `toolset` build system module that run for every actualized
+target. The flag settings for a rule, or module, and a property set are
+computed once and kept, and applying them to targets needs no further
+evaluation.
+
+end::reference[] */
+
+namespace b2 { namespace toolset {
+
+/* tag::reference[]
+
+== `b2::toolset::find_property_subset`
+
+====
+[horizontal]
+Jam:: `rule find-property-subset ( property-sets * : properties * )`
+{CPP}:: `list_ref find_property_subset(list_cref property_sets, list_cref
+properties);`
+====
+
+Returns the first element of `property-sets` which is a subset of
+`properties` or an empty list if no such element exists. A value-less property,
+like `<architecture>`, in a property set matches when the feature is not in
+`properties`.
+
+end::reference[] */
+list_ref find_property_subset(list_cref property_sets, list_cref properties);
+
+/* tag::reference[]
+
+== `b2::toolset::set_target_variables`
+
+====
+[horizontal]
+Jam:: `rule set-target-variables ( rule-or-module targets + : property-set )`
+{CPP}:: `void set_target_variables(std::tuple<value_ref, list_ref>
+rule_or_module_targets, value_ref property_set, bind::context_ref_
+context_ref);`
+====
+
+Sets, on the targets, the flag variables for the rule, or module, and the
+property set. The variables are computed, with the Jam
+`set-target-variables-aux` rule, the first time for each rule and property set
+only.
+
+end::reference[] */
+void set_target_variables(
+	std::tuple<value_ref, list_ref> rule_or_module_targets,
+	value_ref property_set,
+	bind::context_ref_ context_ref);
+
+}} // namespace b2::toolset
+
+namespace b2 {
+
+struct toolset_module : b2::bind::module_<toolset_module>
+{
+	const char * module_name = "toolset";
+
+	template <class Binder>
+	void def(Binder & binder)
+	{
+		using namespace b2::toolset;
+		binder
+			.def(&find_property_subset, "find-property-subset",
+				"property-sets" * _n | "properties" * _n)
+			.def(&set_target_variables, "set-target-variables",
+				("rule-or-module" * _1 + "targets" * _1n)
+					| "property-set" * _1);
+	}
+};
+
+} // namespace b2
+
+#endif
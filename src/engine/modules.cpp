@@ -60,6 +60,8 @@ module_t * bindmodule( OBJECT * name )
             m->rules = 0;
             m->imported_modules = 0;
             m->class_module = 0;
+            m->instance_variables = 0;
+            m->num_instance_variables = 0;
             m->native_rules = 0;
             m->user_module = 0;
         }
@@ -114,6 +116,7 @@ void delete_module( module_t * m )
     /* Clear out all the rules. */
     if ( m->rules )
     {
+        rules_changed();
         hashenumerate( m->rules, delete_rule_, (void *)0 );
         hash_free( m->rules );
         m->rules = 0;
@@ -126,7 +129,7 @@ void delete_module( module_t * m )
         m->native_rules = 0;
     }
 
-    if ( m->variables )
+    if ( m->variables || m->instance_variables )
     {
         var_done( m );
         m->variables = 0;
@@ -164,6 +167,7 @@ struct module_stats
     OBJECT * module_name;
     struct hashstats rules_stats[ 1 ];
     struct hashstats variables_stats[ 1 ];
+    struct hashstats instance_variables_stats[ 1 ];
     struct hashstats variable_indices_stats[ 1 ];
     struct hashstats imported_modules_stats[ 1 ];
 };
@@ -222,12 +226,14 @@ static void stat_module( void * xmodule, void * data )
                 ms->module_name = m->class_module->name;
                 hashstats_init( ms->rules_stats );
                 hashstats_init( ms->variables_stats );
+                hashstats_init( ms->instance_variables_stats );
                 hashstats_init( ms->variable_indices_stats );
                 hashstats_init( ms->imported_modules_stats );
             }
 
             hashstats_add( ms->rules_stats, m->rules );
             hashstats_add( ms->variables_stats, m->variables );
+            var_instance_stats( m, ms->instance_variables_stats );
             hashstats_add( ms->variable_indices_stats, m->variable_indices );
             hashstats_add( ms->imported_modules_stats, m->imported_modules );
         }
@@ -239,9 +245,6 @@ static void stat_module( void * xmodule, void * data )
             module_stat( m->imported_modules, m->name, "imported modules" );
         }
     }
-
-    delete_module( m );
-    object_free( m->name );
 }
 
 static void print_class_stats( void * xstats, void * data )
@@ -249,6 +252,7 @@ static void print_class_stats( void * xstats, void * data )
     struct module_stats * stats = (struct module_stats *)xstats;
     class_module_stat( stats->rules_stats, stats->module_name, "rules" );
     class_module_stat( stats->variables_stats, stats->module_name, "variables" );
+    class_module_stat( stats->instance_variables_stats, stats->module_name, "instance variables" );
     class_module_stat( stats->variable_indices_stats, stats->module_name, "fixed variables" );
     class_module_stat( stats->imported_modules_stats, stats->module_name, "imported modules" );
 }
@@ -308,7 +312,15 @@ void import_module( LIST * module_names, module_t * target_module )
         OBJECT * const s = list_item( iter );
         OBJECT * * const ss = (OBJECT * *)hash_insert( h, s, &found );
         if ( !found )
+        {
             *ss = object_copy( s );
+            /* Rules found in the global module stay the same, as it is
+             * searched last. Which avoids invalidating the rule caches for
+             * every new class instance.
+             */
+            if ( target_module != root_module() )
+                rules_changed();
+        }
     }
 
     PROFILE_EXIT( IMPORT_MODULE );
@@ -15,6 +15,8 @@ typedef struct module_t module_t ;
 
 typedef module_t * module_ptr;
 
+struct _variable;
+
 struct module_t
 {
     OBJECT * name = nullptr;
@@ -22,6 +24,11 @@ struct module_t
     struct hash * variables = nullptr;
     struct hash * variable_indices = nullptr;
     int num_fixed_variables = 0;
+    /* The variables of a class instance that are not fixed variables of the
+     * class. Kept in a short array, instead of the variables hash, while there
+     * are few of them. */
+    int num_instance_variables = 0;
+    struct _variable * instance_variables = nullptr;
     LIST * * fixed_variables = nullptr;
     struct hash * imported_modules = nullptr;
     module_t * class_module = nullptr;
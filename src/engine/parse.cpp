@@ -19,11 +19,15 @@
 #include "modules.h"
 #include "frames.h"
 #include "function.h"
+#include "filesys.h"
 #include "mem.h"
+#include "mod_graph_snapshot.h"
 #include "startup.h"
 #include "rules.h"
 #include "search.h"
+#include "timestamp.h"
 
+#include <cstdio>
 #include <cstring>
 #include <set>
 #include <string>
@@ -42,6 +46,77 @@ static PARSE * yypsave;
 static std::set<PARSE*> parse_mem;
 
 
+/*
+ * The compiled Jamfile cache. With the --jam-cache option the function compiled
+ * from a parsed file is written next to it, to "<file>.b2c". And parsing the
+ * file again, in a later run, loads that function instead. The cache file
+ * starts with a key of the compiled function format, the engine build, the file
+ * name, and the modification time of the file. A cache file with a different
+ * key is ignored and replaced.
+ */
+
+static std::string jam_cache_key( OBJECT * f )
+{
+    timestamp time;
+    timestamp_from_path( &time, f );
+    if ( timestamp_empty( &time ) )
+        return std::string();
+    char mtime[ 64 ];
+    std::snprintf( mtime, sizeof( mtime ), "%lld.%09d",
+        (long long)time.secs, time.nsecs );
+    std::string key = "b2-jam-cache-2\n";
+    key += std::to_string( function_format_version ) + "\n";
+    key += b2::startup::engine_identity() + "\n";
+    key += object_str( f );
+    key += "\n";
+    key += mtime;
+    key += "\n";
+    return key;
+}
+
+static std::string jam_cache_file( OBJECT * f )
+{
+    return std::string( object_str( f ) ) + ".b2c";
+}
+
+static FUNCTION * jam_cache_load( OBJECT * f )
+{
+    std::string const key = jam_cache_key( f );
+    if ( key.empty() )
+        return nullptr;
+    FILE * in = std::fopen( jam_cache_file( f ).c_str(), "rb" );
+    if ( !in )
+        return nullptr;
+    std::string data;
+    char buf[ 4096 ];
+    for ( std::size_t n; ( n = std::fread( buf, 1, sizeof( buf ), in ) ) > 0; )
+        data.append( buf, n );
+    std::fclose( in );
+    if ( data.compare( 0, key.size(), key ) != 0 )
+        return nullptr;
+    char const * at = data.data() + key.size();
+    char const * end = data.data() + data.size();
+    FUNCTION * func = function_read( at, end );
+    if ( func && at != end )
+    {
+        function_free( func );
+        func = nullptr;
+    }
+    return func;
+}
+
+static void jam_cache_save( OBJECT * f, FUNCTION * func )
+{
+    std::string data = jam_cache_key( f );
+    if ( data.empty() )
+        return;
+    function_write( func, data );
+    b2::filesys::replace_file( jam_cache_file( f ), [&data]( FILE * out ) {
+        return std::fwrite( data.data(), 1, data.size(), out ) == data.size();
+    }, true );
+}
+
+
 struct parse_ptr
 {
     parse_ptr() : ptr( yypsave ) {}
@@ -52,7 +127,7 @@ struct parse_ptr
     PARSE * ptr = nullptr;
 };
 
-static void parse_impl( FRAME * frame )
+static void parse_impl( FRAME * frame, OBJECT * cache = nullptr )
 {
 
     /* Now parse each block of rules and execute it. Execute it outside of the
@@ -73,6 +148,11 @@ static void parse_impl( FRAME * frame )
         /* Compile the parse tree. */
         auto func = b2::jam::make_unique_bare_jptr( function_compile( p ), function_free );
 
+        /* A file parses to a single block. Hence it is the whole file to cache.
+         */
+        if ( cache )
+            jam_cache_save( cache, func.get() );
+
         /* Run the parsed function. */
         list_free( function_run( func.get(), frame ) );
     }
@@ -83,10 +163,25 @@ static void parse_impl( FRAME * frame )
 
 void parse_file( OBJECT * f, FRAME * frame )
 {
+    bool const cache = globs.jam_cache && std::strcmp( object_str( f ), "-" );
+    if ( std::strcmp( object_str( f ), "-" ) )
+        b2::graph_snapshot::input( f );
+    else
+        b2::graph_snapshot::disable_for( "stdin" );
+    if ( cache )
+    {
+        if ( FUNCTION * func = jam_cache_load( f ) )
+        {
+            list_free( function_run( func, frame ) );
+            function_free( func );
+            return;
+        }
+    }
+
     /* Suspend scan of current file and push this new file in the stream. */
     yyfparse( f );
 
-    parse_impl( frame );
+    parse_impl( frame, cache ? f : nullptr );
 }
 
 
@@ -103,6 +103,8 @@ void regerror(char const * message)
  *  reganch  is the match anchored (at beginning-of-line only)?
  *  regmust  string (pointer into program) that match must include, or NULL.
  *  regmlen  length of regmust string.
+ *  reglit   string (pointer into program) that match must include, or NULL.
+ *  regllen  length of reglit string.
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection of
@@ -110,7 +112,10 @@ void regerror(char const * message)
  * regcomp() supplies a regmust only if the r.e. contains something potentially
  * expensive (at present, the only such thing detected is * or + at the start of
  * the r.e., which can involve a lot of backup). Regmlen is supplied because the
- * test in regexec() needs it and regcomp() is computing it anyway.
+ * test in regexec() needs it and regcomp() is computing it anyway. Reglit is
+ * the same as regmust, but always supplied. It's for callers that can reject
+ * many strings at once, for example all the lines of a file, by searching for
+ * it (see program::required_literal()).
  */
 
 /*
@@ -241,6 +246,8 @@ struct regex_prog
 	char reganch = '\0'; /* Internal use only. */
 	const char * regmust = nullptr; /* Internal use only. */
 	int32_t regmlen = 0; /* Internal use only. */
+	const char * reglit = nullptr; /* Internal use only. */
+	int32_t regllen = 0; /* Internal use only. */
 	std::size_t progsize = 0; // The size of the program.
 	char program[1]; /* Unwarranted chumminess with compiler. */
 
@@ -324,6 +331,8 @@ struct compiler
 		r->reganch = '\0';
 		r->regmust = nullptr;
 		r->regmlen = 0;
+		r->reglit = nullptr;
+		r->regllen = 0;
 		scan = r->program + 1; /* First BRANCH. */
 		if (OP(regnext(scan)) == END)
 		{ /* Only one top-level choice. */
@@ -336,24 +345,30 @@ struct compiler
 				r->reganch++;
 
 			/*
-			 * If there's something expensive in the r.e., find the
-			 * longest literal string that must appear and make it the
-			 * regmust.  Resolve ties in favor of later strings, since
-			 * the regstart check works with the beginning of the r.e.
-			 * and avoiding duplication strengthens checking.  Not a
-			 * strong reason, but sufficient in the absence of others.
+			 * Find the longest literal string that must appear. Resolve ties
+			 * in favor of later strings, since the regstart check works with
+			 * the beginning of the r.e. and avoiding duplication strengthens
+			 * checking.  Not a strong reason, but sufficient in the absence
+			 * of others.
+			 */
+			longest = nullptr;
+			len = 0;
+			for (; scan != nullptr; scan = regnext(scan))
+				if (OP(scan) == EXACTLY
+					&& static_cast<int32_t>(std::strlen(OPERAND(scan))) >= len)
+				{
+					longest = OPERAND(scan);
+					len = static_cast<int32_t>(std::strlen(OPERAND(scan)));
+				}
+			r->reglit = longest;
+			r->regllen = len;
+
+			/*
+			 * If there's something expensive in the r.e., make the literal
+			 * string the regmust.
 			 */
 			if (flags & SPSTART)
 			{
-				longest = nullptr;
-				len = 0;
-				for (; scan != nullptr; scan = regnext(scan))
-					if (OP(scan) == EXACTLY
-						&& static_cast<int32_t>(std::strlen(OPERAND(scan))) >= len)
-					{
-						longest = OPERAND(scan);
-						len = static_cast<int32_t>(std::strlen(OPERAND(scan)));
-					}
 				r->regmust = longest;
 				r->regmlen = len;
 			}
@@ -1185,6 +1200,12 @@ regex_prog * program::compile(const char * pattern)
 
 program::program(const char * pattern) { reset(pattern); }
 
+string_view program::required_literal() const
+{
+	if (compiled == nullptr || compiled->reglit == nullptr) return {};
+	return string_view(compiled->reglit, compiled->regllen);
+}
+
 void program::reset(const char * pattern) { compiled = compile(pattern); }
 
 program::result_iterator::result_iterator(
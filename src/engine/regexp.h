@@ -46,6 +46,16 @@ struct program
 	result_iterator search(const char * str_begin, const char * str_end);
 	result_iterator search(const char * str_begin);
 
+	// A literal string that is part of all matches, or empty if there is none.
+	// Strings that do not contain it can not match.
+	string_view required_literal() const;
+
+	// Programs are shared by pattern, hence equal patterns are equal programs.
+	inline bool operator==(const program & o) const
+	{
+		return compiled == o.compiled;
+	}
+
 	private:
 	const regex_prog * compiled = nullptr;
 
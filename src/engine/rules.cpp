@@ -16,6 +16,7 @@
  *
  * External routines:
  *    bindrule()     - return pointer to RULE, creating it if necessary.
+ *    rules_changed() - invalidate the rule caches of bindrule().
  *    bindtarget()   - return pointer to TARGET, creating it if necessary.
  *    touch_target() - mark a target to simulate being new.
  *    targetlist()   - turn list of target names into a TARGET chain.
@@ -49,6 +50,11 @@ static void set_rule_body   ( rule_ptr, function_ptr );
 
 static struct hash * targethash = 0;
 
+/* Counts the changes to the rule tables that can change what a rule name
+ * finds, to invalidate the rule caches. Starts at 1 as 0 is the empty cache.
+ */
+static unsigned rules_epoch = 1;
+
 
 /*
  * get_target_includes() - lazy creates a target's internal includes node
@@ -113,6 +119,7 @@ static rule_ptr enter_rule( b2::value_ptr rulename, module_ptr target_module )
         r->actions = 0;
         r->exported = 0;
         r->module = b2::ensure_valid(target_module);
+        rules_changed();
     }
     return r;
 }
@@ -599,7 +606,11 @@ rule_ptr new_rule_body( module_ptr m, b2::value_ptr rulename, function_ptr proce
     int exported )
 {
     rule_ptr const local = define_rule( m, rulename, m );
-    local->exported = exported;
+    if ( local->exported != exported )
+    {
+        local->exported = exported;
+        rules_changed();
+    }
     set_rule_body( local, procedure );
 
     /* Mark the procedure with the global rule name, regardless of whether the
@@ -649,6 +660,22 @@ rule_ptr new_rule_actions( module_ptr m, b2::value_ptr rulename, function_ptr co
 }
 
 
+/*
+ * Lookup started in class module. We have found a rule in class module, which
+ * is marked for execution in that module, or in some instance. Mark it for
+ * execution in the instance where we started the lookup.
+ */
+
+static void execute_in_instance( rule_ptr r, module_ptr instance )
+{
+    module_ptr const m = instance->class_module;
+    int const execute_in_class = r->module == m;
+    int const execute_in_some_instance = r->module->class_module == m;
+    if ( execute_in_class || execute_in_some_instance )
+        r->module = instance;
+}
+
+
 /*
  * Looks for a rule in the specified module, and returns it, if found. First
  * checks if the rule is present in the module's rule table. Second, if the
@@ -697,18 +724,7 @@ rule_ptr lookup_rule( b2::value_ptr rulename, module_ptr m, bool local_only )
         if ( local_only && !result->exported )
             result = 0;
         else if ( original_module != m )
-        {
-            /* Lookup started in class module. We have found a rule in class
-             * module, which is marked for execution in that module, or in some
-             * instance. Mark it for execution in the instance where we started
-             * the lookup.
-             */
-            int const execute_in_class = result->module == m;
-            int const execute_in_some_instance =
-                result->module->class_module == m;
-            if ( execute_in_class || execute_in_some_instance )
-                result->module = original_module;
-        }
+            execute_in_instance( result, original_module );
     }
 
     return result;
@@ -737,6 +753,56 @@ rule_ptr bindrule( b2::value_ptr rulename, module_ptr m )
 }
 
 
+/*
+ * bindrule() - the same as bindrule() above, but only looks for the rule when
+ * the cache is not for the rule name, module, and current rules epoch. The
+ * instances of a class share the cache entries of the class. Class rules are
+ * shared by the instances, hence the instance to run in is set again for each
+ * call: the calling instance for the rules of its class, or the instance named
+ * by the rule name.
+ */
+
+rule_ptr bindrule( b2::value_ptr rulename, module_ptr m, rule_cache & cache )
+{
+    module_ptr const key = m->class_module ? m->class_module : m;
+    if ( cache.epoch == rules_epoch && cache.name == rulename
+        && cache.module == key )
+    {
+        if ( cache.in_class )
+            execute_in_instance( cache.rule, m );
+        else if ( cache.instance )
+            execute_in_instance( cache.rule, cache.instance );
+        return cache.rule;
+    }
+
+    rule_ptr result = lookup_rule( rulename, m, false );
+    bool const in_class = result && m->class_module && key->rules
+        && hash_find( key->rules, rulename );
+    if ( !result )
+        result = lookup_rule( rulename, root_module(), false );
+    if ( !result )
+        return enter_rule( rulename, m );
+
+    cache.name = rulename;
+    cache.module = key;
+    cache.rule = result;
+    cache.instance = result->module->class_module ? result->module : nullptr;
+    cache.epoch = rules_epoch;
+    cache.in_class = in_class;
+    return result;
+}
+
+
+/*
+ * rules_changed() - invalidate the rule caches.
+ */
+
+void rules_changed()
+{
+    ++rules_epoch;
+}
+
+
 rule_ptr import_rule( rule_ptr source, module_ptr m, b2::value_ptr name )
 {
     rule_ptr const dest = define_rule( source->module, name, m );
@@ -258,6 +258,9 @@ struct _target
 	            * stack.
 	            */
 	char * cmds; /* type-punned command list */
+	double path_weight; /* used by make1() to start the critical path
+	                     * first
+	                     */
 
 	char const * failed;
 };
@@ -275,9 +278,25 @@ void freesettings(settings_ptr);
 void actions_refer(rule_actions_ptr);
 void actions_free(rule_actions_ptr);
 
+/* RULE_CACHE - the rule a call site found last. It is valid as long as the
+ * rule tables do not change in ways that can change which rule is found, as
+ * counted by the rules epoch. Zero filled is empty.
+ */
+struct rule_cache
+{
+	b2::value_ptr name;
+	module_ptr module; /* the class module for class instances */
+	rule_ptr rule;
+	module_ptr instance; /* the named instance the rule runs in, if any */
+	unsigned epoch;
+	bool in_class; /* found in the class module, i.e. runs in the caller */
+};
+
 /* Rule related functions. */
 rule_ptr find_rule(b2::value_ptr rulename, module_ptr m);
 rule_ptr bindrule(b2::value_ptr rulename, module_ptr);
+rule_ptr bindrule(b2::value_ptr rulename, module_ptr, rule_cache & cache);
+void rules_changed();
 rule_ptr import_rule(rule_ptr source, module_ptr, b2::value_ptr name);
 void rule_localize(rule_ptr rule, module_ptr module);
 rule_ptr new_rule_body(
@@ -335,6 +354,13 @@ struct target_ref
 			target->settings, 0 /*VAR_SET*/, name_to_set, val_to_set.release());
 	}
 
+	void on_append(value_ref n, const list_ref & v)
+	{
+		list_ref val_to_append(v);
+		target->settings = addsettings(
+			target->settings, 1 /*VAR_APPEND*/, n, val_to_append.release());
+	}
+
 	private:
 	TARGET * target = nullptr;
 };
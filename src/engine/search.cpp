@@ -139,8 +139,8 @@ void set_explicit_binding( OBJECT * target, OBJECT * locate )
  * 'another_target'.
  */
 
-OBJECT * search( OBJECT * target, timestamp * const time,
-    OBJECT * * another_target, int const file )
+static OBJECT * search_bound( OBJECT * target, timestamp * const time,
+    OBJECT * * another_target, int const file, int const quiet )
 {
     PATHNAME f[ 1 ];
     LIST * varlist;
@@ -172,7 +172,7 @@ OBJECT * search( OBJECT * target, timestamp * const time,
 
         path_build( f, buf );
 
-        if ( is_debug_search() )
+        if ( !quiet && is_debug_search() )
             out_printf( "locate %s: %s\n", object_str( target ), buf->value );
 
         key = object_new( buf->value );
@@ -198,7 +198,7 @@ OBJECT * search( OBJECT * target, timestamp * const time,
             string_truncate( buf, 0 );
             path_build( f, buf );
 
-            if ( is_debug_search() )
+            if ( !quiet && is_debug_search() )
                 out_printf( "search %s: %s\n", object_str( target ), buf->value );
 
             test_path = object_new( buf->value );
@@ -209,7 +209,7 @@ OBJECT * search( OBJECT * target, timestamp * const time,
 
             if ( ( ba = (BINDING *)hash_find( explicit_bindings, key ) ) )
             {
-                if ( is_debug_search() )
+                if ( !quiet && is_debug_search() )
                     out_printf(" search %s: found explicitly located target %s\n",
                         object_str( target ), object_str( ba->target ) );
                 if ( another_target )
@@ -245,7 +245,7 @@ OBJECT * search( OBJECT * target, timestamp * const time,
         string_truncate( buf, 0 );
         path_build( f, buf );
 
-        if ( is_debug_search() )
+        if ( !quiet && is_debug_search() )
             out_printf( "search %s: %s\n", object_str( target ), buf->value );
 
         key = object_new( buf->value );
@@ -256,6 +256,15 @@ OBJECT * search( OBJECT * target, timestamp * const time,
     boundname = object_new( buf->value );
     string_free( buf );
 
+    return boundname;
+}
+
+OBJECT * search( OBJECT * target, timestamp * const time,
+    OBJECT * * another_target, int const file )
+{
+    OBJECT * const boundname = search_bound( target, time, another_target,
+        file, 0 );
+
     /* Prepare a call to BINDRULE if the variable is set. */
     call_bind_rule( target, boundname );
 
@@ -263,6 +272,70 @@ OBJECT * search( OBJECT * target, timestamp * const time,
 }
 
 
+/*
+ * search_probe() - find where search() would bind the target, given the
+ * current settings, without reporting it or calling BINDRULE. Used to look
+ * ahead at targets before they get bound.
+ */
+
+OBJECT * search_probe( OBJECT * target, timestamp * const time,
+    int const file )
+{
+    return search_bound( target, time, 0, file, 1 );
+}
+
+
+/*
+ * search_path() - the n-th path search() looks at to bind the target, given
+ * the current settings, when not found at the ones before it. Or 0 after the
+ * last one. For querying them ahead of the binding.
+ */
+
+OBJECT * search_path( OBJECT * target, int32_t n )
+{
+    PATHNAME f[ 1 ];
+    string buf[ 1 ];
+    OBJECT * result;
+    LIST * const locate = var_get( root_module(), constant_LOCATE );
+    LIST * const roots = var_get( root_module(), constant_SEARCH );
+
+    path_parse( object_str( target ), f );
+
+    f->f_grist.ptr = 0;
+    f->f_grist.len = 0;
+
+    /* Only the first LOCATE is looked at. Otherwise each SEARCH root, and then
+     * the obvious place.
+     */
+    if ( !list_empty( locate ) )
+    {
+        if ( n > 0 )
+            return 0;
+        f->f_root.ptr = object_str( list_front( locate ) );
+        f->f_root.len = int32_t( strlen( f->f_root.ptr ) );
+    }
+    else if ( n < list_length( roots ) )
+    {
+        OBJECT * const root = list_item( list_begin( roots ) + n );
+        f->f_root.ptr = object_str( root );
+        f->f_root.len = int32_t( strlen( f->f_root.ptr ) );
+    }
+    else if ( n == list_length( roots ) )
+    {
+        f->f_root.ptr = 0;
+        f->f_root.len = 0;
+    }
+    else
+        return 0;
+
+    string_new( buf );
+    path_build( f, buf );
+    result = object_new( buf->value );
+    string_free( buf );
+    return result;
+}
+
+
 static void free_binding( void * xbinding, void * data )
 {
     object_free( ( (BINDING *)xbinding )->binding );
@@ -17,6 +17,9 @@
 void set_explicit_binding( OBJECT * target, OBJECT * locate );
 OBJECT * search( OBJECT * target, timestamp * const time,
     OBJECT * * another_target, int const file );
+OBJECT * search_probe( OBJECT * target, timestamp * const time,
+    int const file );
+OBJECT * search_path( OBJECT * target, int32_t n );
 void search_done( void );
 
 #endif
@@ -17,15 +17,20 @@ Distributed under the Boost Software License, Version 1.0.
 #include "output.h"
 #include "parse.h"
 #include "pathsys.h"
+#include "patchlevel.h"
 #include "rules.h"
+#include "timestamp.h"
 #include "value.h"
 #include "variable.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 #include <vector>
 
+extern char const * saved_argv0;
+
 namespace {
 void bind_builtin(char const * name_,
 	LIST * (*f)(FRAME *, int flags),
@@ -49,6 +54,33 @@ void b2::startup::load_builtins()
 	}
 }
 
+const std::string & b2::startup::engine_identity()
+{
+	static const std::string identity = []() {
+		std::string result = std::to_string(VERSION_MAJOR) + "."
+			+ std::to_string(VERSION_MINOR) + "." + std::to_string(VERSION_PATCH);
+		char * exe = executable_path(saved_argv0);
+		if (!exe) return result;
+		result += " ";
+		result += exe;
+		long size = -1;
+		if (FILE * f = std::fopen(exe, "rb"))
+		{
+			if (std::fseek(f, 0, SEEK_END) == 0) size = std::ftell(f);
+			std::fclose(f);
+		}
+		timestamp time;
+		b2::value_ref exe_path(exe);
+		timestamp_from_path(&time, exe_path);
+		std::free(exe);
+		char state[64];
+		std::snprintf(state, sizeof(state), " %ld %lld.%09d", size,
+			(long long)time.secs, time.nsecs);
+		return result + state;
+	}();
+	return identity;
+}
+
 LIST * b2::startup::builtin_boost_build(FRAME * frame, int flags)
 {
 	// Do nothing, but keep the rule, for backwards compatability.
@@ -57,7 +89,6 @@ LIST * b2::startup::builtin_boost_build(FRAME * frame, int flags)
 	return L0;
 }
 
-extern char const * saved_argv0;
 
 void bootstrap_dirscan(
 	void * dirs, OBJECT * path, int found, timestamp const * const)
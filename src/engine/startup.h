@@ -11,12 +11,16 @@ Distributed under the Boost Software License, Version 1.0.
 #include "jam_fwd.h"
 
 #include <cstdlib>
+#include <string>
 
 namespace b2 {
 namespace startup {
     void load_builtins();
     LIST* builtin_boost_build(FRAME* frame, int flags);
     bool bootstrap(FRAME* frame);
+    // Identifies the running engine build, for the caches of its results. The
+    // version, and the path, size, and modification time of the executable.
+    const std::string & engine_identity();
 }
 
 enum class exit_result : int {
@@ -23,52 +23,6 @@ Distributed under the Boost Software License, Version 1.0.
 
 namespace b2 { namespace task {
 
-struct sync
-{
-	inline sync();
-	inline void wait();
-	inline bool signal();
-
-#if B2_USE_STD_THREADS
-	std::mutex arrived_mx;
-	std::condition_variable arrived_cv;
-	std::atomic_bool wait_arrived;
-	std::atomic_bool signal_arrived;
-#endif
-};
-
-inline sync::sync()
-{
-#if B2_USE_STD_THREADS
-	wait_arrived = false;
-	signal_arrived = false;
-#endif
-}
-
-inline void sync::wait()
-{
-#if B2_USE_STD_THREADS
-	// Indicate that we waiting.
-	wait_arrived = true;
-	// Wait for the signal that we can proceed.
-	std::unique_lock<std::mutex> lock(arrived_mx);
-	arrived_cv.wait(lock, [this]() { return signal_arrived.load(); });
-#endif
-}
-
-inline bool sync::signal()
-{
-#if B2_USE_STD_THREADS
-	// Wait for wait() to get called.
-	if (!wait_arrived.load()) return false;
-	// Tell the waiter that we arrived.
-	std::unique_lock<std::mutex> lock(arrived_mx);
-	signal_arrived = true;
-	arrived_cv.notify_one();
-#endif
-	return true;
-}
-
 /*
 A group of tasks that run in parallel within a limit of parallelism. The
 parallelism limit is enforced by only dequeuing calls when possible.
@@ -82,8 +36,14 @@ struct group::implementation
 	unsigned stat_max_running = 0;
 	unsigned stat_total = 0;
 	unsigned stat_max_pending = 0;
+	// Number of queued calls that have not completed. As opposed to waiting
+	// for a single completion this allows reusing the group, i.e. queueing
+	// more calls after a wait.
+	unsigned outstanding = 0;
 	mutex_t mx;
-	sync finished;
+#if B2_USE_STD_THREADS
+	std::condition_variable finished_cv;
+#endif
 
 	inline implementation(executor & e, unsigned p)
 		: exec(e)
@@ -166,21 +126,18 @@ inline void group::implementation::call_queue(std::function<void()> f)
 			stat_total += 1;
 		}
 		f();
-		bool signal_finished = false;
 		{
 			scope_lock_t lock(mx);
 			running -= 1;
-			signal_finished = pending.empty() && running == 0;
-		}
-		if (signal_finished)
-		{
-			// Re-try the signal until it happens indicating that the waiting
-			// task is expecting it.
-			while (!finished.signal()) ;
+			outstanding -= 1;
+#if B2_USE_STD_THREADS
+			if (outstanding == 0) finished_cv.notify_all();
+#endif
 		}
 	};
 	{
 		scope_lock_t lock(mx);
+		outstanding += 1;
 		pending.push(std::move(the_call));
 		stat_max_pending = std::max(unsigned(pending.size()), stat_max_pending);
 	}
@@ -212,7 +169,10 @@ inline void group::implementation::wait()
 	// Signal the tasks that we are waiting for completion.
 	exec.i->call_signal();
 	// Wait for completion of the group tasks.
-	finished.wait();
+#if B2_USE_STD_THREADS
+	scope_lock_t lock(mx);
+	finished_cv.wait(lock, [this]() { return outstanding == 0; });
+#endif
 }
 
 inline executor::implementation::implementation(unsigned parallelism)
@@ -370,6 +330,8 @@ std::shared_ptr<group> executor::make(int parallelism)
 	return result;
 }
 
+unsigned executor::parallelism() { return unsigned(i->runners.size()); }
+
 executor & executor::get()
 {
 	static executor e;
@@ -66,6 +66,9 @@ class executor
 	// Create a task group.
 	std::shared_ptr<group> make(int parallelism = -1);
 
+	// The number of tasks that can run at the same time.
+	unsigned parallelism();
+
 	private:
 	struct implementation;
 	std::shared_ptr<implementation> i;
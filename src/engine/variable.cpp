@@ -22,10 +22,12 @@
  *  var_get()     - get value of a user defined symbol
  *  var_set()     - set a variable in jam's user defined symbol table.
  *  var_swap()    - swap a variable's value with the given one
+ *  var_names()   - list the names of the variables of a module
  *  var_done()    - free variable tables
  *
  * Internal routines:
  *
+ *  var_find()  - find the var symbol table entry, if any
  *  var_enter() - make new var symbol table entry, returning var ptr
  *  var_dump()  - dump a variable to stdout
  */
@@ -59,6 +61,14 @@ struct _variable
     LIST   * value;
 };
 
+/*
+ * The most variables of a class instance kept in its short array. Instances
+ * with more are moved to the variables hash.
+ */
+
+#define MAX_INSTANCE_VARIABLES 8
+
+static VARIABLE * var_find( struct module_t *, OBJECT * symbol );
 static LIST * * var_enter( struct module_t *, OBJECT * symbol );
 static void var_dump( OBJECT * symbol, LIST * value, const char * what );
 
@@ -191,8 +201,7 @@ LIST * var_get( struct module_t * module, OBJECT * symbol )
                 var_dump( symbol, module->fixed_variables[ n ], "get" );
             result = module->fixed_variables[ n ];
         }
-        else if ( module->variables && ( v = (VARIABLE *)hash_find(
-            module->variables, symbol ) ) )
+        else if ( ( v = var_find( module, symbol ) ) )
         {
             if ( is_debug_varget() )
                 var_dump( v->symbol, v->value, "get" );
@@ -235,8 +244,7 @@ LIST * var_get( struct module_t * module, OBJECT * symbol )
                 var_defines( environ_module, environ, 0 );
                 string_free( buf );
 
-                if ( module->variables && ( v = (VARIABLE *)hash_find(
-                    module->variables, symbol ) ) )
+                if ( ( v = var_find( module, symbol ) ) )
                 {
                     if ( is_debug_varget() )
                         var_dump( v->symbol, v->value, "get" );
@@ -255,8 +263,7 @@ LIST * var_get_and_clear_raw( module_t * module, OBJECT * symbol )
     LIST * result = L0;
     VARIABLE * v;
 
-    if ( module->variables && ( v = (VARIABLE *)hash_find( module->variables,
-        symbol ) ) )
+    if ( ( v = var_find( module, symbol ) ) )
     {
         result = v->value;
         v->value = L0;
@@ -320,6 +327,24 @@ LIST * var_swap( struct module_t * module, OBJECT * symbol, LIST * value )
 }
 
 
+/*
+ * var_find() - find the var symbol table entry, if any
+ */
+
+static VARIABLE * var_find( struct module_t * module, OBJECT * symbol )
+{
+    int i;
+
+    for ( i = 0; i < module->num_instance_variables; ++i )
+        if ( object_equal( module->instance_variables[ i ].symbol, symbol ) )
+            return &module->instance_variables[ i ];
+
+    return module->variables
+        ? (VARIABLE *)hash_find( module->variables, symbol )
+        : 0;
+}
+
+
 /*
  * var_enter() - make new var symbol table entry, returning var ptr
  */
@@ -333,6 +358,40 @@ static LIST * * var_enter( struct module_t * module, OBJECT * symbol )
     if ( ( n = module_get_fixed_var( module, symbol ) ) != -1 )
         return &module->fixed_variables[ n ];
 
+    if ( module->class_module && !module->variables )
+    {
+        VARIABLE * const vars = module->instance_variables;
+        for ( n = 0; n < module->num_instance_variables; ++n )
+            if ( object_equal( vars[ n ].symbol, symbol ) )
+                return &vars[ n ].value;
+
+        if ( n < MAX_INSTANCE_VARIABLES )
+        {
+            /* The array grows to each power of two. */
+            if ( ( n & ( n - 1 ) ) == 0 )
+                module->instance_variables = (VARIABLE *)BJAM_REALLOC(
+                    module->instance_variables, ( n ? n * 2 : 1 ) * sizeof(
+                    VARIABLE ) );
+            v = &module->instance_variables[ n ];
+            v->symbol = object_copy( symbol );
+            v->value = L0;
+            module->num_instance_variables = n + 1;
+            return &v->value;
+        }
+
+        /* Too many for the array, move them to the hash. */
+        module->variables = hashinit( sizeof( VARIABLE ), "variables" );
+        for ( n = 0; n < module->num_instance_variables; ++n )
+        {
+            v = (VARIABLE *)hash_insert( module->variables,
+                module->instance_variables[ n ].symbol, &found );
+            *v = module->instance_variables[ n ];
+        }
+        BJAM_FREE( module->instance_variables );
+        module->instance_variables = 0;
+        module->num_instance_variables = 0;
+    }
+
     if ( !module->variables )
         module->variables = hashinit( sizeof( VARIABLE ), "variables" );
 
@@ -370,10 +429,60 @@ static void delete_var_( void * xvar, void * data )
     list_free( v->value );
 }
 
+/*
+ * var_names() - list the names of the variables of a module
+ */
+
+static void add_var_name_( void * xvar, void * data )
+{
+    LIST * * result = (LIST * *)data;
+    *result = list_push_back( *result, object_copy( ( (VARIABLE *)xvar
+        )->symbol ) );
+}
+
+LIST * var_names( struct module_t * module )
+{
+    LIST * result = L0;
+    int i;
+    for ( i = 0; i < module->num_instance_variables; ++i )
+        add_var_name_( &module->instance_variables[ i ], &result );
+    if ( module->variables )
+        hashenumerate( module->variables, add_var_name_, &result );
+    return result;
+}
+
+/*
+ * var_instance_stats() - add the short array of instance variables, not in the
+ * variables hash, to the memory stats of the module.
+ */
+
+void var_instance_stats( struct module_t * module, struct hashstats * stats )
+{
+    int const n = module->num_instance_variables;
+    int capacity = 1;
+    if ( n == 0 )
+        return;
+    /* The array grows to each power of two. */
+    while ( capacity < n )
+        capacity *= 2;
+    stats->count += n;
+    stats->num_items += capacity;
+    stats->item_size = sizeof( VARIABLE );
+}
+
 void var_done( struct module_t * module )
 {
+    int i;
     list_free( saved_var );
     saved_var = L0;
-    hashenumerate( module->variables, delete_var_, 0 );
-    hash_free( module->variables );
+    for ( i = 0; i < module->num_instance_variables; ++i )
+        delete_var_( &module->instance_variables[ i ], 0 );
+    BJAM_FREE( module->instance_variables );
+    module->instance_variables = 0;
+    module->num_instance_variables = 0;
+    if ( module->variables )
+    {
+        hashenumerate( module->variables, delete_var_, 0 );
+        hash_free( module->variables );
+    }
 }
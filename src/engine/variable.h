@@ -24,10 +24,14 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include <string>
 
+struct hashstats;
+
 void var_defines(struct module_t *, const char * const * e, int preprocess);
 LIST * var_get(struct module_t *, OBJECT * symbol);
 void var_set(struct module_t *, OBJECT * symbol, LIST * value, int flag);
 LIST * var_swap(struct module_t *, OBJECT * symbol, LIST * value);
+LIST * var_names(struct module_t *);
+void var_instance_stats(struct module_t *, struct hashstats *);
 void var_done(struct module_t *);
 
 /*
@@ -13,6 +13,7 @@ file LICENSE.txt or copy at https://www.bfgroup.xyz/b2/LICENSE.txt)
 # include "parse.h"
 # include "frames.h"
 # include "jam_strings.h"
+# include "mod_graph_snapshot.h"
 
 # define WIN32_LEAN_AND_MEAN
 # include <windows.h>
@@ -63,6 +64,8 @@ LIST * builtin_system_registry( FRAME * frame, int flags )
     LIST* result = L0;
     HKEY key = get_key(&path);
 
+    b2::graph_snapshot::disable_for( "registry" );
+
     if (
         key != 0
         && ERROR_SUCCESS == RegOpenKeyExA(key, path, 0, KEY_QUERY_VALUE, &key)
@@ -190,6 +193,8 @@ LIST * builtin_system_registry_names( FRAME * frame, int flags )
 
     HKEY key = get_key(&path);
 
+    b2::graph_snapshot::disable_for( "registry" );
+
     if ( !strcmp(result_type, "subkeys") )
         return get_subkey_names(key, path);
     if ( !strcmp(result_type, "values") )
@@ -302,6 +302,146 @@ obj foo : foo.cpp :
     t.expect_nothing_more()
     t.cleanup()
 
+def test_batch():
+    """Tests building the checks of a project together with --configure-batch"""
+    t = BoostBuild.Tester(use_test_config=0)
+    t.write("Jamroot", """
+import configure ;
+obj pass : pass.cpp ;
+obj fail : fail.cpp ;
+obj pass2 : pass.cpp ;
+explicit pass fail pass2 ;
+obj foo : foo.cpp :
+  [ configure.check-target-builds pass : <define>PASS : <define>FAIL ] ;
+obj bar : foo.cpp :
+  [ configure.check-target-builds fail : <define>FAIL : <define>PASS ] ;
+obj baz : foo.cpp :
+  [ configure.choose "which one?" : fail <define>FAIL : pass2 <define>PASS ] ;
+""")
+    t.write("pass.cpp", "void f() {}\n")
+    t.write("fail.cpp", "#error fail.cpp\n")
+    t.write("foo.cpp", """
+#ifndef PASS
+#error PASS not defined
+#endif
+#ifdef FAIL
+#error FAIL is defined
+#endif
+""")
+    t.run_build_system(["--configure-batch", "-j4"])
+    t.expect_output_lines([
+        "    - pass builds              : yes*",
+        "    - fail builds              : no*",
+        "    - which one?               : pass2*"])
+    t.expect_addition("bin/$toolset/debug*/pass.obj")
+    t.expect_addition("bin/$toolset/debug*/pass2.obj")
+    t.expect_addition("bin/$toolset/debug*/foo.obj")
+    t.expect_addition("bin/$toolset/debug*/bar.obj")
+    t.expect_addition("bin/$toolset/debug*/baz.obj")
+    t.expect_addition("bin/config.log")
+    t.expect_addition("bin/project-cache.jam")
+    t.expect_nothing_more()
+    # The checks were built in one update, followed by the one that writes the
+    # cache. Instead of one update for each check.
+    updates = [l for l in t.read("bin/config.log").splitlines()
+        if l.startswith("...updating ")]
+    t.fail_test(len(updates) != 2)
+
+    # An up-to-date build should use the cache
+    t.run_build_system(["--configure-batch", "-j4"])
+    t.expect_output_lines([
+        "    - pass builds              : yes (cached)*",
+        "    - fail builds              : no  (cached)*",
+        "    - which one?               : pass2 (cached)*"])
+    t.expect_nothing_more()
+
+    # --reconfigure should re-run configuration checks only
+    t.run_build_system(["--configure-batch", "-j4", "--reconfigure"])
+    t.expect_output_lines([
+        "    - pass builds              : yes*",
+        "    - fail builds              : no*",
+        "    - which one?               : pass2*"])
+    t.expect_touch("bin/$toolset/debug*/pass.obj")
+    t.expect_touch("bin/$toolset/debug*/pass2.obj")
+    t.expect_nothing_more()
+
+    t.cleanup()
+
+def test_batch_other_project():
+    """Tests batching the checks declared in one project, and evaluated in
+    another, with --configure-batch"""
+    t = BoostBuild.Tester(use_test_config=0)
+    t.write("Jamroot", """
+import configure ;
+project root ;
+obj pass : pass.cpp ;
+obj fail : fail.cpp ;
+explicit pass fail ;
+constant CHECKS :
+  [ configure.check-target-builds /root//pass : <define>PASS : <define>FAIL ]
+  [ configure.check-target-builds /root//fail : <define>FAIL : <define>OK ] ;
+build-project sub ;
+""")
+    t.write("sub/Jamfile", """
+obj foo : foo.cpp : $(CHECKS) ;
+""")
+    t.write("pass.cpp", "void f() {}\n")
+    t.write("fail.cpp", "#error fail.cpp\n")
+    t.write("sub/foo.cpp", """
+#if !defined(PASS) || !defined(OK)
+#error PASS or OK not defined
+#endif
+""")
+    t.run_build_system(["--configure-batch", "-j4"])
+    t.expect_output_lines([
+        "    - pass builds              : yes*",
+        "    - fail builds              : no*"])
+    t.expect_addition("bin/$toolset/debug*/pass.obj")
+    t.expect_addition("sub/bin/$toolset/debug*/foo.obj")
+    t.expect_addition("bin/config.log")
+    t.expect_addition("bin/project-cache.jam")
+    t.expect_nothing_more()
+    updates = [l for l in t.read("bin/config.log").splitlines()
+        if l.startswith("...updating ")]
+    t.fail_test(len(updates) != 2)
+    t.cleanup()
+
+def test_batch_ac():
+    """Tests building the tests of an ac library search together with
+    --configure-batch"""
+    t = BoostBuild.Tester(use_test_config=0)
+    t.write("Jamroot", """
+import ac ;
+import "class" : new ;
+import project ;
+import property-set ;
+import targets ;
+local mt = [ new ac-library mylib : [ project.current ]
+    : [ property-set.empty ] : : lib ] ;
+$(mt).set-header stdio.h ;
+$(mt).set-default-names b2-no-such-lib mylib ;
+targets.main-target-alternative $(mt) ;
+exe main : main.cpp mylib ;
+""")
+    t.write("main.cpp", """int mylib();
+int main() { return mylib(); }
+""")
+    t.write("impl/jamroot.jam", """
+lib mylib : mylib.cpp : <link>static ;
+install lib : mylib : <location>../lib ;
+""")
+    t.write("impl/mylib.cpp", "int mylib() { return 0; }\n")
+    t.run_build_system(subdir="impl")
+    t.run_build_system(["--configure-batch", "-j4"])
+    t.expect_output_lines("    - mylib                    : yes*")
+    t.expect_addition("bin/$toolset/debug*/main.exe")
+    updates = [l for l in t.read("bin/config.log").splitlines()
+        if l.startswith("...updating ")]
+    # The header and library tests were built in one update, followed by the one
+    # that writes the cache.
+    t.fail_test(len(updates) != 2)
+    t.cleanup()
+
 
 test_check_empty_config()
 test_check_target_builds()
@@ -309,3 +449,6 @@ test_build_no_short_circuits()
 test_choose()
 test_translation()
 test_choose_none()
+test_batch()
+test_batch_other_project()
+test_batch_ac()
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test restoring action outputs from the --action-cache.
+
+import BoostBuild
+
+t = BoostBuild.Tester(["-d1"], pass_toolset=0)
+
+t.write("file.jam", """\
+if $(NT)
+{
+    actions make-copy
+    {
+        echo running
+        type "$(>)" > "$(<)"
+    }
+}
+else
+{
+    actions make-copy
+    {
+        echo running
+        cat "$(>)" > "$(<)"
+    }
+}
+
+rule make-copy
+{
+    DEPENDS $(<) : $(>) ;
+}
+
+make-copy output.txt : input.txt ;
+DEPENDS all : output.txt ;
+""")
+
+t.write("input.txt", "first\n")
+
+# Cold cache, the action runs and the output is recorded.
+t.run_build_system(["-ffile.jam", "--action-cache=cache"])
+t.expect_output_lines("running")
+t.expect_addition("output.txt")
+t.expect_content("output.txt", "first\n")
+
+# Removing the output restores it from the cache without running the action.
+t.rm("output.txt")
+t.run_build_system(["-ffile.jam", "--action-cache=cache"])
+t.expect_output_lines("running", False)
+t.expect_output_lines("...action cache: 1 restored, 0 stored...")
+t.expect_addition("output.txt")
+t.expect_content("output.txt", "first\n")
+
+# Changing the input content runs the action again.
+t.rm("output.txt")
+t.write("input.txt", "second\n")
+t.run_build_system(["-ffile.jam", "--action-cache=cache"])
+t.expect_output_lines("running")
+t.expect_content("output.txt", "second\n")
+
+# Without the cache option the action always runs.
+t.rm("output.txt")
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("running")
+t.expect_content("output.txt", "second\n")
+
+t.cleanup()
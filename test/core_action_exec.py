@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test running simple action commands directly, and others with the shell.
+
+import BoostBuild
+import sys
+
+t = BoostBuild.Tester(["-d1", "-d+4"], pass_toolset=0)
+
+if sys.platform == "win32":
+    t.cleanup()
+    sys.exit(0)
+
+t.write("file.jam", """\
+actions simple
+{
+    %s -c "print('simple' + ' command')"
+}
+
+actions shell
+{
+    echo "shell $HOME" | cat
+}
+
+actions missing
+{
+    no-such-program-for-b2-test 'arg'
+}
+
+NOTFILE a b c ;
+ALWAYS a b c ;
+simple a ;
+shell b ;
+missing c ;
+DEPENDS all : a b c ;
+""" % sys.executable)
+
+t.run_build_system(["-ffile.jam"], status=1)
+t.expect_output_lines("Using no shell:")
+t.expect_output_lines("*= 'print(*")
+t.expect_output_lines("simple command")
+t.expect_output_lines("*= '/bin/sh'")
+t.expect_output_lines("shell *")
+t.expect_output_lines("*no-such-program-for-b2-test*not found*")
+t.expect_output_lines("...failed missing c...")
+
+t.cleanup()
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test skipping builds with nothing to update with "--graph-snapshot".
+
+import BoostBuild
+import os
+import sys
+import time
+
+t = BoostBuild.Tester(["-ffile.jam", "--graph-snapshot=snap.txt"],
+    pass_toolset=0)
+
+if sys.platform == "win32":
+    t.cleanup()
+    sys.exit(0)
+
+t.write("file.jam", """\
+ECHO "loaded" [ SHELL "cat probe.txt" : strip-eol ] ;
+ECHO "found" [ GLOB . : *.in ] ;
+
+actions copy
+{
+    cp $(>) $(<)
+}
+
+DEPENDS all : out.txt ;
+DEPENDS out.txt : in.txt ;
+copy out.txt : in.txt ;
+""")
+t.write("in.txt", "in\n")
+t.write("probe.txt", "one\n")
+
+# Builds that update targets don't write the snapshot.
+t.run_build_system()
+t.expect_output_lines("loaded one")
+t.expect_output_lines("...updated 1 target...")
+t.expect_addition("out.txt")
+t.expect_nothing_more()
+
+# Only the ones with nothing to update.
+t.run_build_system()
+t.expect_output_lines("loaded one")
+t.expect_output_lines("...found 3 targets...")
+t.expect_addition("snap.txt")
+t.expect_content_lines("snap.txt", "b2-graph-snapshot-1")
+
+# That the following builds use, without loading the Jamfile.
+t.run_build_system(stdout="...found 3 targets...\n")
+t.expect_nothing_more()
+
+# Changing a source updates the targets, and removes the snapshot.
+t.touch("in.txt")
+t.run_build_system()
+t.expect_output_lines("loaded one")
+t.expect_output_lines("...updated 1 target...")
+t.expect_removal("snap.txt")
+t.run_build_system()
+t.expect_output_lines("loaded one")
+t.run_build_system(stdout="...found 3 targets...\n")
+
+# Changing the output of SHELL commands loads the Jamfile.
+t.write("probe.txt", "two\n")
+t.run_build_system()
+t.expect_output_lines("loaded two")
+t.run_build_system(stdout="...found 3 targets...\n")
+
+# As does adding files to the directories the build listed.
+t.write("extra.in", "extra\n")
+t.run_build_system()
+t.expect_output_lines("found ./extra.in")
+t.run_build_system(stdout="...found 3 targets...\n")
+
+# Or changing the arguments.
+t.run_build_system(["-sX=1"])
+t.expect_output_lines("loaded two")
+
+# Inputs modified after the build started, here with a time in the future, are
+# not trusted. The snapshot is not written, and an existing one is removed.
+t.run_build_system()
+t.run_build_system(stdout="...found 3 targets...\n")
+future = time.time() + 2
+os.utime(t.native_file_name("file.jam"), (future, future))
+t.run_build_system()
+t.expect_output_lines("loaded two")
+t.expect_removal("snap.txt")
+t.expect_nothing_more()
+
+# Until a build that starts after that time.
+t.run_build_system()
+t.expect_output_lines("loaded two")
+t.expect_addition("snap.txt")
+t.run_build_system(stdout="...found 3 targets...\n")
+
+# But the files the build writes itself are only checked to exist.
+t.write("file.jam", """\
+ECHO "loaded" ;
+FILE_OPEN log.txt : "w" ;
+DEPENDS all : log.txt ;
+""")
+t.run_build_system()
+t.expect_output_lines("loaded")
+t.expect_modification("snap.txt")
+t.expect_content_lines("snap.txt", "file*log.txt\tf[*]")
+t.run_build_system(stdout="...found 2 targets...\n")
+
+t.cleanup()
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test reading and writing of the HCACHEFILE header cache.
+
+import BoostBuild
+
+t = BoostBuild.Tester(["-d+6"], pass_toolset=0)
+
+t.write("file.jam", """\
+HCACHEFILE = cache.jamdeps ;
+
+rule hdrrule ( target : headers * : * )
+{
+    ECHO "found:" $(target) ":" $(headers) ;
+    NOCARE $(headers) ;
+    INCLUDES $(target) : $(headers) ;
+}
+
+rule source ( name )
+{
+    HDRSCAN on $(name) = "#include \\"([^\\"]*)\\"" ;
+    HDRRULE on $(name) = hdrrule ;
+    DEPENDS all : $(name) ;
+}
+
+source a.cpp ;
+source b.cpp ;
+""")
+
+t.write("a.cpp", '#include "a.h"\n#include "c.h"\n')
+t.write("b.cpp", '#include "b.h"\n')
+
+# Initial scan writes the cache.
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("found: a.cpp : a.h c.h")
+t.expect_output_lines("found: b.cpp : b.h")
+t.expect_output_lines("using header cache for *", False)
+t.expect_output_lines("hcache written to *   2 dependencies, 0% hit rate")
+t.expect_addition("cache.jamdeps")
+
+# Second scan reads the results from the cache.
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("hcache read from file *")
+t.expect_output_lines("using header cache for a.cpp")
+t.expect_output_lines("using header cache for b.cpp")
+t.expect_output_lines("found: a.cpp : a.h c.h")
+t.expect_output_lines("found: b.cpp : b.h")
+t.expect_output_lines("hcache written to *   2 dependencies, 100% hit rate")
+
+# Changed sources are rescanned, and unchanged ones still come from the cache.
+t.write("a.cpp", '#include "d.h"\n')
+t.touch("a.cpp")
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("header cache out of date for a.cpp")
+t.expect_output_lines("using header cache for b.cpp")
+t.expect_output_lines("found: a.cpp : d.h")
+t.expect_output_lines("found: b.cpp : b.h")
+
+# Entries not looked at are kept in the cache.
+t.write("file.jam", t.read("file.jam").replace("source b.cpp ;", ""))
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("hcache written to *   2 dependencies, 100% hit rate")
+
+# An invalid cache file is ignored and rewritten.
+t.write("cache.jamdeps", "garbage")
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("found: a.cpp : d.h")
+t.expect_output_lines("hcache written to *   1 dependencies, 0% hit rate")
+
+t.cleanup()
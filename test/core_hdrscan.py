@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test the matching of HDRSCAN regular expressions to the lines of files.
+
+import BoostBuild
+
+t = BoostBuild.Tester(["-d0"], pass_toolset=0)
+
+t.write("file.jam", """\
+rule hdrrule ( target : headers * : * )
+{
+    ECHO "found:" $(target) ":" $(headers) ;
+}
+
+rule source ( name : patterns + )
+{
+    HDRSCAN on $(name) = $(patterns) ;
+    HDRRULE on $(name) = hdrrule ;
+    DEPENDS all : $(name) ;
+}
+
+source a.cpp : "^[ \t]*#[ \t]*include[ \t]*[<\\"]([^\\">]*)[\\">]" ;
+source b.cpp : "#[ \t]*include[ \t]*<(.*)>" "#[ \t]*import[ \t]*\\"(.*)\\"" ;
+source c.cpp : "([a-z]+)[.]h" ;
+source d.cpp : "#include \\"(.*)\\"" ;
+source e.cpp : "#include \\"(.*)\\"" ;
+""")
+
+t.write("a.cpp", """\
+int x;
+#include <a1.h>
+  #  include "a2.h"
+// #include "a3.h"
+int y;
+#include "a4.h"
+""")
+t.write("b.cpp", '#include <b1.h>\n#import "b2.h"\n\n#import "b3.h"\n')
+t.write("c.cpp", 'x.h\nint y;\n"z.h"\n')
+# Long lines are matched in pieces of 1023 characters.
+t.write("d.cpp", "/" * 1020 + '#include "d1.h"\n' + "/" * 1023
+    + '#include "d2.h"\n')
+t.write("e.cpp", '\n#include "e1.h"\n')
+
+t.run_build_system(["-ffile.jam"])
+t.expect_output_lines("found: a.cpp : a1.h a2.h a4.h")
+t.expect_output_lines("found: b.cpp : b1.h b2.h b3.h")
+t.expect_output_lines("found: c.cpp : x z")
+t.expect_output_lines("found: d.cpp : d2.h")
+t.expect_output_lines("found: e.cpp : e1.h")
+
+t.cleanup()
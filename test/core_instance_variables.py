@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Tests the variables of class instances that are not fixed variables of the
+# class, i.e. the ones with computed names. These are kept in a short array
+# until there are too many and they are moved to a hash table.
+
+import BoostBuild
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+t.write("jamroot.jam", """\
+import "class" : new ;
+
+class item
+{
+    rule __init__ ( ) { self.fixed = fixed ; }
+    rule set ( name : value * ) { self.$(name) = $(value) ; }
+    rule add ( name : value * ) { self.$(name) += $(value) ; }
+    rule get ( name ) { return $(self.$(name)) ; }
+}
+
+local names = a b c d e f g h i j k l ;
+local o = [ new item ] ;
+local other = [ new item ] ;
+for local n in $(names)
+{
+    $(o).set $(n) : $(n)1 ;
+    $(o).add $(n) : $(n)2 ;
+    $(other).set $(n) : other ;
+    local values ;
+    for local m in $(names)
+    {
+        values += [ $(o).get $(m) ] ;
+    }
+    ECHO $(n) $(values) [ $(other).get $(n) ] ;
+}
+ECHO fixed [ $(o).get fixed ] ;
+local varnames = [ VARNAMES $(o) ] ;
+if self.$(names) in $(varnames)
+{
+    ECHO varnames ;
+}
+""")
+
+t.run_build_system()
+t.expect_output_lines("a a1 a2 other")
+t.expect_output_lines("h a1 a2 b1 b2 c1 c2 d1 d2 e1 e2 f1 f2 g1 g2 h1 h2 other")
+t.expect_output_lines("i a1 a2 b1 b2 c1 c2 d1 d2 e1 e2 f1 f2 g1 g2 h1 h2 i1 i2 "
+    "other")
+t.expect_output_lines("l a1 a2 b1 b2 c1 c2 d1 d2 e1 e2 f1 f2 g1 g2 h1 h2 i1 i2 "
+    "j1 j2 k1 k2 l1 l2 other")
+t.expect_output_lines("fixed fixed")
+t.expect_output_lines("varnames")
+
+t.cleanup()
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test loading the compiled Jamfiles cached with "--jam-cache".
+
+import BoostBuild
+import os
+
+t = BoostBuild.Tester(["-ffile.jam", "-d1", "--jam-cache"], pass_toolset=0)
+
+t.write("file.jam", """\
+rule greet ( who + : how ? )
+{
+    local message = $(how:E=hello) $(who) ;
+    return $(message:J=" ") ;
+}
+
+actions echo
+{
+    echo $(<:B) made
+}
+
+include inc.jam ;
+ECHO [ greet world ] ;
+ECHO [ greet you : bye ] ;
+NOTFILE all ;
+ALWAYS all ;
+echo all ;
+""")
+t.write("inc.jam", """\
+ECHO included ;
+""")
+
+# The compiled files are written next to them.
+t.run_build_system()
+t.expect_addition("file.jam.b2c")
+t.expect_addition("inc.jam.b2c")
+t.expect_output_lines("included")
+t.expect_output_lines("hello world")
+t.expect_output_lines("bye you")
+t.expect_output_lines("all made")
+
+# Same results when loading the compiled files.
+t.run_build_system()
+t.expect_output_lines("included")
+t.expect_output_lines("hello world")
+t.expect_output_lines("bye you")
+t.expect_output_lines("all made")
+
+
+def rewrite_keeping_time(name, content):
+    times = os.stat(name)
+    with open(name, "w") as f:
+        f.write(content)
+    os.utime(name, ns=(times.st_atime_ns, times.st_mtime_ns))
+
+
+# With the same modification time the compiled file is used.
+rewrite_keeping_time("inc.jam", "ECHO changed ;\n")
+t.run_build_system()
+t.expect_output_lines("included")
+t.expect_output_lines("changed", False)
+
+# A changed file is parsed again.
+t.touch("inc.jam")
+t.run_build_system()
+t.expect_output_lines("included", False)
+t.expect_output_lines("changed")
+
+t.cleanup()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that "--critical-path" runs the longest chain of actions first.
+
+import BoostBuild
+
+t = BoostBuild.Tester(["-d1", "-j1"], pass_toolset=0)
+
+t.write("file.jam", """\
+actions go
+{
+    echo running $(<)
+}
+
+NOTFILE all short1 short2 long1 long2 long3 ;
+ALWAYS short1 short2 long1 long2 long3 ;
+go short1 ;
+go short2 ;
+go long1 ;
+go long2 ;
+go long3 ;
+DEPENDS long3 : long2 ;
+DEPENDS long2 : long1 ;
+DEPENDS all : short1 short2 long3 ;
+""")
+
+# By default the actions run in dependency order.
+t.run_build_system(["-ffile.jam"], stdout="""\
+...found 6 targets...
+...updating 5 targets...
+go short1
+running short1
+go short2
+running short2
+go long1
+running long1
+go long2
+running long2
+go long3
+running long3
+
+...updated 5 targets...
+""")
+
+# The chain starts first, and continues as long as it is the longest path.
+t.run_build_system(["-ffile.jam", "--critical-path"], stdout="""\
+...found 6 targets...
+...updating 5 targets...
+go long1
+running long1
+go long2
+running long2
+go short1
+running short1
+go short2
+running short2
+go long3
+running long3
+
+...updated 5 targets...
+""")
+
+t.cleanup()
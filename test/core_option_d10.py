@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that "-d+10" profiles the rules, and the instructions, that run. And
+# that the results are the same as without profiling.
+
+import BoostBuild
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+t.write("file.jam", """\
+rule count ( n * )
+{
+    local result ;
+    for local i in $(n)
+    {
+        if $(i) != 2 { result += $(i) ; }
+    }
+    return $(result) ;
+}
+
+ECHO counted [ count 1 2 3 ] ;
+NOTFILE all ;
+""")
+
+t.run_build_system(["-ffile.jam", "-d0"])
+t.expect_output_lines("counted 1 3")
+
+t.run_build_system(["-ffile.jam", "-d0", "-d+10"])
+t.expect_output_lines("counted 1 3")
+t.expect_output_lines("* count")
+t.expect_output_lines("* function_run_INSTR_FOR_LOOP")
+t.expect_output_lines("* function_run_INSTR_CALL_RULE")
+
+t.cleanup()
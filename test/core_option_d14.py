@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that "-d+14" shows the code of the rules before and after optimizing it.
+# And that the optimized code gives the same results.
+
+import BoostBuild
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+t.write("file.jam", """\
+rule first ( n * )
+{
+    for local i in $(n)
+    {
+        if $(i) = 2 { return found $(i) ; }
+    }
+    return ;
+}
+
+rule kind ( x )
+{
+    switch $(x)
+    {
+        case a* : return letter ;
+        case 1* : return number ;
+    }
+    return other ;
+}
+
+rule list ( )
+{
+    local l = a b c ;
+    local e = ;
+    return $(l) one "two" three $(e) x y z ;
+}
+
+rule count ( n )
+{
+    local result ;
+    while $(n) != 0
+    {
+        result += $(n) ;
+        n = [ MATCH ^.(.*)$ : $(n) ] ;
+        if ! $(n) { break ; }
+    }
+    return $(result) ;
+}
+
+local g = <a>1 <b>2 ;
+ECHO first [ first 1 2 3 ] - [ first 4 ] - ;
+ECHO kind [ kind abc ] [ kind 12 ] [ kind - ] ;
+ECHO list [ list ] ;
+ECHO grist $(g:G) ;
+ECHO joined "a" "b"c"d" ;
+ECHO count [ count 1230 ] ;
+NOTFILE all ;
+""")
+
+output = """\
+first found 2 - -
+kind letter number other
+list a b c one two three x y z
+grist <a> <b>
+joined a bcd
+count 1230 230 30
+"""
+
+t.run_build_system(["-ffile.jam", "-d0"], stdout=output)
+
+t.run_build_system(["-ffile.jam", "-d0", "-d+14"])
+t.expect_output_lines(output.splitlines())
+t.expect_output_lines("compiled: file.jam:*")
+t.expect_output_lines("optimized: file.jam:*")
+t.expect_output_lines("* PUSH_CONSTANTS *3")
+t.expect_output_lines("* PUSH_VAR_GRIST *\"g\"")
+
+t.cleanup()
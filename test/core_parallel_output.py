@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test collecting large outputs of parallel actions.
+
+import BoostBuild
+import sys
+
+t = BoostBuild.Tester(["-d1"], pass_toolset=False)
+
+t.write("file.jam", """\
+actions print
+{{
+    "{}" -c "import sys; sys.stdout.write(''.join('$(<) line %d\\\\n' % i for i in range(5000)))"
+}}
+
+rule print
+{{
+    NOTFILE $(<) ;
+    ALWAYS $(<) ;
+    DEPENDS all : $(<) ;
+}}
+
+print a ;
+print b ;
+print c ;
+print d ;
+print e ;
+print f ;
+""".format(sys.executable))
+
+t.run_build_system(["-ffile.jam", "-j4"])
+for target in "abcdef":
+    t.expect_output_lines("%s line 0" % target)
+    t.expect_output_lines("%s line 2500" % target)
+    t.expect_output_lines("%s line 4999" % target)
+t.expect_output_lines("...updated 6 targets...")
+
+t.cleanup()
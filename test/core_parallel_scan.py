@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that header scanning ahead, in parallel, gives the same HDRRULE calls,
+# in the same order, as scanning one file at a time.
+
+import BoostBuild
+
+t = BoostBuild.Tester(["-d0"], pass_toolset=0)
+
+t.write("file.jam", """\
+rule hdrrule ( target : headers * : * )
+{
+    local h = <h>$(headers) ;
+    ECHO "found:" $(target) ":" $(h) ;
+    SEARCH on $(h) = . ;
+    HDRSCAN on $(h) = "#include \\"([^\\"]*)\\"" ;
+    HDRRULE on $(h) = hdrrule ;
+    NOCARE $(h) ;
+    INCLUDES $(target) : $(h) ;
+}
+
+for local s in [ GLOB . : s*.c ]
+{
+    HDRSCAN on $(s:D=) = "#include \\"([^\\"]*)\\"" ;
+    HDRRULE on $(s:D=) = hdrrule ;
+    SEARCH on $(s:D=) = . ;
+    NOTFILE o$(s:D=) ;
+    DEPENDS o$(s:D=) : $(s:D=) ;
+    DEPENDS all : o$(s:D=) ;
+}
+""")
+
+for i in range(20):
+    t.write("s%02d.c" % i, "".join(
+        '#include "h%d.h"\n' % ((i + j) % 10) for j in range(3)))
+for i in range(10):
+    t.write("h%d.h" % i, '#include "h%d.h"\n' % ((i + 1) % 10))
+
+t.run_build_system(["-ffile.jam", "-j1"])
+serial = t.stdout()
+t.expect_output_lines("found: s00.c : <h>h0.h <h>h1.h <h>h2.h")
+t.expect_output_lines("found: s19.c : <h>h9.h <h>h0.h <h>h1.h")
+t.expect_output_lines("found: <h>h9.h : <h>h0.h")
+
+t.run_build_system(["-ffile.jam", "-j4"], stdout=serial)
+
+t.cleanup()
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that rule calls find the current rules after the rules they found before
+# get hidden, imported, or deleted. The calls cache the rules they find.
+
+import BoostBuild
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+t.write("file.jam", """\
+rule which ( ) { return global ; }
+rule util.which ( ) { return global-util ; }
+rule other ( ) { return other ; }
+
+module m
+{
+    rule call ( ) { return [ which ] [ util.which ] ; }
+    EXPORT m : call ;
+}
+IMPORT_MODULE m ;
+
+module util
+{
+    rule which ( ) { return util ; }
+}
+
+rule call-all ( )
+{
+    local result ;
+    for local i in 1 2
+    {
+        result += [ m.call ] ;
+    }
+    return $(result) ;
+}
+
+ECHO 1 [ call-all ] ;
+
+# A rule in the module hides the global one.
+module m
+{
+    rule which ( ) { return local ; }
+}
+ECHO 2 [ call-all ] ;
+
+# Importing replaces the rule.
+IMPORT : other : m : which ;
+ECHO 3 [ call-all ] ;
+
+# Importing a module makes its rules visible with the module name.
+module util { EXPORT util : which ; }
+IMPORT_MODULE util : m ;
+ECHO 4 [ call-all ] ;
+
+# Deleted modules have no rules.
+DELETE_MODULE util ;
+module util
+{
+    rule which ( ) { return new-util ; }
+}
+ECHO 5 [ call-all ] ;
+
+NOTFILE all ;
+""")
+
+t.run_build_system(["-ffile.jam", "-d0"], stdout="""\
+1 global global-util global global-util
+2 local global-util local global-util
+3 other global-util other global-util
+4 other util other util
+5 other new-util other new-util
+""")
+
+# Member rule calls run in their own instance, with the rules of their class.
+t.write("jamroot.jam", """\
+import "class" : new ;
+
+class base
+{
+    rule __init__ ( name ) { self.name = $(name) ; }
+    rule name ( ) { return $(self.name) ; }
+    rule kind ( ) { return base ; }
+    rule describe ( ) { return [ name ] [ kind ] ; }
+    rule next ( n ? ) { self.next = $(n) ; }
+    # Calls the same rule of another instance of the class.
+    rule chain ( )
+    {
+        local result = [ name ] ;
+        if $(self.next)
+        {
+            result += [ $(self.next).chain ] ;
+        }
+        return $(result) ;
+    }
+}
+
+class derived : base
+{
+    rule kind ( ) { return derived ; }
+}
+
+local result ;
+for local o in [ new base a ] [ new derived b ] [ new base c ]
+{
+    result += [ $(o).describe ] ;
+}
+ECHO $(result) ;
+
+local x = [ new base x ] ;
+local y = [ new base y ] ;
+local z = [ new base z ] ;
+$(x).next $(y) ;
+$(y).next $(z) ;
+# The rule name names the instance to run in.
+local chain = $(x).chain ;
+for local i in 1 2
+{
+    ECHO chain $(i) [ $(chain) ] [ $(y).chain ] ;
+}
+""")
+
+t.run_build_system()
+t.expect_output_lines("a base b derived c base")
+t.expect_output_lines("chain 1 x y z y z")
+t.expect_output_lines("chain 2 x y z y z")
+
+t.cleanup()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test that the targets bind to the same paths when the paths they may bind to
+# are queried in parallel, with "-j2", as when they are not, with "-j1".
+
+import BoostBuild
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+t.write("d2/a.h", "")
+t.write("d3/a.h", "")
+t.write("d3/b.h", "")
+t.write("build/made.txt", "")
+t.write("plain.txt", "")
+
+t.write("file.jam", """\
+# Found in the second, and not the third, of the roots.
+SEARCH on a.h = d1 d2 d3 ;
+# Found in the last of the roots.
+SEARCH on b.h = d1 d2 d3 ;
+# Not found in any of the roots.
+SEARCH on c.h = d1 d2 d3 ;
+# Found as the explicitly located target, that does not exist.
+LOCATE on <gen>d.h = gen ;
+SEARCH on d.h = d1 gen ;
+# Located, existing or not.
+LOCATE on made.txt = build ;
+LOCATE on missing.txt = build ;
+
+# The plain.txt, and nowhere.txt, targets are neither searched nor located.
+NOTFILE all ;
+DEPENDS all : a.h b.h c.h <gen>d.h d.h made.txt missing.txt plain.txt
+    nowhere.txt ;
+NOCARE c.h <gen>d.h d.h missing.txt nowhere.txt ;
+
+BINDRULE = bind-rule ;
+
+rule bind-rule ( target : path )
+{
+    ECHO "found:" $(target) at $(path:T) ;
+}
+""")
+
+expected = """\
+found: a.h at d2/a.h
+found: b.h at d3/b.h
+found: c.h at c.h
+found: <gen>d.h at gen/d.h
+found: d.h at gen/d.h
+found: made.txt at build/made.txt
+found: missing.txt at build/missing.txt
+found: plain.txt at plain.txt
+found: nowhere.txt at nowhere.txt
+...found 10 targets...
+"""
+
+t.run_build_system(["-ffile.jam", "-j1"], stdout=expected)
+t.run_build_system(["-ffile.jam", "-j2"], stdout=expected)
+
+t.cleanup()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test reusing the output of SHELL commands with "--shell-cache".
+
+import BoostBuild
+import os
+import sys
+
+t = BoostBuild.Tester(pass_toolset=0)
+
+if sys.platform == "win32":
+    t.cleanup()
+    sys.exit(0)
+
+
+def write_probe(output):
+    t.write("probe.sh", """\
+#!/bin/sh
+echo run >> runs.txt
+echo "%s"
+""" % output)
+    os.chmod(t.native_file_name("probe.sh"), 0o755)
+
+
+def runs():
+    return len(t.read("runs.txt").splitlines())
+
+
+write_probe("probe one")
+t.write("jamroot.jam", """\
+ECHO "cached:" [ SHELL "./probe.sh" : strip-eol : cache ] ;
+ECHO "not cached:" [ SHELL "./probe.sh" : strip-eol ] ;
+ECHO "not cacheable:" [ SHELL "X=1 ./probe.sh" : strip-eol : cache ] ;
+EXIT : 0 ;
+""")
+
+# The first run records the output of the cached command.
+t.run_build_system(["--shell-cache=shell.db"])
+t.expect_output_lines("cached: probe one")
+t.expect_output_lines("not cached: probe one")
+t.expect_output_lines("not cacheable: probe one")
+t.expect_content_lines("shell.db", "b2-shell-cache-1")
+t.fail_test(runs() != 3)
+
+# And later runs reuse it.
+t.run_build_system(["--shell-cache=shell.db"])
+t.expect_output_lines("cached: probe one")
+t.fail_test(runs() != 5)
+
+# Without the option the command runs.
+t.run_build_system()
+t.expect_output_lines("cached: probe one")
+t.fail_test(runs() != 8)
+
+# Changing the program runs the command again.
+write_probe("probe two, changed")
+t.run_build_system(["--shell-cache=shell.db"])
+t.expect_output_lines("cached: probe two, changed")
+t.fail_test(runs() != 11)
+t.run_build_system(["--shell-cache=shell.db"])
+t.expect_output_lines("cached: probe two, changed")
+t.fail_test(runs() != 13)
+
+# As does changing the environment that the compilers, and interpreters, the
+# toolsets probe read. While the records of the other environment remain.
+for name in ("GCC_EXEC_PREFIX", "PYTHONPATH"):
+    t.write("runs.txt", "")
+    os.environ[name] = "/changed"
+    t.run_build_system(["--shell-cache=shell.db"])
+    t.fail_test(runs() != 3)
+    t.run_build_system(["--shell-cache=shell.db"])
+    t.fail_test(runs() != 5)
+    del os.environ[name]
+    t.run_build_system(["--shell-cache=shell.db"])
+    t.expect_output_lines("cached: probe two, changed")
+    t.fail_test(runs() != 7)
+
+t.cleanup()
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+# Copyright 2026 René Ferdinand Rivera Morell
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE.txt or https://www.bfgroup.xyz/b2/LICENSE.txt)
+
+# Test recording action times with "--timing-db", and their use.
+
+import BoostBuild
+import sys
+
+t = BoostBuild.Tester(["-d1", "-j1"], pass_toolset=0)
+
+t.write("file.jam", """\
+actions go
+{
+    echo running $(<)
+}
+
+actions slow
+{
+    "%s" -c "import time; time.sleep(0.5)"
+    echo running $(<)
+}
+
+NOTFILE all short1 short2 long1 long2 long3 ;
+ALWAYS short1 short2 long1 long2 long3 ;
+slow short1 ;
+go short2 ;
+go long1 ;
+go long2 ;
+go long3 ;
+DEPENDS long3 : long2 ;
+DEPENDS long2 : long1 ;
+DEPENDS all : short1 short2 long3 ;
+""" % sys.executable)
+
+# The times of the actions are recorded.
+t.run_build_system(["-ffile.jam", "--timing-db=times.db"])
+t.expect_addition("times.db")
+t.expect_content_lines("times.db", "b2-timing-db-1")
+t.expect_content_lines("times.db", "*\tslow\tshort1")
+t.expect_content_lines("times.db", "*\tgo\tlong3")
+
+# The slow action is now the longest path.
+t.run_build_system(["-ffile.jam", "--timing-db=times.db", "--critical-path"])
+t.expect_output_lines("running short1")
+t.fail_test(t.stdout().find("running short1") > t.stdout().find("running long1"))
+
+# The times are available to Jam code.
+t.write("jamroot.jam", """\
+import timing-db ;
+ECHO "short1:" [ timing-db.get slow : short1 ] ;
+ECHO "none:" [ timing-db.get slow : none ] ;
+EXIT : 0 ;
+""")
+t.run_build_system(["--timing-db=times.db"])
+t.expect_output_lines("short1: * * *")
+t.expect_output_lines("none:")
+wall = float(t.stdout().split("short1: ")[1].split()[0])
+t.fail_test(wall < 0.5)
+
+t.cleanup()
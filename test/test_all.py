@@ -355,6 +355,8 @@ tests = [
     "configuration",
     "configure",
     "copy_time",
+    "core_action_cache",
+    "core_action_exec",
     "core_action_output",
     "core_action_status",
     "core_actions_quietly",
@@ -363,10 +365,18 @@ tests = [
     "core_cmd_line",
     "core_dependencies",
     "core_fail_expected",
+    "core_graph_snapshot",
+    "core_hcache",
+    "core_hdrscan",
+    "core_instance_variables",
+    "core_jam_cache",
     "core_jamshell",
     "core_modifiers",
     "core_multifile_actions",
     "core_nt_cmd_line",
+    "core_option_critical_path",
+    "core_option_d10",
+    "core_option_d14",
     "core_option_d2",
     "core_option_durations",
     "core_option_l",
@@ -375,9 +385,15 @@ tests = [
     "core_parallel_actions",
     "core_parallel_multifile_actions_1",
     "core_parallel_multifile_actions_2",
+    "core_parallel_output",
+    "core_parallel_scan",
+    "core_rule_cache",
     "core_scanner",
+    "core_search_prefetch",
+    "core_shell_cache",
     "core_source_line_tracking",
     "core_syntax_error_exit_status",
+    "core_timing_db",
     "core_update_now",
     "core_variables_in_actions",
     "custom_generator",